@@ -17,21 +17,40 @@ enum
     FLASH_STATUS_ERROR = 2,
     FLASH_STATUS_TIMEOUT = 3,
     FLASH_STATUS_INVALID_CMD = 4,
+    FLASH_STATUS_CACHE_READY = 5,
+    FLASH_STATUS_CACHE_ERROR = 6,
 };
 
+typedef int (*flash_page_cb_t)(uint8_t *buf, uint32_t page, uint32_t status,
+    void *ctx);
+
 typedef struct
 {
-    int (*init)(void *conf, uint32_t conf_size);
+    int (*init)(void *conf, uint32_t conf_size, chip_info_t *chip_info);
     void (*uninit)();
     void (*read_id)(chip_id_t *chip_id);
     uint32_t (*erase_block)(uint32_t page);
+    void (*erase_block_async)(uint32_t page);
+    uint32_t (*erase_block_mp_async)(uint32_t page, uint32_t plane_page);
     uint32_t (*read_page)(uint8_t *buf, uint32_t page, uint32_t page_size);
     uint32_t (*read_spare_data)(uint8_t *buf, uint32_t page, uint32_t offset,
         uint32_t data_size);
+    uint32_t (*read_data)(uint8_t *buf, uint32_t page, uint32_t page_offset,
+        uint32_t data_size);
+    int (*read_pages)(uint8_t *buf, uint32_t page, uint32_t count,
+        uint32_t page_size, flash_page_cb_t cb, void *ctx);
     void (*write_page_async)(uint8_t *buf, uint32_t page, uint32_t page_size);
+    uint32_t (*write_page_cache_async)(uint8_t *buf, uint32_t page,
+        uint32_t page_size);
+    uint32_t (*write_page_plane_async)(uint8_t *buf, uint32_t page,
+        uint32_t page_size);
     uint32_t (*read_status)();
+    uint32_t (*read_status_lun)(uint32_t page);
+    uint32_t (*lun_count)();
     bool (*is_bb_supported)();
     uint32_t (*enable_hw_ecc)(bool enable);
+    int (*ecc_calc_enable)(bool enable, uint32_t size);
+    uint32_t (*ecc_calc_get)();
 } flash_hal_t;
 
 #endif /* _FLASH_HAL_H_ */
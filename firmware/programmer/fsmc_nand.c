@@ -14,6 +14,8 @@
 
 /* NAND memory status */  
 #define NAND_ERROR                 ((uint32_t)0x00000001)
+#define NAND_CACHE_ERROR           ((uint32_t)0x00000002)
+#define NAND_ARRAY_READY           ((uint32_t)0x00000020)
 #define NAND_READY                 ((uint32_t)0x00000040)
 
 /* FSMC NAND memory address computation */
@@ -34,6 +36,8 @@
 
 #define UNDEFINED_CMD 0xFF
 
+#define NAND_ECC_BYTES 4
+
 typedef struct __attribute__((__packed__))
 {
     uint8_t setup_time;
@@ -58,9 +62,23 @@ typedef struct __attribute__((__packed__))
     uint8_t enable_ecc_addr;
     uint8_t enable_ecc_value;
     uint8_t disable_ecc_value;
+    uint8_t read_cache_seq_cmd;
+    uint8_t read_cache_end_cmd;
+    uint8_t write_cache_cmd;
+    uint8_t planes;
+    uint8_t erase_mp_cmd;
+    uint8_t luns;
+    uint8_t status_enh_cmd;
+    uint8_t ecc_spare_off;
+    uint8_t write_mp_cmd;
 } fsmc_conf_t;
 
 static fsmc_conf_t fsmc_conf;
+static bool nand_cache_prog;
+static bool nand_cache_err;
+static bool nand_ecc_calc;
+static uint32_t nand_ecc_size;
+static uint32_t nand_ecc;
 
 static void nand_gpio_init(void)
 {
@@ -140,10 +158,21 @@ static void nand_print_fsmc_info()
     DEBUG_PRINT("Erase 1 command: %d\r\n", fsmc_conf.erase1_cmd);
     DEBUG_PRINT("Erase 2 command: %d\r\n", fsmc_conf.erase2_cmd);
     DEBUG_PRINT("Status command: %d\r\n", fsmc_conf.status_cmd);
-    DEBUG_PRINT("Set feature command: %d\r\n", fsmc_conf.set_feature_cmd);
+    DEBUG_PRINT("Set feature command: %d\r\n", fsmc_conf.set_features_cmd);
     DEBUG_PRINT("Enable ECC address: %d\r\n", fsmc_conf.enable_ecc_addr);
     DEBUG_PRINT("Enable ECC value: %d\r\n", fsmc_conf.enable_ecc_value);
     DEBUG_PRINT("Disable ECC value: %d\r\n", fsmc_conf.disable_ecc_value);
+    DEBUG_PRINT("Read cache sequential command: %d\r\n",
+        fsmc_conf.read_cache_seq_cmd);
+    DEBUG_PRINT("Read cache end command: %d\r\n",
+        fsmc_conf.read_cache_end_cmd);
+    DEBUG_PRINT("Write cache command: %d\r\n", fsmc_conf.write_cache_cmd);
+    DEBUG_PRINT("Planes: %d\r\n", fsmc_conf.planes);
+    DEBUG_PRINT("Multi-plane erase command: %d\r\n", fsmc_conf.erase_mp_cmd);
+    DEBUG_PRINT("LUNs: %d\r\n", fsmc_conf.luns);
+    DEBUG_PRINT("Status enhanced command: %d\r\n", fsmc_conf.status_enh_cmd);
+    DEBUG_PRINT("ECC spare offset: %d\r\n", fsmc_conf.ecc_spare_off);
+    DEBUG_PRINT("Multi-plane write command: %d\r\n", fsmc_conf.write_mp_cmd);
 }
 
 static void nand_reset()
@@ -151,12 +180,23 @@ static void nand_reset()
     *(__IO uint8_t *)(Bank_NAND_ADDR | CMD_AREA) = fsmc_conf.reset_cmd;
 }
 
-static int nand_init(void *conf, uint32_t conf_size)
+static int nand_init(void *conf, uint32_t conf_size, chip_info_t *chip_info)
 {
+    fsmc_conf_t *new_conf = (fsmc_conf_t *)conf;
+
     if (conf_size < sizeof(fsmc_conf_t))
         return -1;
-   
-    fsmc_conf = *(fsmc_conf_t *)conf;
+
+    /* ECC is written at its offset in the spare area after the page data */
+    if (new_conf->ecc_spare_off != UNDEFINED_CMD &&
+        new_conf->ecc_spare_off + NAND_ECC_BYTES > chip_info->spare_size)
+    {
+        ERROR_PRINT("ECC spare offset %d is out of spare area size %lu\r\n",
+            new_conf->ecc_spare_off, chip_info->spare_size);
+        return -1;
+    }
+
+    fsmc_conf = *new_conf;
 
     nand_gpio_init();
     nand_fsmc_init(fsmc_conf);
@@ -171,21 +211,44 @@ static void nand_uninit()
     //TODO
 }
 
+static uint32_t nand_status_decode(uint32_t data)
+{
+    if ((data & NAND_READY) != NAND_READY)
+        return FLASH_STATUS_BUSY;
+
+    /* During cache program ready bit is set as soon as cache register is
+     * free while array can be still busy. Failure of the page programmed
+     * before the last one is reported by separate bit once, failure of the
+     * last page is valid only when array is ready.
+     */
+    if (nand_cache_prog)
+    {
+        if ((data & NAND_CACHE_ERROR) == NAND_CACHE_ERROR && !nand_cache_err)
+        {
+            nand_cache_err = true;
+            return FLASH_STATUS_CACHE_ERROR;
+        }
+
+        if ((data & NAND_ARRAY_READY) != NAND_ARRAY_READY)
+            return FLASH_STATUS_CACHE_READY;
+
+        nand_cache_prog = false;
+    }
+
+    if ((data & NAND_ERROR) == NAND_ERROR)
+        return FLASH_STATUS_ERROR;
+
+    return FLASH_STATUS_READY;
+}
+
 static uint32_t nand_read_status()
 {
-    uint32_t data, status;
+    uint32_t data;
 
     *(__IO uint8_t *)(Bank_NAND_ADDR | CMD_AREA) = fsmc_conf.status_cmd;
     data = *(__IO uint8_t *)(Bank_NAND_ADDR);
 
-    if ((data & NAND_ERROR) == NAND_ERROR)
-        status = FLASH_STATUS_ERROR;
-    else if ((data & NAND_READY) == NAND_READY)
-        status = FLASH_STATUS_READY;
-    else
-        status = FLASH_STATUS_BUSY;
-
-    return status;
+    return nand_status_decode(data);
 }
 
 static uint32_t nand_get_status()
@@ -207,84 +270,224 @@ static uint32_t nand_get_status()
     return status;
 }
 
-static void nand_read_id(chip_id_t *nand_id)
+static void nand_write_col_addr(uint32_t col)
 {
-    uint32_t data = 0;
-
-    *(__IO uint8_t *)(Bank_NAND_ADDR | CMD_AREA) = fsmc_conf.read_id_cmd;
-    *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = 0x00;
-
-    /* Sequence to read ID from NAND flash */
-    data = *(__IO uint32_t *)(Bank_NAND_ADDR | DATA_AREA);
-    nand_id->maker_id   = ADDR_1st_CYCLE(data);
-    nand_id->device_id  = ADDR_2nd_CYCLE(data);
-    nand_id->third_id   = ADDR_3rd_CYCLE(data);
-    nand_id->fourth_id  = ADDR_4th_CYCLE(data);
-
-    data = *((__IO uint32_t *)(Bank_NAND_ADDR | DATA_AREA) + 1);
-    nand_id->fifth_id   = ADDR_1st_CYCLE(data);
-}
-
-static void nand_write_page_async(uint8_t *buf, uint32_t page,
-    uint32_t page_size)
-{
-    uint32_t i;
-
-    *(__IO uint8_t *)(Bank_NAND_ADDR | CMD_AREA) = fsmc_conf.write1_cmd;
-
     switch (fsmc_conf.col_cycles)
     {
     case 1:
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = 0x00;
+        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_1st_CYCLE(col);
         break;
     case 2:
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = 0x00;
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = 0x00;
+        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_1st_CYCLE(col);
+        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_2nd_CYCLE(col);
         break;
     case 3:
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = 0x00;
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = 0x00;
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = 0x00;
+        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_1st_CYCLE(col);
+        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_2nd_CYCLE(col);
+        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_3rd_CYCLE(col);
         break;
     case 4:
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = 0x00;
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = 0x00;
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = 0x00;
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = 0x00;
+        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_1st_CYCLE(col);
+        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_2nd_CYCLE(col);
+        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_3rd_CYCLE(col);
+        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_4th_CYCLE(col);
         break;
     default:
         break;
     }
+}
 
+static void nand_write_row_addr(uint32_t row)
+{
     switch (fsmc_conf.row_cycles)
     {
     case 1:
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_1st_CYCLE(page);
+        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_1st_CYCLE(row);
         break;
     case 2:
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_1st_CYCLE(page);
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_2nd_CYCLE(page);
+        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_1st_CYCLE(row);
+        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_2nd_CYCLE(row);
         break;
     case 3:
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_1st_CYCLE(page);
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_2nd_CYCLE(page);
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_3rd_CYCLE(page);
+        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_1st_CYCLE(row);
+        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_2nd_CYCLE(row);
+        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_3rd_CYCLE(row);
         break;
     case 4:
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_1st_CYCLE(page);
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_2nd_CYCLE(page);
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_3rd_CYCLE(page);
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_4th_CYCLE(page);
+        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_1st_CYCLE(row);
+        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_2nd_CYCLE(row);
+        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_3rd_CYCLE(row);
+        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_4th_CYCLE(row);
         break;
     default:
         break;
     }
+}
+
+/* Status of LUN the page belongs to */
+static uint32_t nand_read_status_lun(uint32_t page)
+{
+    uint32_t data;
+
+    if (fsmc_conf.status_enh_cmd == UNDEFINED_CMD)
+        return nand_read_status();
+
+    *(__IO uint8_t *)(Bank_NAND_ADDR | CMD_AREA) = fsmc_conf.status_enh_cmd;
+    nand_write_row_addr(page);
+    data = *(__IO uint8_t *)(Bank_NAND_ADDR);
+
+    return nand_status_decode(data);
+}
+
+static uint32_t nand_lun_count()
+{
+    /* Independent LUNs can't be polled without status enhanced command */
+    if (fsmc_conf.luns == UNDEFINED_CMD || fsmc_conf.luns < 2 ||
+        fsmc_conf.status_enh_cmd == UNDEFINED_CMD)
+    {
+        return 1;
+    }
+
+    return fsmc_conf.luns;
+}
+
+/* FSMC computes ECC over the first nand_ecc_size bytes of data transfer
+ * after it is enabled.
+ */
+static void nand_ecc_reset()
+{
+    if (!nand_ecc_calc)
+        return;
+
+    FSMC_NANDECCCmd(FSMC_Bank2_NAND, DISABLE);
+    FSMC_NANDECCCmd(FSMC_Bank2_NAND, ENABLE);
+}
+
+static void nand_ecc_latch()
+{
+    if (!nand_ecc_calc)
+        return;
+
+    while (FSMC_GetFlagStatus(FSMC_Bank2_NAND, FSMC_FLAG_FEMPT) == RESET);
+    nand_ecc = FSMC_GetECC(FSMC_Bank2_NAND);
+}
+
+static void nand_read_id(chip_id_t *nand_id)
+{
+    uint32_t data = 0;
+
+    *(__IO uint8_t *)(Bank_NAND_ADDR | CMD_AREA) = fsmc_conf.read_id_cmd;
+    *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = 0x00;
+
+    /* Sequence to read ID from NAND flash */
+    data = *(__IO uint32_t *)(Bank_NAND_ADDR | DATA_AREA);
+    nand_id->maker_id   = ADDR_1st_CYCLE(data);
+    nand_id->device_id  = ADDR_2nd_CYCLE(data);
+    nand_id->third_id   = ADDR_3rd_CYCLE(data);
+    nand_id->fourth_id  = ADDR_4th_CYCLE(data);
+
+    data = *((__IO uint32_t *)(Bank_NAND_ADDR | DATA_AREA) + 1);
+    nand_id->fifth_id   = ADDR_1st_CYCLE(data);
+}
+
+/* ECC is written to the spare area, data is padded with 0xFF if spare area
+ * is not included to the page.
+ */
+static void nand_write_data_ecc(uint8_t *buf, uint32_t size)
+{
+    uint32_t i, ecc_pos = nand_ecc_size + fsmc_conf.ecc_spare_off;
+
+    for (i = 0; i < nand_ecc_size; i++)
+        *(__IO uint8_t *)(Bank_NAND_ADDR | DATA_AREA) = buf[i];
+
+    nand_ecc_latch();
+
+    for (; i < ecc_pos; i++)
+    {
+        *(__IO uint8_t *)(Bank_NAND_ADDR | DATA_AREA) = i < size ? buf[i] :
+            0xFF;
+    }
+
+    for (; i < ecc_pos + NAND_ECC_BYTES; i++)
+    {
+        *(__IO uint8_t *)(Bank_NAND_ADDR | DATA_AREA) =
+            (uint8_t)(nand_ecc >> ((i - ecc_pos) * 8));
+    }
+
+    for (; i < size; i++)
+        *(__IO uint8_t *)(Bank_NAND_ADDR | DATA_AREA) = buf[i];
+}
+
+static void nand_write_page_data(uint8_t *buf, uint32_t page,
+    uint32_t page_size)
+{
+    uint32_t i;
+
+    *(__IO uint8_t *)(Bank_NAND_ADDR | CMD_AREA) = fsmc_conf.write1_cmd;
+    nand_write_col_addr(0);
+    nand_write_row_addr(page);
+
+    nand_ecc_reset();
+
+    if (nand_ecc_calc && fsmc_conf.ecc_spare_off != UNDEFINED_CMD &&
+        page_size >= nand_ecc_size)
+    {
+        nand_write_data_ecc(buf, page_size);
+        return;
+    }
 
     for(i = 0; i < page_size; i++)
         *(__IO uint8_t *)(Bank_NAND_ADDR | DATA_AREA) = buf[i];
 
+    nand_ecc_latch();
+}
+
+static void nand_write_page_async(uint8_t *buf, uint32_t page,
+    uint32_t page_size)
+{
+    nand_write_page_data(buf, page, page_size);
+
     if (fsmc_conf.write2_cmd != UNDEFINED_CMD)
         *(__IO uint8_t *)(Bank_NAND_ADDR | CMD_AREA) = fsmc_conf.write2_cmd;
+    nand_cache_err = false;
+}
+
+/* Next page can be loaded as soon as status reports cache register is free.
+ * Last page of the sequence should be written with nand_write_page_async().
+ */
+/* Load page of the first plane for multi-plane program. It is programmed
+ * together with the page of other plane loaded next by regular program.
+ */
+static uint32_t nand_write_page_plane_async(uint8_t *buf, uint32_t page,
+    uint32_t page_size)
+{
+    if (fsmc_conf.planes == UNDEFINED_CMD || fsmc_conf.planes < 2 ||
+        fsmc_conf.write_mp_cmd == UNDEFINED_CMD)
+    {
+        return FLASH_STATUS_INVALID_CMD;
+    }
+
+    nand_write_page_data(buf, page, page_size);
+
+    *(__IO uint8_t *)(Bank_NAND_ADDR | CMD_AREA) = fsmc_conf.write_mp_cmd;
+
+    /* Wait tDBSY */
+    return nand_get_status();
+}
+
+static uint32_t nand_write_page_cache_async(uint8_t *buf, uint32_t page,
+    uint32_t page_size)
+{
+    if (fsmc_conf.write_cache_cmd == UNDEFINED_CMD)
+        return FLASH_STATUS_INVALID_CMD;
+
+    nand_write_page_data(buf, page, page_size);
+
+    *(__IO uint8_t *)(Bank_NAND_ADDR | CMD_AREA) = fsmc_conf.write_cache_cmd;
+    nand_cache_prog = true;
+    nand_cache_err = false;
+
+    return FLASH_STATUS_READY;
 }
 
 static uint32_t nand_read_data(uint8_t *buf, uint32_t page,
@@ -354,9 +557,13 @@ static uint32_t nand_read_data(uint8_t *buf, uint32_t page,
     if (fsmc_conf.read2_cmd != UNDEFINED_CMD)
         *(__IO uint8_t *)(Bank_NAND_ADDR | CMD_AREA) = fsmc_conf.read2_cmd;
 
+    nand_ecc_reset();
+
     for (i = 0; i < data_size; i++)
         buf[i] = *(__IO uint8_t *)(Bank_NAND_ADDR | DATA_AREA);
 
+    nand_ecc_latch();
+
     return nand_get_status();
 }
 
@@ -438,38 +645,160 @@ static uint32_t nand_read_spare_data(uint8_t *buf, uint32_t page,
     return nand_get_status();
 }
 
+/* Read run of consecutive pages. Array to cache load of the next page is
+ * overlapped with data output of the current one by READ CACHE SEQUENTIAL
+ * command, last page is read by READ CACHE END command. Callback is called for
+ * each page, non zero return value terminates the run.
+ */
+static int nand_read_pages_by_one(uint8_t *buf, uint32_t page, uint32_t count,
+    uint32_t page_size, flash_page_cb_t cb, void *ctx)
+{
+    uint32_t i, status;
+
+    for (i = 0; i < count; i++)
+    {
+        status = nand_read_page(buf, page + i, page_size);
+        if (cb(buf, page + i, status, ctx))
+            return -1;
+    }
+
+    return 0;
+}
+
+static int nand_read_pages(uint8_t *buf, uint32_t page, uint32_t count,
+    uint32_t page_size, flash_page_cb_t cb, void *ctx)
+{
+    uint32_t i, j, status;
+
+    if (fsmc_conf.read_cache_seq_cmd == UNDEFINED_CMD ||
+        fsmc_conf.read_cache_end_cmd == UNDEFINED_CMD ||
+        fsmc_conf.read2_cmd == UNDEFINED_CMD || count < 2)
+    {
+        return nand_read_pages_by_one(buf, page, count, page_size, cb, ctx);
+    }
+
+    *(__IO uint8_t *)(Bank_NAND_ADDR | CMD_AREA) = fsmc_conf.read1_cmd;
+    nand_write_col_addr(0);
+    nand_write_row_addr(page);
+    *(__IO uint8_t *)(Bank_NAND_ADDR | CMD_AREA) = fsmc_conf.read2_cmd;
+
+    /* Let the per page read report the failure */
+    if (nand_get_status() != FLASH_STATUS_READY)
+        return nand_read_pages_by_one(buf, page, count, page_size, cb, ctx);
+
+    for (i = 0; i < count; i++)
+    {
+        *(__IO uint8_t *)(Bank_NAND_ADDR | CMD_AREA) = i == count - 1 ?
+            fsmc_conf.read_cache_end_cmd : fsmc_conf.read_cache_seq_cmd;
+
+        nand_ecc_reset();
+
+        for (j = 0; j < page_size; j++)
+            buf[j] = *(__IO uint8_t *)(Bank_NAND_ADDR | DATA_AREA);
+
+        nand_ecc_latch();
+
+        status = nand_get_status();
+        if (cb(buf, page + i, status, ctx))
+        {
+            /* Next page is already being loaded to cache */
+            if (i != count - 1)
+            {
+                *(__IO uint8_t *)(Bank_NAND_ADDR | CMD_AREA) =
+                    fsmc_conf.read_cache_end_cmd;
+                nand_get_status();
+            }
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static void nand_erase_block_async(uint32_t page)
+{
+    *(__IO uint8_t *)(Bank_NAND_ADDR | CMD_AREA) = fsmc_conf.erase1_cmd;
+    nand_write_row_addr(page);
+
+    if (fsmc_conf.erase2_cmd != UNDEFINED_CMD)
+        *(__IO uint8_t *)(Bank_NAND_ADDR | CMD_AREA) = fsmc_conf.erase2_cmd;
+}
+
 static uint32_t nand_erase_block(uint32_t page)
 {
+    nand_erase_block_async(page);
+
+    return nand_get_status();
+}
+
+/* Erase blocks from two different planes during single tBERS. Blocks are
+ * selected by caller, plane is defined by block address LSB.
+ */
+static uint32_t nand_erase_block_mp_async(uint32_t page, uint32_t plane_page)
+{
+    uint32_t status;
+
+    if (fsmc_conf.planes == UNDEFINED_CMD || fsmc_conf.planes < 2 ||
+        fsmc_conf.erase_mp_cmd == UNDEFINED_CMD)
+    {
+        return FLASH_STATUS_INVALID_CMD;
+    }
+
     *(__IO uint8_t *)(Bank_NAND_ADDR | CMD_AREA) = fsmc_conf.erase1_cmd;
+    nand_write_row_addr(page);
+    *(__IO uint8_t *)(Bank_NAND_ADDR | CMD_AREA) = fsmc_conf.erase_mp_cmd;
 
-    switch (fsmc_conf.row_cycles)
+    /* Wait tDBSY */
+    if ((status = nand_get_status()) != FLASH_STATUS_READY)
+        return status;
+
+    nand_erase_block_async(plane_page);
+
+    return FLASH_STATUS_READY;
+}
+
+static int nand_ecc_calc_enable(bool enable, uint32_t size)
+{
+    uint32_t ecc_page_size;
+
+    nand_ecc_calc = false;
+    if (!enable)
+        return 0;
+
+    switch (size)
     {
-    case 1:
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_1st_CYCLE(page);
+    case 256:
+        ecc_page_size = FSMC_ECCPageSize_256Bytes;
         break;
-    case 2:
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_1st_CYCLE(page);
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_2nd_CYCLE(page);
+    case 512:
+        ecc_page_size = FSMC_ECCPageSize_512Bytes;
         break;
-    case 3:
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_1st_CYCLE(page);
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_2nd_CYCLE(page);
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_3rd_CYCLE(page);
+    case 1024:
+        ecc_page_size = FSMC_ECCPageSize_1024Bytes;
         break;
-    case 4:
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_1st_CYCLE(page);
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_2nd_CYCLE(page);
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_3rd_CYCLE(page);
-        *(__IO uint8_t *)(Bank_NAND_ADDR | ADDR_AREA) = ADDR_4th_CYCLE(page);
+    case 2048:
+        ecc_page_size = FSMC_ECCPageSize_2048Bytes;
         break;
-    default:
+    case 4096:
+        ecc_page_size = FSMC_ECCPageSize_4096Bytes;
         break;
+    case 8192:
+        ecc_page_size = FSMC_ECCPageSize_8192Bytes;
+        break;
+    default:
+        return -1;
     }
 
-    if (fsmc_conf.erase2_cmd != UNDEFINED_CMD)
-        *(__IO uint8_t *)(Bank_NAND_ADDR | CMD_AREA) = fsmc_conf.erase2_cmd;
+    FSMC_Bank2->PCR2 = (FSMC_Bank2->PCR2 & ~FSMC_PCR2_ECCPS) | ecc_page_size;
+    nand_ecc_size = size;
+    nand_ecc_calc = true;
 
-    return nand_get_status();
+    return 0;
+}
+
+static uint32_t nand_ecc_calc_get()
+{
+    return nand_ecc;
 }
 
 static inline bool nand_is_bb_supported()
@@ -503,11 +832,21 @@ flash_hal_t hal_fsmc =
     .uninit = nand_uninit,
     .read_id = nand_read_id,
     .erase_block = nand_erase_block,
+    .erase_block_async = nand_erase_block_async,
+    .erase_block_mp_async = nand_erase_block_mp_async,
     .read_page = nand_read_page,
     .read_spare_data = nand_read_spare_data,
+    .read_data = nand_read_data,
+    .read_pages = nand_read_pages,
     .write_page_async = nand_write_page_async,
+    .write_page_cache_async = nand_write_page_cache_async,
+    .write_page_plane_async = nand_write_page_plane_async,
     .read_status = nand_read_status,
+    .read_status_lun = nand_read_status_lun,
+    .lun_count = nand_lun_count,
     .is_bb_supported = nand_is_bb_supported,
     .enable_hw_ecc = nand_enable_hw_ecc,
+    .ecc_calc_enable = nand_ecc_calc_enable,
+    .ecc_calc_get = nand_ecc_calc_get,
 };
 
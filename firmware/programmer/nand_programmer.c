@@ -22,6 +22,8 @@
 #define NP_MAX_PAGE_SIZE 0x21C0 /* 8KB + 448 spare */
 #define NP_WRITE_ACK_BYTES 1984
 #define NP_NAND_TIMEOUT 0x1000000
+#define NP_MAX_LUNS 4
+#define NP_MAX_REGIONS 7
 
 #define NP_NAND_GOOD_BLOCK_MARK 0xFF
 
@@ -46,7 +48,11 @@ typedef enum
     NP_CMD_FW_UPDATE_S      = 0x0a,
     NP_CMD_FW_UPDATE_D      = 0x0b,
     NP_CMD_FW_UPDATE_E      = 0x0c,
-    NP_CMD_NAND_LAST        = 0x0d,
+    NP_CMD_NAND_READ_SPARE  = 0x0d,
+    NP_CMD_NAND_REGIONS     = 0x0e,
+    NP_CMD_NAND_BLANK_SCAN  = 0x0f,
+    NP_CMD_NAND_WRITE_SKIP  = 0x10,
+    NP_CMD_NAND_LAST        = 0x11,
 } np_cmd_code_t;
 
 enum
@@ -78,6 +84,10 @@ typedef struct __attribute__((__packed__))
     uint8_t skip_bb : 1;
     uint8_t inc_spare : 1;
     uint8_t enable_hw_ecc: 1;
+    uint8_t erase: 1;
+    uint8_t fsmc_ecc: 1;
+    uint8_t regions: 1;
+    uint8_t planes: 1;
 } np_cmd_flags_t;
 
 typedef struct __attribute__((__packed__))
@@ -103,6 +113,12 @@ typedef struct __attribute__((__packed__))
     uint8_t data[];
 } np_write_data_cmd_t;
 
+typedef struct __attribute__((__packed__))
+{
+    np_cmd_t cmd;
+    uint32_t pages;
+} np_write_skip_cmd_t;
+
 typedef struct __attribute__((__packed__))
 {
     np_cmd_t cmd;
@@ -116,6 +132,26 @@ typedef struct __attribute__((__packed__))
     np_cmd_flags_t flags;
 } np_read_cmd_t;
 
+typedef struct __attribute__((__packed__))
+{
+    uint32_t block;
+    uint32_t blocks;
+} np_region_t;
+
+typedef struct __attribute__((__packed__))
+{
+    np_cmd_t cmd;
+    uint8_t count;
+    np_region_t region[];
+} np_regions_cmd_t;
+
+typedef struct __attribute__((__packed__))
+{
+    np_cmd_t cmd;
+    uint64_t addr;
+    uint64_t len;
+} np_blank_scan_cmd_t;
+
 typedef struct __attribute__((__packed__))
 {
     np_cmd_t cmd;
@@ -149,6 +185,7 @@ enum
     NP_STATUS_WRITE_ACK = 0x03,
     NP_STATUS_BB_SKIP   = 0x04,
     NP_STATUS_PROGRESS  = 0x05,
+    NP_STATUS_ECC       = 0x06,
 };
 
 typedef struct __attribute__((__packed__))
@@ -157,6 +194,12 @@ typedef struct __attribute__((__packed__))
     chip_id_t nand_id;
 } np_resp_id_t;
 
+typedef struct __attribute__((__packed__))
+{
+    np_resp_t header;
+    uint64_t used_len;
+} np_resp_used_len_t;
+
 /* BB, write ack and error responses are aligned to the same size to avoid
  * receiver wait for additional data */
 typedef struct __attribute__((__packed__))
@@ -166,6 +209,13 @@ typedef struct __attribute__((__packed__))
     uint32_t size;
 } np_resp_bad_block_t;
 
+typedef struct __attribute__((__packed__))
+{
+    np_resp_t header;
+    uint64_t addr;
+    uint32_t ecc;
+} np_resp_ecc_t;
+
 typedef struct __attribute__((__packed__))
 {
     np_resp_t header;
@@ -223,6 +273,30 @@ typedef struct __attribute__((__packed__))
     uint8_t active_image;
 } boot_config_t;
 
+typedef struct
+{
+    uint32_t page;
+    uint32_t end_page;
+    uint32_t busy_page;
+    uint32_t busy_blocks;
+    uint32_t single_blocks;
+    uint32_t timeout;
+} np_erase_lun_t;
+
+typedef struct
+{
+    int in_progress;
+    int skip_bb;
+    int is_full;
+    uint32_t page_size;
+    uint32_t block_size;
+    uint32_t pages_in_block;
+    uint64_t len;
+    uint64_t progress;
+    uint32_t lun_num;
+    np_erase_lun_t lun[NP_MAX_LUNS];
+} np_erase_t;
+
 typedef struct
 {
     uint8_t *rx_buf;
@@ -240,8 +314,26 @@ typedef struct
     uint64_t bytes_written;
     uint64_t bytes_ack;
     int skip_bb;
+    int wr_erase;
+    int wr_erase_busy;
+    uint32_t wr_erase_status;
     int nand_wr_in_progress;
+    int nand_cache_busy;
+    uint64_t nand_wr_addr;
+    uint64_t nand_wr_prev_addr;
+    int nand_wr_plane;
+    uint64_t nand_wr_plane_addr;
     uint32_t nand_timeout;
+    np_erase_t erase;
+    np_region_t regions[NP_MAX_REGIONS];
+    uint32_t region_num;
+    int wr_regions;
+    uint32_t wr_region;
+    uint64_t wr_region_left;
+    int wr_planes;
+    int wr_plane;
+    uint64_t wr_plane_off;
+    uint64_t wr_offset;
     chip_info_t chip_info;
     uint8_t active_image;
     uint8_t hal;
@@ -307,6 +399,38 @@ static int np_send_progress(uint64_t progress)
     return 0;
 }
 
+static int np_send_ecc(uint64_t addr, uint32_t ecc)
+{
+    np_resp_t resp_header = { NP_RESP_STATUS, NP_STATUS_ECC };
+    np_resp_ecc_t resp_ecc = { resp_header, addr, ecc };
+
+    if (np_comm_cb->send((uint8_t *)&resp_ecc, sizeof(resp_ecc)))
+        return -1;
+
+    return 0;
+}
+
+static int np_ecc_calc_enable(np_prog_t *prog, bool enable)
+{
+    if (!hal[prog->hal]->ecc_calc_enable)
+    {
+        if (!enable)
+            return 0;
+
+        ERROR_PRINT("ECC calculation is not supported\r\n");
+        return NP_ERR_CMD_INVALID;
+    }
+
+    if (hal[prog->hal]->ecc_calc_enable(enable, prog->chip_info.page_size))
+    {
+        ERROR_PRINT("ECC calculation is not supported for page size 0x%lx\r\n",
+            prog->chip_info.page_size);
+        return NP_ERR_CMD_INVALID;
+    }
+
+    return 0;
+}
+
 static int _np_cmd_nand_read_id(np_prog_t *prog)
 {
     np_resp_id_t resp;
@@ -448,12 +572,201 @@ static int np_nand_erase(np_prog_t *prog, uint32_t page)
     return 0;
 }
 
+/* Erase range is fixed in advance so it could be split between LUNs */
+static int np_nand_erase_start(np_prog_t *prog, uint32_t page, uint32_t pages)
+{
+    np_erase_t *erase = &prog->erase;
+    np_erase_lun_t *lun;
+    uint32_t i, end_page, lun_pages, blocks;
+
+    blocks = erase->len / erase->block_size;
+    if (erase->skip_bb && !erase->is_full)
+    {
+        /* On partial erase do not count bad blocks */
+        for (end_page = page; blocks; end_page += erase->pages_in_block)
+        {
+            if (end_page >= pages)
+            {
+                ERROR_PRINT("Erase address 0x%" PRIx64
+                    " is more then chip size 0x%" PRIx64 "\r\n",
+                    (uint64_t)end_page * erase->page_size,
+                    (uint64_t)pages * erase->page_size);
+                return NP_ERR_ADDR_EXCEEDED;
+            }
+
+            if (!nand_bad_block_table_lookup(end_page))
+                blocks--;
+        }
+    }
+    else
+        end_page = page + blocks * erase->pages_in_block;
+
+    erase->lun_num = hal[prog->hal]->lun_count ?
+        hal[prog->hal]->lun_count() : 1;
+    if (erase->lun_num > NP_MAX_LUNS)
+        erase->lun_num = NP_MAX_LUNS;
+    lun_pages = pages / erase->lun_num;
+
+    for (i = 0; i < erase->lun_num; i++)
+    {
+        lun = &erase->lun[i];
+        lun->page = page > i * lun_pages ? page : i * lun_pages;
+        lun->end_page = end_page < (i + 1) * lun_pages ? end_page :
+            (i + 1) * lun_pages;
+        if (lun->page > lun->end_page)
+            lun->page = lun->end_page;
+        lun->busy_blocks = 0;
+        lun->single_blocks = 0;
+        lun->timeout = 0;
+    }
+
+    erase->progress = 0;
+    erase->in_progress = 1;
+
+    return 0;
+}
+
+static int np_nand_erase_lun_issue(np_prog_t *prog, np_erase_lun_t *lun)
+{
+    np_erase_t *erase = &prog->erase;
+    uint32_t status = FLASH_STATUS_INVALID_CMD;
+    uint32_t page = lun->page, plane_page = page + erase->pages_in_block;
+    uint64_t addr = (uint64_t)page * erase->page_size;
+
+    if (erase->skip_bb && nand_bad_block_table_lookup(page))
+    {
+        DEBUG_PRINT("Skipped bad block at 0x%" PRIx64 "\r\n", addr);
+        if (np_send_bad_block_info(addr, erase->block_size, true))
+            return -1;
+
+        lun->page = plane_page;
+        if (!erase->is_full)
+            return 0;
+
+        erase->progress += erase->block_size;
+        return np_send_progress(erase->progress);
+    }
+
+    DEBUG_PRINT("NAND erase at 0x%" PRIx64 "\r\n", addr);
+
+    /* Erase even block together with the next one from other plane if it
+     * is in range and is not skipped.
+     */
+    if (lun->single_blocks)
+        lun->single_blocks--;
+    else if (hal[prog->hal]->erase_block_mp_async &&
+        !((page / erase->pages_in_block) % 2) && plane_page < lun->end_page &&
+        (!erase->skip_bb || !nand_bad_block_table_lookup(plane_page)))
+    {
+        status = hal[prog->hal]->erase_block_mp_async(page, plane_page);
+    }
+
+    switch (status)
+    {
+    case FLASH_STATUS_READY:
+        lun->busy_blocks = 2;
+        break;
+    case FLASH_STATUS_INVALID_CMD:
+        hal[prog->hal]->erase_block_async(page);
+        lun->busy_blocks = 1;
+        break;
+    default:
+        /* Erase blocks one by one */
+        lun->single_blocks = 2;
+        return 0;
+    }
+
+    lun->busy_page = page;
+    lun->page += lun->busy_blocks * erase->pages_in_block;
+
+    return 0;
+}
+
+static int np_nand_erase_lun_poll(np_prog_t *prog, np_erase_lun_t *lun)
+{
+    np_erase_t *erase = &prog->erase;
+    uint32_t status;
+    uint64_t addr = (uint64_t)lun->busy_page * erase->page_size;
+
+    if (hal[prog->hal]->read_status_lun)
+        status = hal[prog->hal]->read_status_lun(lun->busy_page);
+    else
+        status = hal[prog->hal]->read_status();
+
+    switch (status)
+    {
+    case FLASH_STATUS_READY:
+        break;
+    case FLASH_STATUS_BUSY:
+        if (++lun->timeout != NP_NAND_TIMEOUT)
+            return 0;
+        ERROR_PRINT("NAND erase timeout at 0x%" PRIx64 "\r\n", addr);
+        break;
+    case FLASH_STATUS_ERROR:
+        if (lun->busy_blocks > 1)
+        {
+            /* Erase blocks again one by one to find out which one is bad */
+            lun->page = lun->busy_page;
+            lun->single_blocks = lun->busy_blocks;
+            lun->busy_blocks = 0;
+            lun->timeout = 0;
+            return 0;
+        }
+        if (np_send_bad_block_info(addr, erase->block_size, false))
+            return -1;
+        break;
+    default:
+        ERROR_PRINT("Unknown NAND status\r\n");
+        return -1;
+    }
+
+    erase->progress += lun->busy_blocks * erase->block_size;
+    lun->busy_blocks = 0;
+    lun->timeout = 0;
+
+    return np_send_progress(erase->progress);
+}
+
+static int np_nand_erase_handler(np_prog_t *prog)
+{
+    np_erase_t *erase = &prog->erase;
+    np_erase_lun_t *lun;
+    bool is_done = true;
+    uint32_t i;
+
+    for (i = 0; i < erase->lun_num; i++)
+    {
+        lun = &erase->lun[i];
+
+        if (lun->busy_blocks && np_nand_erase_lun_poll(prog, lun))
+            return -1;
+
+        if (!lun->busy_blocks && lun->page < lun->end_page &&
+            np_nand_erase_lun_issue(prog, lun))
+        {
+            return -1;
+        }
+
+        if (lun->busy_blocks || lun->page < lun->end_page)
+            is_done = false;
+    }
+
+    if (!is_done)
+        return 0;
+
+    erase->in_progress = 0;
+    led_wr_set(false);
+
+    return np_send_ok_status();
+}
+
 static int _np_cmd_nand_erase(np_prog_t *prog)
 {
     int ret;
     uint64_t addr, len, total_size, total_len;
     uint32_t page, pages, pages_in_block, page_size, block_size;
     np_erase_cmd_t *erase_cmd;
+    np_erase_t *erase;
     bool skip_bb, inc_spare, is_bad = false;
 
     if (prog->rx_buf_len < sizeof(np_erase_cmd_t))
@@ -522,6 +835,20 @@ static int _np_cmd_nand_erase(np_prog_t *prog)
 
     page = addr / page_size;
 
+    /* Erase is completed by np_nand_handler() */
+    if (hal[prog->hal]->erase_block_async)
+    {
+        erase = &prog->erase;
+        erase->skip_bb = skip_bb;
+        erase->is_full = erase_cmd->len == total_size;
+        erase->page_size = page_size;
+        erase->block_size = block_size;
+        erase->pages_in_block = pages_in_block;
+        erase->len = len;
+
+        return np_nand_erase_start(prog, page, total_size / page_size);
+    }
+
     while (len)
     {
         if (addr >= total_size)
@@ -559,7 +886,8 @@ static int np_cmd_nand_erase(np_prog_t *prog)
 
     led_wr_set(true);
     ret = _np_cmd_nand_erase(prog);
-    led_wr_set(false);
+    if (!prog->erase.in_progress)
+        led_wr_set(false);
 
     return ret;
 }
@@ -575,6 +903,95 @@ static int np_send_write_ack(uint64_t bytes_ack)
     return 0;
 }
 
+/* Regions are used instead of address and length by read and write commands
+ * with regions flag, they are processed back to back in one command.
+ */
+static int np_regions_get(np_prog_t *prog, uint32_t block_size,
+    uint64_t *addr, uint64_t *len)
+{
+    uint32_t i;
+
+    if (!prog->region_num)
+    {
+        ERROR_PRINT("Region list is not set\r\n");
+        return NP_ERR_ADDR_INVALID;
+    }
+
+    *addr = (uint64_t)prog->regions[0].block * block_size;
+    *len = 0;
+    for (i = 0; i < prog->region_num; i++)
+        *len += (uint64_t)prog->regions[i].blocks * block_size;
+
+    return 0;
+}
+
+static int np_cmd_nand_regions(np_prog_t *prog)
+{
+    uint32_t i, j, block_num;
+    np_region_t *region, *prev;
+    np_regions_cmd_t *regions_cmd;
+
+    prog->region_num = 0;
+
+    if (prog->rx_buf_len < sizeof(np_regions_cmd_t))
+    {
+        ERROR_PRINT("Wrong buffer length for regions command %lu\r\n",
+            prog->rx_buf_len);
+        return NP_ERR_LEN_INVALID;
+    }
+
+    regions_cmd = (np_regions_cmd_t *)prog->rx_buf;
+    if (!regions_cmd->count || regions_cmd->count > NP_MAX_REGIONS ||
+        prog->rx_buf_len < sizeof(np_regions_cmd_t) +
+        regions_cmd->count * sizeof(np_region_t))
+    {
+        ERROR_PRINT("Wrong region count %u\r\n", regions_cmd->count);
+        return NP_ERR_CMD_DATA_SIZE;
+    }
+
+    DEBUG_PRINT("Set %u regions command\r\n", regions_cmd->count);
+
+    block_num = prog->chip_info.total_size / prog->chip_info.block_size;
+    for (i = 0; i < regions_cmd->count; i++)
+    {
+        region = &regions_cmd->region[i];
+        if (!region->blocks)
+        {
+            ERROR_PRINT("Region %lu is empty\r\n", i);
+            return NP_ERR_LEN_INVALID;
+        }
+
+        if (region->block >= block_num ||
+            region->blocks > block_num - region->block)
+        {
+            ERROR_PRINT("Region 0x%lx+0x%lx is more then block count "
+                "0x%lx\r\n", region->block, region->blocks, block_num);
+            return NP_ERR_ADDR_EXCEEDED;
+        }
+
+        /* Keep regions sorted by block, data follows chip order */
+        for (j = i; j && prog->regions[j - 1].block > region->block; j--)
+            prog->regions[j] = prog->regions[j - 1];
+        prog->regions[j] = *region;
+    }
+
+    /* Overlapped pages would be programmed twice */
+    for (i = 1; i < regions_cmd->count; i++)
+    {
+        prev = &prog->regions[i - 1];
+        region = &prog->regions[i];
+        if (prev->block + prev->blocks > region->block)
+        {
+            ERROR_PRINT("Region 0x%lx+0x%lx overlaps region 0x%lx+0x%lx\r\n",
+                region->block, region->blocks, prev->block, prev->blocks);
+            return NP_ERR_ADDR_INVALID;
+        }
+    }
+    prog->region_num = regions_cmd->count;
+
+    return np_send_ok_status();
+}
+
 static int np_cmd_nand_write_start(np_prog_t *prog)
 {
     int ret;
@@ -594,6 +1011,9 @@ static int np_cmd_nand_write_start(np_prog_t *prog)
     if (hal[prog->hal]->enable_hw_ecc)
         hal[prog->hal]->enable_hw_ecc(write_start_cmd->flags.enable_hw_ecc);
 
+    if ((ret = np_ecc_calc_enable(prog, write_start_cmd->flags.fsmc_ecc)))
+        return ret;
+
     addr = write_start_cmd->addr;
     len = write_start_cmd->len;
 
@@ -617,7 +1037,23 @@ static int np_cmd_nand_write_start(np_prog_t *prog)
         prog->total_size = prog->chip_info.total_size;
     }
 
-    if (addr + len > prog->total_size)
+    prog->wr_planes = write_start_cmd->flags.planes;
+    prog->wr_regions = write_start_cmd->flags.regions;
+    if (prog->wr_planes && prog->wr_regions)
+    {
+        ERROR_PRINT("Multi-plane write of regions is not supported\r\n");
+        return NP_ERR_CMD_INVALID;
+    }
+
+    if (prog->wr_regions)
+    {
+        if ((ret = np_regions_get(prog, prog->block_size, &addr, &len)))
+            return ret;
+        prog->wr_region = 0;
+        prog->wr_region_left = (uint64_t)prog->regions[0].blocks *
+            prog->block_size;
+    }
+    else if (addr + len > prog->total_size)
     {
         ERROR_PRINT("Write address 0x%" PRIx64 "+0x%" PRIx64
             " is more then chip size 0x%" PRIx64 "\r\n", addr, len,
@@ -645,6 +1081,16 @@ static int np_cmd_nand_write_start(np_prog_t *prog)
         return NP_ERR_LEN_NOT_ALIGN;
     }
 
+    /* Host interleaves pages of block pairs counted from the first block */
+    prog->wr_erase = write_start_cmd->flags.erase;
+    if ((prog->wr_erase || prog->wr_planes) && addr % prog->block_size)
+    {
+        ERROR_PRINT("Address 0x%" PRIx64
+            " is not aligned to block size 0x%lx\r\n", addr, prog->block_size);
+        return NP_ERR_ADDR_NOT_ALIGN;
+    }
+    prog->wr_erase_busy = 0;
+
     prog->skip_bb = write_start_cmd->flags.skip_bb;
     if (prog->skip_bb && !prog->bb_is_read &&
         (ret = _np_cmd_read_bad_blocks(prog, false)))
@@ -668,6 +1114,10 @@ static int np_cmd_nand_write_start(np_prog_t *prog)
 
     prog->bytes_written = 0;
     prog->bytes_ack = 0;
+    prog->wr_plane = 0;
+    prog->wr_plane_off = 0;
+    prog->wr_offset = 0;
+    prog->nand_wr_plane = 0;
 
     return np_send_ok_status();
 }
@@ -677,18 +1127,44 @@ static int np_nand_handle_status(np_prog_t *prog)
     switch (hal[prog->hal]->read_status())
     {
     case FLASH_STATUS_ERROR:
-        if (np_send_bad_block_info(prog->addr, prog->block_size, false))
+        /* Status of multi-plane program does not tell which plane failed */
+        if (prog->nand_wr_plane &&
+            np_send_bad_block_info(prog->nand_wr_plane_addr, prog->block_size,
+            false))
+        {
+            return -1;
+        }
+        if (np_send_bad_block_info(prog->nand_wr_addr, prog->block_size,
+            false))
+        {
             return -1;
+        }
         /* fall through */
     case FLASH_STATUS_READY:
         prog->nand_wr_in_progress = 0;
+        prog->nand_cache_busy = 0;
+        prog->nand_wr_plane = 0;
         prog->nand_timeout = 0;
         break;
+    case FLASH_STATUS_CACHE_ERROR:
+        /* Page programmed before the last one has failed */
+        if (np_send_bad_block_info(prog->nand_wr_prev_addr, prog->block_size,
+            false))
+        {
+            return -1;
+        }
+        /* fall through */
+    case FLASH_STATUS_CACHE_READY:
+        /* Array is still busy but next page can be loaded */
+        prog->nand_cache_busy = 0;
+        /* fall through */
     case FLASH_STATUS_BUSY:
         if (++prog->nand_timeout == NP_NAND_TIMEOUT)
         {
             ERROR_PRINT("NAND write timeout at 0x%" PRIx64 "\r\n", prog->addr);
             prog->nand_wr_in_progress = 0;
+            prog->nand_cache_busy = 0;
+            prog->nand_wr_plane = 0;
             prog->nand_timeout = 0;
             return -1;
         }
@@ -696,6 +1172,8 @@ static int np_nand_handle_status(np_prog_t *prog)
     default:
         ERROR_PRINT("Unknown NAND status\r\n");
         prog->nand_wr_in_progress = 0;
+        prog->nand_cache_busy = 0;
+        prog->nand_wr_plane = 0;
         prog->nand_timeout = 0;
         return -1;
     }
@@ -703,9 +1181,24 @@ static int np_nand_handle_status(np_prog_t *prog)
     return 0;
 }
 
-static int np_nand_write(np_prog_t *prog)
-{   
-    if (prog->nand_wr_in_progress)
+/* Same pages of paired blocks from different planes are programmed together */
+static bool np_nand_wr_is_plane_pair(np_prog_t *prog)
+{
+    uint32_t pages_in_block = prog->block_size / prog->page_size;
+
+    return hal[prog->hal]->write_page_plane_async && !prog->wr_plane &&
+        prog->wr_plane_off == prog->block_size &&
+        !((prog->page.page / pages_in_block) % 2);
+}
+
+static int np_nand_write(np_prog_t *prog, bool is_last)
+{
+    uint32_t status = FLASH_STATUS_INVALID_CMD;
+
+    /* Cache register is released before array program is completed when
+     * cache program is used, otherwise together with it.
+     */
+    if (prog->nand_cache_busy)
     {
         DEBUG_PRINT("Wait for previous NAND write\r\n");
         do
@@ -713,38 +1206,309 @@ static int np_nand_write(np_prog_t *prog)
             if (np_nand_handle_status(prog))
                 return -1;
         }
-        while (prog->nand_wr_in_progress);
+        while (prog->nand_cache_busy);
     }
 
     DEBUG_PRINT("NAND write at 0x%" PRIx64 " %lu bytes\r\n", prog->addr,
         prog->page_size);
 
-    hal[prog->hal]->write_page_async(prog->page.buf, prog->page.page,
-        prog->page_size);
-
-    prog->nand_wr_in_progress = 1;
+    /* First plane page is loaded only if the paired page follows it, the
+     * paired page is programmed without cache and starts both.
+     */
+    if (!is_last && np_nand_wr_is_plane_pair(prog))
+    {
+        while (prog->nand_wr_in_progress)
+        {
+            if (np_nand_handle_status(prog))
+                return -1;
+        }
 
-    return 0;
-}
+        if (hal[prog->hal]->write_page_plane_async(prog->page.buf,
+            prog->page.page, prog->page_size) == FLASH_STATUS_READY)
+        {
+            prog->nand_wr_plane = 1;
+            prog->nand_wr_plane_addr = prog->addr;
+            return 0;
+        }
+    }
 
-static int np_cmd_nand_write_data(np_prog_t *prog)
-{
-    uint32_t write_len, bytes_left, len;
-    np_write_data_cmd_t *write_data_cmd;
+    /* Status of cache program can refer to the previous page */
+    prog->nand_wr_prev_addr = prog->nand_wr_addr;
+    prog->nand_wr_addr = prog->addr;
 
-    if (prog->rx_buf_len < sizeof(np_write_data_cmd_t))
+    if (!is_last && !prog->nand_wr_plane &&
+        hal[prog->hal]->write_page_cache_async)
     {
-        ERROR_PRINT("Wrong buffer length for write data command %lu\r\n",
-            prog->rx_buf_len);
-        return NP_ERR_LEN_INVALID;
+        status = hal[prog->hal]->write_page_cache_async(prog->page.buf,
+            prog->page.page, prog->page_size);
     }
 
-    write_data_cmd = (np_write_data_cmd_t *)prog->rx_buf;
-    len = write_data_cmd->len;
-    if (len + sizeof(np_write_data_cmd_t) > NP_PACKET_BUF_SIZE)
+    if (status == FLASH_STATUS_INVALID_CMD)
     {
-        ERROR_PRINT("Data size is wrong 0x%lx\r\n", len);
-        return NP_ERR_CMD_DATA_SIZE;
+        hal[prog->hal]->write_page_async(prog->page.buf, prog->page.page,
+            prog->page_size);
+    }
+
+    prog->nand_wr_in_progress = 1;
+    prog->nand_cache_busy = 1;
+
+    return 0;
+}
+
+static int np_nand_wr_skip_bb(np_prog_t *prog)
+{
+    while (prog->skip_bb && nand_bad_block_table_lookup(prog->page.page))
+    {
+        DEBUG_PRINT("Skipped bad block at 0x%" PRIx64 "\r\n", prog->addr);
+        if (np_send_bad_block_info(prog->addr, prog->block_size, true))
+            return -1;
+
+        prog->addr += prog->block_size;
+        prog->page.page += prog->block_size / prog->page_size;
+    }
+
+    return 0;
+}
+
+static int np_nand_wr_erase_block(np_prog_t *prog)
+{
+    if (np_nand_wr_skip_bb(prog))
+        return -1;
+
+    /* Address is validated before page is written */
+    if (prog->addr >= prog->total_size)
+        return 0;
+
+    while (prog->nand_wr_in_progress)
+    {
+        if (np_nand_handle_status(prog))
+            return -1;
+    }
+
+    DEBUG_PRINT("NAND erase at 0x%" PRIx64 "\r\n", prog->addr);
+
+    if (hal[prog->hal]->erase_block_async)
+    {
+        hal[prog->hal]->erase_block_async(prog->page.page);
+        prog->wr_erase_status = FLASH_STATUS_BUSY;
+    }
+    else
+        prog->wr_erase_status = hal[prog->hal]->erase_block(prog->page.page);
+    prog->wr_erase_busy = 1;
+
+    return 0;
+}
+
+static int np_nand_wr_erase_end(np_prog_t *prog)
+{
+    uint32_t timeout = 0;
+
+    while (prog->wr_erase_busy)
+    {
+        if (prog->wr_erase_status == FLASH_STATUS_BUSY)
+            prog->wr_erase_status = hal[prog->hal]->read_status();
+
+        switch (prog->wr_erase_status)
+        {
+        case FLASH_STATUS_BUSY:
+            if (++timeout != NP_NAND_TIMEOUT)
+                break;
+            /* fall through */
+        case FLASH_STATUS_TIMEOUT:
+            ERROR_PRINT("NAND erase timeout at 0x%" PRIx64 "\r\n",
+                prog->addr);
+            prog->wr_erase_busy = 0;
+            return -1;
+        case FLASH_STATUS_READY:
+            prog->wr_erase_busy = 0;
+            break;
+        case FLASH_STATUS_ERROR:
+            prog->wr_erase_busy = 0;
+            if (!prog->skip_bb)
+            {
+                if (np_send_bad_block_info(prog->addr, prog->block_size,
+                    false))
+                {
+                    return -1;
+                }
+                break;
+            }
+
+            /* Skip the block for the rest of the write and erase the next,
+             * the block is reported once as skipped by np_nand_wr_skip_bb()
+             */
+            if (nand_bad_block_table_add(prog->page.page))
+                return -1;
+            if (np_nand_wr_erase_block(prog))
+                return -1;
+            timeout = 0;
+            break;
+        default:
+            ERROR_PRINT("Unknown NAND status\r\n");
+            prog->wr_erase_busy = 0;
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* Block of a pair is erased before its pages are loaded */
+static int np_nand_wr_pair_block(np_prog_t *prog)
+{
+    if (!prog->wr_erase)
+        return np_nand_wr_skip_bb(prog);
+
+    if (np_nand_wr_erase_block(prog))
+        return -1;
+
+    return np_nand_wr_erase_end(prog);
+}
+
+/* Multi-plane write receives the same pages of the block and the next good
+ * block one after another, while at least two blocks of data are left.
+ */
+static int np_nand_wr_pair_start(np_prog_t *prog)
+{
+    uint64_t addr;
+    uint32_t page, pages_in_block = prog->block_size / prog->page_size;
+
+    if (np_nand_wr_pair_block(prog))
+        return -1;
+    addr = prog->addr;
+    page = prog->page.page;
+
+    prog->addr += prog->block_size;
+    prog->page.page += pages_in_block;
+    if (np_nand_wr_pair_block(prog))
+        return -1;
+    prog->wr_plane_off = prog->addr - addr;
+
+    prog->addr = addr;
+    prog->page.page = page;
+
+    return 0;
+}
+
+/* Block erase is started when the first data of its first page is received
+ * and is completed before the page is programmed. Block pair of multi-plane
+ * write is started instead.
+ */
+static int np_nand_wr_block_start(np_prog_t *prog)
+{
+    if (prog->page.offset || prog->addr % prog->block_size || prog->wr_plane)
+        return 0;
+
+    if (prog->wr_planes && prog->len - prog->wr_offset >= 2 * prog->block_size)
+        return np_nand_wr_pair_start(prog);
+
+    if (!prog->wr_erase)
+        return 0;
+
+    return np_nand_wr_erase_block(prog);
+}
+
+/* Data of the next region continues at its first block */
+static void np_nand_wr_next_region(np_prog_t *prog)
+{
+    np_region_t *region;
+
+    if (!prog->wr_regions)
+        return;
+
+    prog->wr_region_left -= prog->page_size;
+    if (prog->wr_region_left || ++prog->wr_region == prog->region_num)
+        return;
+
+    region = &prog->regions[prog->wr_region];
+    prog->addr = (uint64_t)region->block * prog->block_size;
+    prog->page.page = region->block * (prog->block_size / prog->page_size);
+    prog->wr_region_left = (uint64_t)region->blocks * prog->block_size;
+}
+
+/* Pages of a block pair alternate between its blocks, the next pair starts
+ * after the paired block.
+ */
+static void np_nand_wr_next_page(np_prog_t *prog)
+{
+    uint32_t plane_pages = prog->wr_plane_off / prog->page_size;
+
+    prog->wr_offset += prog->page_size;
+    if (!prog->wr_plane_off)
+    {
+        prog->addr += prog->page_size;
+        prog->page.page++;
+        np_nand_wr_next_region(prog);
+        return;
+    }
+
+    if (!prog->wr_plane)
+    {
+        prog->addr += prog->wr_plane_off;
+        prog->page.page += plane_pages;
+        prog->wr_plane = 1;
+        return;
+    }
+
+    prog->addr -= prog->wr_plane_off - prog->page_size;
+    prog->page.page -= plane_pages - 1;
+    prog->wr_plane = 0;
+    if (prog->addr % prog->block_size)
+        return;
+
+    prog->addr += prog->wr_plane_off;
+    prog->page.page += plane_pages;
+    prog->wr_plane_off = 0;
+}
+
+/* Page is programmed and the next one is started */
+static int np_nand_wr_page(np_prog_t *prog, bool is_last)
+{
+    if (np_nand_write(prog, is_last))
+        return -1;
+
+    prog->page.offset = 0;
+    np_nand_wr_next_page(prog);
+
+    return 0;
+}
+
+/* Full page left in buffer is the last one before skipped pages or write
+ * end, it is programmed without cache and the program is completed.
+ */
+static int np_nand_wr_finish(np_prog_t *prog)
+{
+    if (prog->page.offset == prog->page_size && np_nand_wr_page(prog, true))
+        return -1;
+
+    while (prog->nand_wr_in_progress)
+    {
+        if (np_nand_handle_status(prog))
+            return -1;
+    }
+
+    return 0;
+}
+
+static int np_cmd_nand_write_data(np_prog_t *prog)
+{
+    uint32_t write_len, bytes_left, len;
+    np_write_data_cmd_t *write_data_cmd;
+    bool is_last;
+
+    if (prog->rx_buf_len < sizeof(np_write_data_cmd_t))
+    {
+        ERROR_PRINT("Wrong buffer length for write data command %lu\r\n",
+            prog->rx_buf_len);
+        return NP_ERR_LEN_INVALID;
+    }
+
+    write_data_cmd = (np_write_data_cmd_t *)prog->rx_buf;
+    len = write_data_cmd->len;
+    if (len + sizeof(np_write_data_cmd_t) > NP_PACKET_BUF_SIZE)
+    {
+        ERROR_PRINT("Data size is wrong 0x%lx\r\n", len);
+        return NP_ERR_CMD_DATA_SIZE;
     }
 
     if (len + sizeof(np_write_data_cmd_t) != prog->rx_buf_len)
@@ -760,25 +1524,26 @@ static int np_cmd_nand_write_data(np_prog_t *prog)
         return NP_ERR_ADDR_INVALID;
     }
 
+    /* More data follows the full page, so it is not the last one */
+    if (prog->page.offset == prog->page_size && np_nand_wr_page(prog, false))
+        return NP_ERR_NAND_WR;
+
     if (prog->page.offset + len > prog->page_size)
         write_len = prog->page_size - prog->page.offset;
     else
         write_len = len;
+    bytes_left = len - write_len;
+
+    if (np_nand_wr_block_start(prog))
+        return NP_ERR_NAND_ERASE;
 
     memcpy(prog->page.buf + prog->page.offset, write_data_cmd->data, write_len);
     prog->page.offset += write_len;
 
     if (prog->page.offset == prog->page_size)
     {
-        while (prog->skip_bb && nand_bad_block_table_lookup(prog->page.page))
-        {
-            DEBUG_PRINT("Skipped bad block at 0x%" PRIx64 "\r\n", prog->addr);
-            if (np_send_bad_block_info(prog->addr, prog->block_size, true))
-                return -1;
-
-            prog->addr += prog->block_size;
-            prog->page.page += prog->block_size / prog->page_size;
-        }
+        if (np_nand_wr_skip_bb(prog))
+            return -1;
 
         if (prog->addr >= prog->total_size)
         {
@@ -788,17 +1553,22 @@ static int np_cmd_nand_write_data(np_prog_t *prog)
             return NP_ERR_ADDR_EXCEEDED;
         }
 
-        if (np_nand_write(prog))
-            return NP_ERR_NAND_WR;
+        if (np_nand_wr_erase_end(prog))
+            return NP_ERR_NAND_ERASE;
 
-        prog->addr += prog->page_size;
-        prog->page.page++;
-        prog->page.offset = 0;
+        /* Page is kept until it is known if skipped pages or write end
+         * follow it, then cache program is finished by it.
+         */
+        is_last = prog->bytes_written + write_len == prog->len;
+        if ((is_last || bytes_left) && np_nand_wr_page(prog, is_last))
+            return NP_ERR_NAND_WR;
     }
 
-    bytes_left = len - write_len;
     if (bytes_left)
     {
+        if (np_nand_wr_block_start(prog))
+            return NP_ERR_NAND_ERASE;
+
         memcpy(prog->page.buf, write_data_cmd->data + write_len, bytes_left);
         prog->page.offset += bytes_left;
     }
@@ -822,10 +1592,96 @@ static int np_cmd_nand_write_data(np_prog_t *prog)
     return 0;
 }
 
+/* Skipped page is left erased, its block is still erased on write */
+static int np_nand_wr_skip_page(np_prog_t *prog)
+{
+    if (np_nand_wr_block_start(prog))
+        return NP_ERR_NAND_ERASE;
+
+    if (np_nand_wr_skip_bb(prog))
+        return -1;
+
+    if (prog->addr >= prog->total_size)
+    {
+        ERROR_PRINT("Write address 0x%" PRIx64
+            " is more then chip size 0x%" PRIx64 "\r\n", prog->addr,
+            prog->total_size);
+        return NP_ERR_ADDR_EXCEEDED;
+    }
+
+    if (np_nand_wr_erase_end(prog))
+        return NP_ERR_NAND_ERASE;
+
+    np_nand_wr_next_page(prog);
+
+    return 0;
+}
+
+static int np_cmd_nand_write_skip(np_prog_t *prog)
+{
+    int ret;
+    uint32_t i;
+    uint64_t len;
+    np_write_skip_cmd_t *write_skip_cmd;
+
+    if (prog->rx_buf_len < sizeof(np_write_skip_cmd_t))
+    {
+        ERROR_PRINT("Wrong buffer length for write skip command %lu\r\n",
+            prog->rx_buf_len);
+        return NP_ERR_LEN_INVALID;
+    }
+
+    if (!prog->addr_is_set)
+    {
+        ERROR_PRINT("Write address is not set\r\n");
+        return NP_ERR_ADDR_INVALID;
+    }
+
+    if (np_nand_wr_finish(prog))
+        return NP_ERR_NAND_WR;
+
+    if (prog->page.offset)
+    {
+        ERROR_PRINT("Data of 0x%lx length was not written\r\n",
+            prog->page.offset);
+        return NP_ERR_NAND_WR;
+    }
+
+    write_skip_cmd = (np_write_skip_cmd_t *)prog->rx_buf;
+    len = (uint64_t)write_skip_cmd->pages * prog->page_size;
+    if (prog->bytes_written + len > prog->len)
+    {
+        ERROR_PRINT("Actual write data length 0x%" PRIx64
+            " is more then 0x%" PRIx64 "\r\n", prog->bytes_written + len,
+            prog->len);
+        return NP_ERR_LEN_EXCEEDED;
+    }
+
+    DEBUG_PRINT("NAND write skip at 0x%" PRIx64 " %lu pages\r\n", prog->addr,
+        write_skip_cmd->pages);
+
+    for (i = 0; i < write_skip_cmd->pages; i++)
+    {
+        if ((ret = np_nand_wr_skip_page(prog)))
+            return ret;
+    }
+
+    prog->bytes_written += len;
+    if (np_send_write_ack(prog->bytes_written))
+        return -1;
+    prog->bytes_ack = prog->bytes_written;
+
+    return 0;
+}
+
 static int np_cmd_nand_write_end(np_prog_t *prog)
 {
     prog->addr_is_set = 0;
 
+    /* Program failure is reported before write is completed */
+    if (np_nand_wr_finish(prog))
+        return NP_ERR_NAND_WR;
+
     if (prog->page.offset)
     {
         ERROR_PRINT("Data of 0x%lx length was not written\r\n",
@@ -850,6 +1706,9 @@ static int np_cmd_nand_write(np_prog_t *prog)
     case NP_CMD_NAND_WRITE_D:
         ret = np_cmd_nand_write_data(prog);
         break;
+    case NP_CMD_NAND_WRITE_SKIP:
+        ret = np_cmd_nand_write_skip(prog);
+        break;
     case NP_CMD_NAND_WRITE_E:
         ret = np_cmd_nand_write_end(prog);
         led_wr_set(false);
@@ -864,43 +1723,173 @@ static int np_cmd_nand_write(np_prog_t *prog)
     return ret;
 }
 
-static int np_nand_read(uint64_t addr, np_page_t *page, uint32_t page_size,
-    uint32_t block_size, np_prog_t *prog)
+typedef struct
 {
-    uint32_t status;
+    np_prog_t *prog;
+    uint64_t addr;
+    uint64_t len;
+    uint32_t page_size;
+    uint32_t block_size;
+    bool fsmc_ecc;
+} np_read_ctx_t;
+
+static int np_nand_read_cb(uint8_t *buf, uint32_t page, uint32_t status,
+    void *ctx)
+{
+    uint32_t offset, send_len;
+    np_read_ctx_t *read_ctx = ctx;
+    uint32_t resp_header_size = offsetof(np_resp_t, data);
+    uint32_t tx_data_len = sizeof(np_packet_send_buf) - resp_header_size;
+    np_resp_t *resp = (np_resp_t *)np_packet_send_buf;
 
-    status = hal[prog->hal]->read_page(page->buf, page->page, page_size);
     switch (status)
     {
     case FLASH_STATUS_READY:
         break;
     case FLASH_STATUS_ERROR:
-        if (np_send_bad_block_info(addr, block_size, false))
+        if (np_send_bad_block_info(read_ctx->addr, read_ctx->block_size,
+            false))
+        {
             return -1;
+        }
         break;
     case FLASH_STATUS_TIMEOUT:
-        ERROR_PRINT("NAND write timeout at 0x%" PRIx64 "\r\n", addr);
+        ERROR_PRINT("NAND read timeout at 0x%" PRIx64 "\r\n", read_ctx->addr);
         break;
     default:
         ERROR_PRINT("Unknown NAND status\r\n");
         return -1;
     }
 
+    resp->code = NP_RESP_DATA;
+
+    for (offset = 0; offset < read_ctx->page_size && read_ctx->len;
+        offset += send_len)
+    {
+        if (read_ctx->page_size - offset >= tx_data_len)
+            send_len = tx_data_len;
+        else
+            send_len = read_ctx->page_size - offset;
+
+        if (send_len > read_ctx->len)
+            send_len = read_ctx->len;
+
+        memcpy(resp->data, buf + offset, send_len);
+
+        while (!np_comm_cb->send_ready());
+
+        resp->info = send_len;
+        if (np_comm_cb->send(np_packet_send_buf, resp_header_size + send_len))
+            return -1;
+
+        read_ctx->len -= send_len;
+    }
+
+    if (read_ctx->fsmc_ecc &&
+        np_send_ecc(read_ctx->addr, hal[read_ctx->prog->hal]->ecc_calc_get()))
+    {
+        return -1;
+    }
+
+    read_ctx->addr += read_ctx->page_size;
+
+    return 0;
+}
+
+/* Number of pages that can be read in one run starting from the page, the run
+ * is stopped before the next bad block to be skipped.
+ */
+static uint32_t np_nand_read_run_len(uint32_t page, uint32_t pages,
+    uint32_t pages_in_block, bool skip_bb)
+{
+    uint32_t count = pages_in_block - page % pages_in_block;
+
+    while (count < pages && !(skip_bb &&
+        nand_bad_block_table_lookup(page + count)))
+    {
+        count += pages_in_block;
+    }
+
+    return count < pages ? count : pages;
+}
+
+static int np_nand_read(np_page_t *page, uint32_t count, np_read_ctx_t *ctx)
+{
+    uint32_t i, status;
+    np_prog_t *prog = ctx->prog;
+
+    if (hal[prog->hal]->read_pages)
+    {
+        return hal[prog->hal]->read_pages(page->buf, page->page, count,
+            ctx->page_size, np_nand_read_cb, ctx);
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        status = hal[prog->hal]->read_page(page->buf, page->page + i,
+            ctx->page_size);
+        if (np_nand_read_cb(page->buf, page->page + i, status, ctx))
+            return -1;
+    }
+
+    return 0;
+}
+
+static int np_nand_read_range(np_read_ctx_t *ctx, uint64_t total_size,
+    bool skip_bb, bool is_full)
+{
+    static np_page_t page;
+    uint32_t count, pages_in_block = ctx->block_size / ctx->page_size;
+
+    page.page = ctx->addr / ctx->page_size;
+    page.offset = 0;
+
+    while (ctx->len)
+    {
+        if (ctx->addr >= total_size)
+        {
+            ERROR_PRINT("Read address 0x%" PRIx64
+                " is more then chip size 0x%" PRIx64 "\r\n", ctx->addr,
+                total_size);
+            return NP_ERR_ADDR_EXCEEDED;
+        }
+
+        if (skip_bb && nand_bad_block_table_lookup(page.page))
+        {
+            DEBUG_PRINT("Skipped bad block at 0x%" PRIx64 "\r\n", ctx->addr);
+            if (np_send_bad_block_info(ctx->addr, ctx->block_size, true))
+                return -1;
+
+            /* On partial read do not count bad blocks */
+            if (is_full)
+                ctx->len -= ctx->block_size;
+            ctx->addr += ctx->block_size;
+            page.page += pages_in_block;
+            continue;
+        }
+
+        count = np_nand_read_run_len(page.page, ctx->len / ctx->page_size,
+            pages_in_block, skip_bb);
+        if ((total_size - ctx->addr) / ctx->page_size < count)
+            count = (total_size - ctx->addr) / ctx->page_size;
+
+        if (np_nand_read(&page, count, ctx))
+            return NP_ERR_NAND_RD;
+
+        page.page += count;
+    }
+
     return 0;
 }
 
 static int _np_cmd_nand_read(np_prog_t *prog)
 {
     int ret;
-    static np_page_t page;
     np_read_cmd_t *read_cmd;
+    np_read_ctx_t ctx;
     bool skip_bb, inc_spare;
     uint64_t addr, len, total_size;
-    uint32_t send_len, block_size, page_size, pages,
-        pages_in_block;
-    uint32_t resp_header_size = offsetof(np_resp_t, data);
-    uint32_t tx_data_len = sizeof(np_packet_send_buf) - resp_header_size;
-    np_resp_t *resp = (np_resp_t *)np_packet_send_buf;
+    uint32_t i, block_size, page_size, pages, pages_in_block;
 
     if (prog->rx_buf_len < sizeof(np_read_cmd_t))
     {
@@ -918,11 +1907,11 @@ static int _np_cmd_nand_read(np_prog_t *prog)
     DEBUG_PRINT("Read at 0x%" PRIx64 " 0x%" PRIx64 " bytes command\r\n", addr,
         len);
 
+    pages_in_block = prog->chip_info.block_size / prog->chip_info.page_size;
+
     if (inc_spare)
     {
         pages = prog->chip_info.total_size / prog->chip_info.page_size;
-        pages_in_block = prog->chip_info.block_size /
-            prog->chip_info.page_size;
         page_size = prog->chip_info.page_size + prog->chip_info.spare_size;
         block_size = pages_in_block * page_size;
         total_size = (uint64_t)pages * page_size;
@@ -934,7 +1923,12 @@ static int _np_cmd_nand_read(np_prog_t *prog)
         total_size = prog->chip_info.total_size;
     }
 
-    if (addr + len > total_size)
+    if (read_cmd->flags.regions)
+    {
+        if ((ret = np_regions_get(prog, block_size, &addr, &len)))
+            return ret;
+    }
+    else if (addr + len > total_size)
     {
         ERROR_PRINT("Read address 0x%" PRIx64 "+0x%" PRIx64
             " is more then chip size 0x%" PRIx64 "\r\n", addr, len, total_size);
@@ -967,76 +1961,279 @@ static int _np_cmd_nand_read(np_prog_t *prog)
         return ret;
     }
 
+    if ((ret = np_ecc_calc_enable(prog, read_cmd->flags.fsmc_ecc)))
+        return ret;
+
+    ctx.prog = prog;
+    ctx.addr = addr;
+    ctx.len = len;
+    ctx.page_size = page_size;
+    ctx.block_size = block_size;
+    ctx.fsmc_ecc = read_cmd->flags.fsmc_ecc;
+
+    if (!read_cmd->flags.regions)
+        return np_nand_read_range(&ctx, total_size, skip_bb, len == total_size);
+
+    for (i = 0; i < prog->region_num; i++)
+    {
+        ctx.addr = (uint64_t)prog->regions[i].block * block_size;
+        ctx.len = (uint64_t)prog->regions[i].blocks * block_size;
+        if ((ret = np_nand_read_range(&ctx, total_size, skip_bb, false)))
+            return ret;
+    }
+
+    return 0;
+}
+
+static int np_cmd_nand_read(np_prog_t *prog)
+{
+    int ret;
+
+    led_rd_set(true);
+    ret = _np_cmd_nand_read(prog);
+    led_rd_set(false);
+
+    return ret;
+}
+
+static uint32_t np_nand_read_spare_page(np_prog_t *prog, uint8_t *buf,
+    uint32_t page)
+{
+    uint32_t status;
+
+    /* Small page chips address spare area with separate command */
+    status = hal[prog->hal]->read_spare_data(buf, page, 0,
+        prog->chip_info.spare_size);
+    if (status == FLASH_STATUS_INVALID_CMD)
+    {
+        status = hal[prog->hal]->read_data(buf, page,
+            prog->chip_info.page_size, prog->chip_info.spare_size);
+    }
+
+    return status;
+}
+
+/* Address and length are in page data address space, only spare area of each
+ * page is sent. Bad blocks are not skipped, their marks are in spare area.
+ */
+static int _np_cmd_nand_read_spare(np_prog_t *prog)
+{
+    int ret;
+    static np_page_t page;
+    np_read_cmd_t *read_cmd;
+    np_read_ctx_t ctx;
+    uint64_t addr, len;
+    uint32_t page_size, spare_size, pages_in_block, status;
+
+    if (prog->rx_buf_len < sizeof(np_read_cmd_t))
+    {
+        ERROR_PRINT("Wrong buffer length for read spare command %lu\r\n",
+            prog->rx_buf_len);
+        return NP_ERR_LEN_INVALID;
+    }
+
+    read_cmd = (np_read_cmd_t *)prog->rx_buf;
+    addr = read_cmd->addr;
+    len = read_cmd->len;
+    page_size = prog->chip_info.page_size;
+    spare_size = prog->chip_info.spare_size;
+
+    DEBUG_PRINT("Read spare at 0x%" PRIx64 " 0x%" PRIx64 " bytes command\r\n",
+        addr, len);
+
+    if (!hal[prog->hal]->read_data || !spare_size)
+    {
+        ERROR_PRINT("Spare area read is not supported\r\n");
+        return NP_ERR_CMD_INVALID;
+    }
+
+    if (addr + len > prog->chip_info.total_size)
+    {
+        ERROR_PRINT("Read address 0x%" PRIx64 "+0x%" PRIx64
+            " is more then chip size 0x%" PRIx64 "\r\n", addr, len,
+            prog->chip_info.total_size);
+        return NP_ERR_ADDR_EXCEEDED;
+    }
+
+    if (addr % page_size)
+    {
+        ERROR_PRINT("Read address 0x%" PRIx64
+            " is not aligned to page size 0x%lx\r\n", addr, page_size);
+        return NP_ERR_ADDR_NOT_ALIGN;
+    }
+
+    if (!len)
+    {
+        ERROR_PRINT("Length is 0\r\n");
+        return NP_ERR_LEN_INVALID;
+    }
+
+    if (len % page_size)
+    {
+        ERROR_PRINT("Read length 0x%" PRIx64
+            " is not aligned to page size 0x%lx\r\n", len, page_size);
+        return NP_ERR_LEN_NOT_ALIGN;
+    }
+
+    if ((ret = np_ecc_calc_enable(prog, false)))
+        return ret;
+
+    pages_in_block = prog->chip_info.block_size / page_size;
     page.page = addr / page_size;
     page.offset = 0;
 
-    resp->code = NP_RESP_DATA;
+    /* Bad block addresses are reported in spare dump address space */
+    ctx.prog = prog;
+    ctx.addr = page.page * (uint64_t)spare_size;
+    ctx.len = len / page_size * spare_size;
+    ctx.page_size = spare_size;
+    ctx.block_size = pages_in_block * spare_size;
+    ctx.fsmc_ecc = false;
 
-    while (len)
+    while (ctx.len)
     {
-        if (addr >= total_size)
-        {
-            ERROR_PRINT("Read address 0x%" PRIx64
-                " is more then chip size 0x%" PRIx64 "\r\n", addr, total_size);
-            return NP_ERR_ADDR_EXCEEDED;
-        }
+        status = np_nand_read_spare_page(prog, page.buf, page.page);
+        if (np_nand_read_cb(page.buf, page.page, status, &ctx))
+            return NP_ERR_NAND_RD;
 
-        if (skip_bb && nand_bad_block_table_lookup(page.page))
-        {
-            DEBUG_PRINT("Skipped bad block at 0x%" PRIx64 "\r\n", addr);
-            if (np_send_bad_block_info(addr, block_size, true))
-                return -1;
+        page.page++;
+    }
 
-            /* On partial read do not count bad blocks */
-            if (read_cmd->len == total_size)
-                len -= block_size;
-            addr += block_size;
-            page.page += block_size / page_size;
-            continue;
-        }
+    return 0;
+}
 
-        if (np_nand_read(addr, &page, page_size, block_size, prog))
-            return NP_ERR_NAND_RD;
+static int np_cmd_nand_read_spare(np_prog_t *prog)
+{
+    int ret;
 
-        while (page.offset < page_size && len)
-        {
-            if (page_size - page.offset >= tx_data_len)
-                send_len = tx_data_len;
-            else
-                send_len = page_size - page.offset;
+    led_rd_set(true);
+    ret = _np_cmd_nand_read_spare(prog);
+    led_rd_set(false);
+
+    return ret;
+}
+
+static bool np_page_is_blank(const uint8_t *buf, uint32_t size)
+{
+    uint32_t i;
+    const uint32_t *word = (const uint32_t *)buf;
+
+    for (i = 0; i < size / sizeof(uint32_t); i++)
+    {
+        if (word[i] != 0xFFFFFFFF)
+            return false;
+    }
+
+    return true;
+}
+
+/* Finds used length of block range by scanning blocks from the end. Every
+ * page of a block is read until a non-blank one is found, so a block is
+ * erased only if all its pages are blank. Bad blocks are skipped, their
+ * marks are not data.
+ */
+static int _np_cmd_nand_blank_scan(np_prog_t *prog)
+{
+    static np_page_t page;
+    np_blank_scan_cmd_t *scan_cmd;
+    np_resp_used_len_t resp;
+    uint64_t addr, len;
+    uint32_t status, block, first_block, block_size, pages_in_block, page_num;
+    int ret;
+
+    if (prog->rx_buf_len < sizeof(np_blank_scan_cmd_t))
+    {
+        ERROR_PRINT("Wrong buffer length for blank scan command %lu\r\n",
+            prog->rx_buf_len);
+        return NP_ERR_LEN_INVALID;
+    }
+
+    scan_cmd = (np_blank_scan_cmd_t *)prog->rx_buf;
+    addr = scan_cmd->addr;
+    len = scan_cmd->len;
+    block_size = prog->chip_info.block_size;
 
-            if (send_len > len)
-                send_len = len;
+    DEBUG_PRINT("Blank scan at 0x%" PRIx64 " 0x%" PRIx64 " bytes command\r\n",
+        addr, len);
 
-            memcpy(resp->data, page.buf + page.offset, send_len);
+    if (addr + len > prog->chip_info.total_size)
+    {
+        ERROR_PRINT("Scan address 0x%" PRIx64 "+0x%" PRIx64
+            " is more then chip size 0x%" PRIx64 "\r\n", addr, len,
+            prog->chip_info.total_size);
+        return NP_ERR_ADDR_EXCEEDED;
+    }
 
-            while (!np_comm_cb->send_ready());
+    if (addr % block_size)
+    {
+        ERROR_PRINT("Address 0x%" PRIx64
+            " is not aligned to block size 0x%lx\r\n", addr, block_size);
+        return NP_ERR_ADDR_NOT_ALIGN;
+    }
 
-            resp->info = send_len;
-            if (np_comm_cb->send(np_packet_send_buf,
-                resp_header_size + send_len))
+    if (!len || len % block_size)
+    {
+        ERROR_PRINT("Length 0x%" PRIx64
+            " is not aligned to block size 0x%lx\r\n", len, block_size);
+        return NP_ERR_LEN_NOT_ALIGN;
+    }
+
+    /* Bad block marks are not data */
+    if (!prog->bb_is_read && (ret = _np_cmd_read_bad_blocks(prog, false)))
+        return ret;
+
+    pages_in_block = block_size / prog->chip_info.page_size;
+    first_block = addr / block_size;
+    block = (addr + len) / block_size;
+
+    resp.used_len = 0;
+    while (block > first_block && !resp.used_len)
+    {
+        block--;
+
+        if (nand_bad_block_table_lookup(block * pages_in_block))
+            continue;
+
+        /* Blank block takes a read of each page, host is kept alive */
+        if (np_send_progress((uint64_t)block * block_size))
+            return NP_ERR_INTERNAL;
+
+        /* Pages of block may be programmed partially, all are checked */
+        for (page_num = 0; page_num < pages_in_block; page_num++)
+        {
+            status = hal[prog->hal]->read_page(page.buf,
+                block * pages_in_block + page_num, prog->chip_info.page_size);
+            if (status != FLASH_STATUS_READY)
             {
-                return -1;
+                ERROR_PRINT("NAND read error at page 0x%lx\r\n",
+                    block * pages_in_block + page_num);
+                return NP_ERR_NAND_RD;
             }
 
-            page.offset += send_len;
-            len -= send_len;
+            if (!np_page_is_blank(page.buf, prog->chip_info.page_size))
+            {
+                resp.used_len = (uint64_t)(block + 1 - first_block) *
+                    block_size;
+                break;
+            }
         }
-
-        addr += page_size;
-        page.offset = 0;
-        page.page++;
     }
 
+    resp.header.code = NP_RESP_DATA;
+    resp.header.info = sizeof(resp) - sizeof(resp.header);
+
+    if (np_comm_cb)
+        np_comm_cb->send((uint8_t *)&resp, sizeof(resp));
+
     return 0;
 }
 
-static int np_cmd_nand_read(np_prog_t *prog)
+static int np_cmd_nand_blank_scan(np_prog_t *prog)
 {
     int ret;
 
     led_rd_set(true);
-    ret = _np_cmd_nand_read(prog);
+    ret = _np_cmd_nand_blank_scan(prog);
     led_rd_set(false);
 
     return ret;
@@ -1081,15 +2278,17 @@ static int np_cmd_nand_conf(np_prog_t *prog)
 
     prog->hal = conf_cmd->hal;
     if (hal[prog->hal]->init(conf_cmd->hal_conf,
-        prog->rx_buf_len - sizeof(np_conf_cmd_t)))
+        prog->rx_buf_len - sizeof(np_conf_cmd_t), &prog->chip_info))
     {
-        ERROR_PRINT("Wrong buffer length for hal configuration command %lu\r\n",
+        ERROR_PRINT("Wrong hal configuration, command length %lu\r\n",
             prog->rx_buf_len);
+        prog->chip_is_conf = 0;
         return NP_ERR_LEN_INVALID;
     }
 
     nand_bad_block_table_init();
     prog->bb_is_read = 0;
+    prog->region_num = 0;
 
     return np_send_ok_status();
 }
@@ -1421,6 +2620,10 @@ static np_cmd_handler_t cmd_handler[] =
     { NP_CMD_FW_UPDATE_S, 0, np_cmd_fw_update },
     { NP_CMD_FW_UPDATE_D, 0, np_cmd_fw_update },
     { NP_CMD_FW_UPDATE_E, 0, np_cmd_fw_update },    
+    { NP_CMD_NAND_READ_SPARE, 1, np_cmd_nand_read_spare },
+    { NP_CMD_NAND_REGIONS, 1, np_cmd_nand_regions },
+    { NP_CMD_NAND_BLANK_SCAN, 1, np_cmd_nand_blank_scan },
+    { NP_CMD_NAND_WRITE_SKIP, 1, np_cmd_nand_write },
 };
 
 static bool np_cmd_is_valid(np_cmd_code_t code)
@@ -1461,6 +2664,10 @@ static void np_packet_handler(np_prog_t *prog)
 
     do
     {
+        /* Next command is handled after erase is completed */
+        if (prog->erase.in_progress)
+            break;
+
         prog->rx_buf_len = np_comm_cb->peek(&prog->rx_buf);
         if (!prog->rx_buf_len)
             break;
@@ -1482,6 +2689,13 @@ static void np_nand_handler(np_prog_t *prog)
         if (np_nand_handle_status(prog))
             np_send_error(NP_ERR_NAND_WR);
     }
+
+    if (prog->erase.in_progress && np_nand_erase_handler(prog))
+    {
+        prog->erase.in_progress = 0;
+        led_wr_set(false);
+        np_send_error(NP_ERR_NAND_ERASE);
+    }
 }
 
 void np_init()
@@ -131,7 +131,8 @@ static uint16_t spi_flash_get_baud_rate_prescaler(uint32_t spi_freq_khz)
         return SPI_BaudRatePrescaler_256;
 }
 
-static int spi_flash_init(void *conf, uint32_t conf_size)
+static int spi_flash_init(void *conf, uint32_t conf_size,
+    chip_info_t *chip_info)
 {
     SPI_InitTypeDef spi_init;
 
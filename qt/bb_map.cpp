@@ -0,0 +1,201 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "bb_map.h"
+#include <QDebug>
+#include <QFile>
+#include <QStringList>
+#include <algorithm>
+
+#define BB_MAP_MAGIC "nando-bbm 1"
+
+BbMap::BbMap()
+{
+    init(0, 0, 0);
+}
+
+void BbMap::init(quint64 blockSize, quint64 startBlock, quint64 blocks)
+{
+    this->blockSize = blockSize;
+    this->startBlock = startBlock;
+    this->blocks = blocks;
+    skipped.clear();
+    skipPos.clear();
+}
+
+void BbMap::updateSkipPos()
+{
+    skipPos.resize(skipped.size());
+    for (size_t i = 0; i < skipped.size(); i++)
+        skipPos[i] = skipped[i] - startBlock - i;
+}
+
+void BbMap::addSkipped(quint64 block)
+{
+    auto it = std::lower_bound(skipped.begin(), skipped.end(), block);
+
+    if (block < startBlock || (it != skipped.end() && *it == block))
+        return;
+
+    /* Blocks are reported in ascending order, so it is usually appended */
+    if (it == skipped.end())
+    {
+        skipped.push_back(block);
+        skipPos.push_back(block - startBlock - (skipped.size() - 1));
+        return;
+    }
+
+    skipped.insert(it, block);
+    updateSkipPos();
+}
+
+quint64 BbMap::physicalBlock(quint64 logical) const
+{
+    return startBlock + logical + (std::upper_bound(skipPos.begin(),
+        skipPos.end(), logical) - skipPos.begin());
+}
+
+int BbMap::logicalBlock(quint64 physical, quint64 &logical) const
+{
+    auto it = std::lower_bound(skipped.begin(), skipped.end(), physical);
+
+    if (physical < startBlock || (it != skipped.end() && *it == physical))
+        return -1;
+
+    logical = physical - startBlock - (it - skipped.begin());
+    if (logical >= blocks)
+        return -1;
+
+    return 0;
+}
+
+quint64 BbMap::physicalAddr(quint64 logicalAddr) const
+{
+    if (!blockSize)
+        return logicalAddr;
+
+    return physicalBlock(logicalAddr / blockSize) * blockSize +
+        logicalAddr % blockSize;
+}
+
+quint64 BbMap::getBlockSize() const
+{
+    return blockSize;
+}
+
+quint64 BbMap::getStartBlock() const
+{
+    return startBlock;
+}
+
+quint64 BbMap::getBlocks() const
+{
+    return blocks;
+}
+
+const std::vector<quint64> &BbMap::getSkipped() const
+{
+    return skipped;
+}
+
+bool BbMap::isSameLayout(const BbMap &map) const
+{
+    quint64 end = physicalBlock(blocks);
+    auto thisEnd = std::lower_bound(skipped.begin(), skipped.end(), end);
+    auto mapEnd = std::lower_bound(map.skipped.begin(), map.skipped.end(),
+        end);
+
+    if (blockSize != map.blockSize || startBlock != map.startBlock)
+        return false;
+
+    return thisEnd - skipped.begin() == mapEnd - map.skipped.begin() &&
+        std::equal(skipped.begin(), thisEnd, map.skipped.begin());
+}
+
+int BbMap::save(const QString &fileName) const
+{
+    QFile file(fileName);
+    QString text;
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate |
+        QIODevice::Text))
+    {
+        qCritical() << "Failed to open file:" << fileName << ", error:" <<
+            file.errorString();
+        return -1;
+    }
+
+    text = QString(BB_MAP_MAGIC "\nblock_size 0x%1\nstart_block 0x%2\n"
+        "blocks 0x%3\n").arg(blockSize, 0, 16).arg(startBlock, 0, 16)
+        .arg(blocks, 0, 16);
+    for (quint64 block : skipped)
+        text += QString("skipped 0x%1\n").arg(block, 0, 16);
+
+    if (file.write(text.toLatin1()) < 0)
+    {
+        qCritical() << "Failed to write file:" << fileName << ", error:" <<
+            file.errorString();
+        return -1;
+    }
+
+    return 0;
+}
+
+int BbMap::load(const QString &fileName)
+{
+    QFile file(fileName);
+    QStringList lines;
+    quint64 value;
+    bool isOk;
+
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return -1;
+
+    lines = QString::fromLatin1(file.readAll()).split('\n');
+    if (lines.empty() || lines[0].trimmed() != BB_MAP_MAGIC)
+    {
+        qCritical() << "File" << fileName << "is not bad block map";
+        return -1;
+    }
+
+    init(0, 0, 0);
+    for (int i = 1; i < lines.size(); i++)
+    {
+        QStringList fields = lines[i].simplified().split(' ');
+
+        if (fields.size() == 1 && fields[0].isEmpty())
+            continue;
+
+        value = fields.size() == 2 ? fields[1].toULongLong(&isOk, 0) : 0;
+        if (fields.size() != 2 || !isOk)
+        {
+            qCritical() << "Wrong line of bad block map" << fileName << ":" <<
+                lines[i];
+            return -1;
+        }
+
+        if (fields[0] == "block_size")
+            blockSize = value;
+        else if (fields[0] == "start_block")
+            startBlock = value;
+        else if (fields[0] == "blocks")
+            blocks = value;
+        else if (fields[0] == "skipped")
+            skipped.push_back(value);
+    }
+
+    std::sort(skipped.begin(), skipped.end());
+    skipped.erase(std::unique(skipped.begin(), skipped.end()), skipped.end());
+    skipped.erase(skipped.begin(), std::lower_bound(skipped.begin(),
+        skipped.end(), startBlock));
+    updateSkipPos();
+
+    return 0;
+}
+
+QString BbMap::mapFileName(const QString &dataFileName)
+{
+    return dataFileName + ".bbm";
+}
@@ -0,0 +1,49 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef BB_MAP_H
+#define BB_MAP_H
+
+#include <QString>
+#include <vector>
+
+/* Map of logical blocks of data read or written with bad blocks skipped to
+ * physical blocks of chip. Only skipped blocks are stored, logical block N
+ * is at physical block startBlock + N plus the number of skipped blocks
+ * before it. Map is saved next to data file as <file>.bbm.
+ */
+class BbMap
+{
+    quint64 blockSize;
+    quint64 startBlock;
+    quint64 blocks;
+    /* Skipped physical blocks in ascending order and logical block at which
+     * each of them is skipped.
+     */
+    std::vector<quint64> skipped;
+    std::vector<quint64> skipPos;
+
+    void updateSkipPos();
+
+public:
+    BbMap();
+    void init(quint64 blockSize, quint64 startBlock, quint64 blocks);
+    void addSkipped(quint64 block);
+    quint64 physicalBlock(quint64 logical) const;
+    /* Returns -1 if physical block is skipped or is out of map */
+    int logicalBlock(quint64 physical, quint64 &logical) const;
+    quint64 physicalAddr(quint64 logicalAddr) const;
+    quint64 getBlockSize() const;
+    quint64 getStartBlock() const;
+    quint64 getBlocks() const;
+    const std::vector<quint64> &getSkipped() const;
+    /* Whether both maps skip the same blocks in range of this map */
+    bool isSameLayout(const BbMap &map) const;
+    int save(const QString &fileName) const;
+    int load(const QString &fileName);
+    static QString mapFileName(const QString &dataFileName);
+};
+
+#endif // BB_MAP_H
@@ -0,0 +1,221 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "chip_cache.h"
+#include <QDebug>
+#include <QTimer>
+#include <algorithm>
+#include <cstring>
+
+ChipCache::ChipCache(QObject *parent) : QObject(parent)
+{
+    prog = nullptr;
+    chipSize = 0;
+    pageSize = 0;
+    viewPos = 0;
+    viewLen = 0;
+    readIndex = 0;
+    readCount = 0;
+    isReading = false;
+    isStopped = true;
+}
+
+void ChipCache::start(Programmer *prog, quint64 chipSize, uint32_t pageSize)
+{
+    this->prog = prog;
+    this->chipSize = chipSize;
+    this->pageSize = pageSize;
+    pages.clear();
+    pageIndex.clear();
+    queue.clear();
+    failedPages.clear();
+    viewPos = 0;
+    viewLen = 0;
+    isStopped = false;
+}
+
+void ChipCache::stop()
+{
+    isStopped = true;
+    queue.clear();
+
+    /* Pending read owns programmer until it is completed */
+    if (!isReading)
+        QTimer::singleShot(0, this, &ChipCache::stopped);
+}
+
+bool ChipCache::isStarted()
+{
+    return !isStopped;
+}
+
+quint64 ChipCache::size()
+{
+    return chipSize;
+}
+
+const ChipCache::Page *ChipCache::findPage(quint64 index)
+{
+    auto it = pageIndex.find(index);
+
+    if (it == pageIndex.end())
+        return nullptr;
+
+    pages.splice(pages.begin(), pages, it->second);
+
+    return &pages.front();
+}
+
+/* Page is loaded or it failed to read */
+bool ChipCache::isSkipped(quint64 index)
+{
+    return pageIndex.find(index) != pageIndex.end() ||
+        failedPages.find(index) != failedPages.end();
+}
+
+void ChipCache::addPage(quint64 index, const uint8_t *data)
+{
+    if (pageIndex.find(index) != pageIndex.end())
+        return;
+
+    if (pages.size() >= maxPages)
+    {
+        pageIndex.erase(pages.back().index);
+        pages.pop_back();
+    }
+
+    pages.push_front({ index, QByteArray(reinterpret_cast<const char *>(data),
+        static_cast<int>(pageSize)) });
+    pageIndex[index] = pages.begin();
+}
+
+QByteArray ChipCache::read(quint64 pos, qint64 len,
+    std::vector<bool> &isLoaded)
+{
+    QByteArray buf;
+
+    isLoaded.clear();
+    if (!pageSize || pos >= chipSize || len <= 0)
+        return buf;
+
+    len = std::min<qint64>(len, chipSize - pos);
+    buf.fill('\0', len);
+    isLoaded.assign(len, false);
+
+    for (qint64 off = 0; off < len;)
+    {
+        quint64 index = (pos + off) / pageSize;
+        qint64 pageOff = (pos + off) % pageSize;
+        qint64 chunk = std::min<qint64>(len - off, pageSize - pageOff);
+        const Page *page = findPage(index);
+
+        if (page)
+        {
+            memcpy(buf.data() + off, page->data.constData() + pageOff, chunk);
+            std::fill(isLoaded.begin() + off, isLoaded.begin() + off + chunk,
+                true);
+        }
+        off += chunk;
+    }
+
+    return buf;
+}
+
+void ChipCache::request(quint64 pos, qint64 len, bool isForward)
+{
+    quint64 pageCount, first, last;
+
+    if (isStopped || !pageSize || pos >= chipSize || len <= 0)
+        return;
+
+    pageCount = (chipSize + pageSize - 1) / pageSize;
+    first = pos / pageSize;
+    last = std::min<quint64>((pos + len - 1) / pageSize, pageCount - 1);
+
+    /* Failed pages are not requested again until view is changed */
+    if (pos != viewPos || len != viewLen)
+    {
+        failedPages.clear();
+        viewPos = pos;
+        viewLen = len;
+    }
+
+    /* Only the last view matters, older requests are dropped */
+    queue.clear();
+    for (quint64 i = first; i <= last; i++)
+        queue.push_back(i);
+
+    for (quint64 i = 1; i <= prefetchPages; i++)
+    {
+        if (isForward && last + i < pageCount)
+            queue.push_back(last + i);
+        else if (!isForward && first >= i)
+            queue.push_back(first - i);
+    }
+
+    readNext();
+}
+
+void ChipCache::readNext()
+{
+    if (isReading || isStopped)
+        return;
+
+    while (!queue.empty() && isSkipped(queue.front()))
+        queue.pop_front();
+    if (queue.empty())
+        return;
+
+    /* Missing pages following in queue are read by one command */
+    readIndex = queue.front();
+    readCount = 0;
+    while (!queue.empty() && queue.front() == readIndex + readCount &&
+        readCount < maxReadPages && !isSkipped(queue.front()))
+    {
+        queue.pop_front();
+        readCount++;
+    }
+
+    isReading = true;
+    buffer.buf.clear();
+    connect(prog, SIGNAL(readChipCompleted(quint64)), this,
+        SLOT(slotReadCompleted(quint64)));
+    prog->readChipPages(&buffer, readIndex * pageSize, readCount * pageSize);
+}
+
+void ChipCache::slotReadCompleted(quint64 ret)
+{
+    disconnect(prog, SIGNAL(readChipCompleted(quint64)), this,
+        SLOT(slotReadCompleted(quint64)));
+    isReading = false;
+
+    if (ret == UINT64_MAX)
+    {
+        qCritical() << "Failed to read chip at" << readIndex * pageSize;
+        for (quint64 i = 0; i < readCount; i++)
+            failedPages.insert(readIndex + i);
+        queue.clear();
+    }
+    else
+    {
+        std::unique_lock<std::mutex> lck(buffer.mutex);
+        quint64 count = buffer.buf.size() / pageSize;
+
+        for (quint64 i = 0; i < count && i < readCount; i++)
+            addPage(readIndex + i, buffer.buf.data() + i * pageSize);
+        buffer.buf.clear();
+    }
+
+    if (isStopped)
+    {
+        emit stopped();
+        return;
+    }
+
+    /* Nothing is loaded on failure, view is not repainted to request it */
+    if (ret != UINT64_MAX)
+        emit pageLoaded();
+    readNext();
+}
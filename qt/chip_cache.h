@@ -0,0 +1,81 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef CHIP_CACHE_H
+#define CHIP_CACHE_H
+
+#include "programmer.h"
+#include "sync_buffer.h"
+#include <QByteArray>
+#include <QObject>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/* Pages of connected chip read on demand and kept in LRU cache. Only one
+ * read command is sent at a time, pages requested last are read first.
+ */
+class ChipCache : public QObject
+{
+    Q_OBJECT
+
+    typedef struct
+    {
+        quint64 index;
+        QByteArray data;
+    } Page;
+
+    const size_t maxPages = 4096;
+    /* Pages read by one command */
+    const quint64 maxReadPages = 16;
+    /* Pages read ahead in scroll direction */
+    const quint64 prefetchPages = 32;
+
+    Programmer *prog;
+    SyncBuffer buffer;
+    quint64 chipSize;
+    uint32_t pageSize;
+    /* Most recently used page is the first */
+    std::list<Page> pages;
+    std::unordered_map<quint64, std::list<Page>::iterator> pageIndex;
+    std::deque<quint64> queue;
+    /* Pages failed to read in the current view */
+    std::unordered_set<quint64> failedPages;
+    quint64 viewPos;
+    qint64 viewLen;
+    quint64 readIndex;
+    quint64 readCount;
+    bool isReading;
+    bool isStopped;
+
+    const Page *findPage(quint64 index);
+    bool isSkipped(quint64 index);
+    void addPage(quint64 index, const uint8_t *data);
+    void readNext();
+
+public:
+    explicit ChipCache(QObject *parent = nullptr);
+    void start(Programmer *prog, quint64 chipSize, uint32_t pageSize);
+    /* Emits stopped when programmer is free */
+    void stop();
+    bool isStarted();
+    quint64 size();
+    /* Bytes of pages not read yet are marked in isLoaded */
+    QByteArray read(quint64 pos, qint64 len, std::vector<bool> &isLoaded);
+    /* Reads missing pages of range and next pages in scroll direction */
+    void request(quint64 pos, qint64 len, bool isForward);
+
+signals:
+    void pageLoaded();
+    void stopped();
+
+private slots:
+    void slotReadCompleted(quint64 ret);
+};
+
+#endif // CHIP_CACHE_H
@@ -84,3 +84,10 @@ uint8_t ChipInfo::getHal()
 {
     return hal;
 }
+
+int ChipInfo::getEccLayout(EccLayout &layout)
+{
+    (void)layout;
+
+    return -1;
+}
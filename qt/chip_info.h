@@ -6,6 +6,8 @@
 #ifndef CHIP_INFO_H
 #define CHIP_INFO_H
 
+#include "ecc.h"
+
 #include <QString>
 
 class ChipInfo
@@ -45,6 +47,7 @@ public:
     virtual const QByteArray &getHalConf() = 0;
     virtual quint64 getParam(uint32_t num) = 0;
     virtual int setParam(uint32_t num, quint64 value) = 0;
+    virtual int getEccLayout(EccLayout &layout);
 };
 
 #endif // CHIP_INFO_H
@@ -22,9 +22,16 @@ enum
     CMD_ACTIVE_IMAGE_GET = 0x09,
     CMD_FW_UPDATE_S      = 0x0a,
     CMD_FW_UPDATE_D      = 0x0b,
-    CMD_FW_UPDATE_E      = 0x0c
+    CMD_FW_UPDATE_E      = 0x0c,
+    CMD_NAND_READ_SPARE  = 0x0d,
+    CMD_NAND_REGIONS     = 0x0e,
+    CMD_NAND_BLANK_SCAN  = 0x0f,
+    CMD_NAND_WRITE_SKIP  = 0x10
 };
 
+/* Regions fit in one USB packet */
+#define CMD_MAX_REGIONS 7
+
 typedef struct __attribute__((__packed__))
 {
     uint8_t code;
@@ -35,6 +42,10 @@ typedef struct __attribute__((__packed__))
     uint8_t skipBB : 1;
     uint8_t incSpare : 1;
     uint8_t enableHwEcc: 1;
+    uint8_t erase: 1;
+    uint8_t fsmcEcc: 1;
+    uint8_t regions: 1;
+    uint8_t planes: 1;
 } CmdFlags;
 
 typedef struct __attribute__((__packed__))
@@ -67,6 +78,12 @@ typedef struct __attribute__((__packed__))
     uint8_t len;
 } WriteDataCmd;
 
+typedef struct __attribute__((__packed__))
+{
+    Cmd cmd;
+    uint32_t pages;
+} WriteSkipCmd;
+
 typedef struct __attribute__((__packed__))
 {
     Cmd cmd;
@@ -83,6 +100,26 @@ typedef struct __attribute__((__packed__))
     uint8_t bbMarkOff;
 } ConfCmd;
 
+typedef struct __attribute__((__packed__))
+{
+    uint32_t block;
+    uint32_t blocks;
+} CmdRegion;
+
+typedef struct __attribute__((__packed__))
+{
+    Cmd cmd;
+    uint8_t count;
+    CmdRegion region[CMD_MAX_REGIONS];
+} RegionsCmd;
+
+typedef struct __attribute__((__packed__))
+{
+    Cmd cmd;
+    uint64_t addr;
+    uint64_t len;
+} BlankScanCmd;
+
 enum
 {
     RESP_DATA   = 0x00,
@@ -97,6 +134,7 @@ typedef enum
     STATUS_WRITE_ACK = 0x03,
     STATUS_BB_SKIP   = 0x04,
     STATUS_PROGRESS  = 0x05,
+    STATUS_ECC       = 0x06,
 } StatusData;
 
 typedef struct __attribute__((__packed__))
@@ -142,6 +180,13 @@ typedef struct __attribute__((__packed__))
     uint32_t size;
 } RespBadBlock;
 
+typedef struct __attribute__((__packed__))
+{
+    RespHeader header;
+    uint64_t addr;
+    uint32_t ecc;
+} RespEcc;
+
 typedef struct __attribute__((__packed__))
 {
     RespHeader header;
@@ -0,0 +1,129 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "compress_pool.h"
+
+CompressPool::CompressPool()
+{
+    nextCompress = 0;
+    isStopped = true;
+    isError = false;
+}
+
+CompressPool::~CompressPool()
+{
+    finish();
+}
+
+int CompressPool::start(const CompressFunc &compress, const WriteFunc &write)
+{
+    unsigned threadNum = std::thread::hardware_concurrency();
+
+    finish();
+
+    this->compress = compress;
+    this->write = write;
+    chunks.clear();
+    nextCompress = 0;
+    isStopped = false;
+    isError = false;
+
+    /* One core is left for reader and writer */
+    if (threadNum > 1)
+        threadNum--;
+    if (!threadNum)
+        threadNum = 1;
+
+    for (unsigned i = 0; i < threadNum; i++)
+        workers.emplace_back(&CompressPool::worker, this);
+    writer = std::thread(&CompressPool::writerLoop, this);
+
+    return 0;
+}
+
+void CompressPool::submit(std::vector<uint8_t> &data, uint32_t flags)
+{
+    std::unique_lock<std::mutex> lck(mutex);
+
+    chunks.emplace_back();
+    chunks.back().data.swap(data);
+    chunks.back().flags = flags;
+    chunks.back().crc = 0;
+    chunks.back().isDone = false;
+    cv.notify_all();
+}
+
+/* Deque references stay valid while other chunks are added at the end,
+ * chunk is removed by writer only after it is done.
+ */
+void CompressPool::worker()
+{
+    std::unique_lock<std::mutex> lck(mutex);
+
+    while (true)
+    {
+        cv.wait(lck, [this]
+            { return isStopped || nextCompress < chunks.size(); });
+        if (nextCompress >= chunks.size())
+            break;
+
+        Chunk &chunk = chunks[nextCompress++];
+
+        lck.unlock();
+        int ret = compress(chunk);
+        lck.lock();
+
+        if (ret)
+            isError = true;
+        chunk.isDone = true;
+        cv.notify_all();
+    }
+}
+
+void CompressPool::writerLoop()
+{
+    std::unique_lock<std::mutex> lck(mutex);
+
+    while (true)
+    {
+        cv.wait(lck, [this] { return (isStopped && chunks.empty()) ||
+            (!chunks.empty() && chunks.front().isDone); });
+        if (chunks.empty())
+            break;
+
+        Chunk &chunk = chunks.front();
+        /* Error is set by compress threads under the lock */
+        bool isFailed = isError;
+
+        lck.unlock();
+        int ret = isFailed ? -1 : write(chunk);
+        lck.lock();
+
+        if (ret)
+            isError = true;
+        chunks.pop_front();
+        nextCompress--;
+        cv.notify_all();
+    }
+}
+
+int CompressPool::finish()
+{
+    if (!writer.joinable())
+        return 0;
+
+    {
+        std::unique_lock<std::mutex> lck(mutex);
+        isStopped = true;
+        cv.notify_all();
+    }
+
+    for (std::thread &t : workers)
+        t.join();
+    workers.clear();
+    writer.join();
+
+    return isError ? -1 : 0;
+}
@@ -0,0 +1,62 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef COMPRESS_POOL_H
+#define COMPRESS_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Compresses chunks on worker threads and passes results to writer thread
+ * in submit order. Submit never waits, so producer is not slowed down by
+ * compression.
+ */
+class CompressPool
+{
+public:
+    typedef struct
+    {
+        std::vector<uint8_t> data;
+        std::vector<uint8_t> packed;
+        uint32_t flags;
+        uint32_t crc;
+        bool isDone;
+    } Chunk;
+
+    /* Both return 0 on success */
+    typedef std::function<int(Chunk &chunk)> CompressFunc;
+    typedef std::function<int(Chunk &chunk)> WriteFunc;
+
+private:
+    CompressFunc compress;
+    WriteFunc write;
+    std::vector<std::thread> workers;
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable cv;
+    /* Chunks from the first not written one */
+    std::deque<Chunk> chunks;
+    size_t nextCompress;
+    bool isStopped;
+    bool isError;
+
+    void worker();
+    void writerLoop();
+
+public:
+    CompressPool();
+    ~CompressPool();
+    int start(const CompressFunc &compress, const WriteFunc &write);
+    void submit(std::vector<uint8_t> &data, uint32_t flags);
+    /* Waits until all chunks are written */
+    int finish();
+};
+
+#endif // COMPRESS_POOL_H
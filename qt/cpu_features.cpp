@@ -0,0 +1,52 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "cpu_features.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_FEATURES_X86
+#endif
+
+struct CpuFeatures
+{
+    bool sse2;
+    bool sse42;
+    bool avx2;
+
+    CpuFeatures()
+    {
+        sse2 = false;
+        sse42 = false;
+        avx2 = false;
+#ifdef CPU_FEATURES_X86
+        __builtin_cpu_init();
+        sse2 = __builtin_cpu_supports("sse2");
+        sse42 = __builtin_cpu_supports("sse4.2");
+        avx2 = __builtin_cpu_supports("avx2");
+#endif
+    }
+};
+
+/* Kernels are selected by static objects of other units, so features are
+ * probed on first use instead of by a static object of this unit.
+ */
+bool cpuHasFeature(CpuFeature feature)
+{
+    static const CpuFeatures features;
+
+    switch (feature)
+    {
+    case CPU_FEATURE_NONE:
+        return true;
+    case CPU_FEATURE_SSE2:
+        return features.sse2;
+    case CPU_FEATURE_SSE42:
+        return features.sse42;
+    case CPU_FEATURE_AVX2:
+        return features.avx2;
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,37 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#include <cstddef>
+
+enum CpuFeature
+{
+    CPU_FEATURE_NONE,
+    CPU_FEATURE_SSE2,
+    CPU_FEATURE_SSE42,
+    CPU_FEATURE_AVX2,
+};
+
+/* Host CPU is probed once, false for any feature on non-x86 host */
+bool cpuHasFeature(CpuFeature feature);
+
+/* Kernels are listed from the fastest one, each has the feature it needs.
+ * The last kernel must need no feature.
+ */
+template <typename Kernel, size_t N>
+const Kernel &cpuKernelSelect(const Kernel (&kernels)[N])
+{
+    for (size_t i = 0; i + 1 < N; i++)
+    {
+        if (cpuHasFeature(kernels[i].feature))
+            return kernels[i];
+    }
+
+    return kernels[N - 1];
+}
+
+#endif // CPU_FEATURES_H
@@ -0,0 +1,108 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "crc32c.h"
+#include "cpu_features.h"
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#define CRC32C_X86
+#endif
+
+#define CRC32C_POLY 0x82F63B78
+
+typedef uint32_t (*Crc32cFunc)(uint32_t crc, const uint8_t *buf, size_t len);
+
+/* Slicing-by-8 tables */
+static uint32_t crc32cTable[8][256];
+
+static uint32_t crc32cSw(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    for (; len >= 8; len -= 8, buf += 8)
+    {
+        uint32_t lo, hi;
+
+        memcpy(&lo, buf, sizeof(lo));
+        memcpy(&hi, buf + 4, sizeof(hi));
+        lo ^= crc;
+        crc = crc32cTable[7][lo & 0xFF] ^ crc32cTable[6][(lo >> 8) & 0xFF] ^
+            crc32cTable[5][(lo >> 16) & 0xFF] ^ crc32cTable[4][lo >> 24] ^
+            crc32cTable[3][hi & 0xFF] ^ crc32cTable[2][(hi >> 8) & 0xFF] ^
+            crc32cTable[1][(hi >> 16) & 0xFF] ^ crc32cTable[0][hi >> 24];
+    }
+
+    while (len--)
+        crc = crc32cTable[0][(crc ^ *buf++) & 0xFF] ^ (crc >> 8);
+
+    return crc;
+}
+
+#ifdef CRC32C_X86
+__attribute__((target("sse4.2")))
+static uint32_t crc32cHw(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    uint64_t crc64 = crc;
+
+    for (; len >= 8; len -= 8, buf += 8)
+    {
+        uint64_t v;
+
+        memcpy(&v, buf, sizeof(v));
+        crc64 = _mm_crc32_u64(crc64, v);
+    }
+
+    crc = static_cast<uint32_t>(crc64);
+    while (len--)
+        crc = _mm_crc32_u8(crc, *buf++);
+
+    return crc;
+}
+#endif
+
+static struct Crc32cTableInit
+{
+    Crc32cTableInit()
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t crc = i;
+
+            for (int j = 0; j < 8; j++)
+                crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+            crc32cTable[0][i] = crc;
+        }
+
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            for (int j = 1; j < 8; j++)
+            {
+                uint32_t prev = crc32cTable[j - 1][i];
+                crc32cTable[j][i] = (prev >> 8) ^ crc32cTable[0][prev & 0xFF];
+            }
+        }
+    }
+} tableInit;
+
+struct Crc32cKernel
+{
+    CpuFeature feature;
+    Crc32cFunc func;
+};
+
+static const Crc32cKernel kernels[] =
+{
+#ifdef CRC32C_X86
+    { CPU_FEATURE_SSE42, crc32cHw },
+#endif
+    { CPU_FEATURE_NONE, crc32cSw },
+};
+
+static const Crc32cKernel &kernel = cpuKernelSelect(kernels);
+
+uint32_t crc32c(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    return ~kernel.func(~crc, buf, len);
+}
@@ -0,0 +1,15 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+/* CRC-32C (Castagnoli), crc is the value of previous data or 0 */
+uint32_t crc32c(uint32_t crc, const uint8_t *buf, size_t len);
+
+#endif // CRC32C_H
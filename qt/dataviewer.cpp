@@ -1,13 +1,18 @@
 #include "dataviewer.h"
+#include "image_device.h"
 
 #include <QPainter>
 #include <QScrollBar>
+#include <QTimer>
 
 DataViewer::DataViewer(QWidget *parent):
     QAbstractScrollArea(parent)
 {
-    ioDevice = new QBuffer(this);
     size = 0;
+    startPos = 0;
+    lastStartPos = 0;
+    isScrollForward = true;
+    chipCache = nullptr;
     init();
     connect(verticalScrollBar(), &QScrollBar::valueChanged, this,
           &DataViewer::adjustContent);
@@ -53,44 +58,86 @@ int DataViewer::asciiWidth()
     return (mBytesPerLine + 1) * pxWidth;
 }
 
-QByteArray DataViewer::data(qint64 pos, qint64 count)
+void DataViewer::setFile(QString filePath)
 {
-    QByteArray buffer;
-
-    if (pos >= size)
-        return buffer;
-
-    if (count < 0)
-        count = size;
-    else if ((pos + count) > size)
-        count = size - pos;
-
-    if (ioDevice->open(QIODevice::ReadOnly))
+    setChip(nullptr);
+    cache.clear();
+    imageDevice.reset();
+    if (ImageDevice::isContainer(filePath))
     {
-        ioDevice->seek(pos);
-        buffer = ioDevice->read(count);
-        ioDevice->close();
+        /* Container is shown as plain image */
+        imageDevice.reset(ImageDevice::create(filePath));
+        if (imageDevice)
+            cache.setDevice(imageDevice.get(), false);
     }
-    return buffer;
+    else
+    {
+        /* Mapped file would show holes as zeroes */
+        file.setFileName(filePath);
+        cache.setDevice(&file, !file.isHolesErased());
+    }
+    size = cache.size();
+    lastStartPos = 0;
+    isScrollForward = true;
+    init();
+    adjustContent();
 }
 
-void DataViewer::setFile(QString filePath)
+void DataViewer::closeFile()
 {
-    file.setFileName(filePath);
-    if (file.open(QIODevice::ReadOnly))
-    {
-        size = file.size();
-        ioDevice = &file;
-        ioDevice->close();
-    }
-    else
+    setChip(nullptr);
+    cache.clear();
+    imageDevice.reset();
+    size = 0;
+    init();
+    adjustContent();
+}
+
+/* Chip is shown instead of file until file is set */
+void DataViewer::setChip(ChipCache *chipCache)
+{
+    if (this->chipCache)
     {
-        size = 0;
+        disconnect(this->chipCache, &ChipCache::pageLoaded, this,
+            &DataViewer::adjustContent);
     }
+
+    this->chipCache = chipCache;
+    if (!chipCache)
+        return;
+
+    cache.clear();
+    imageDevice.reset();
+    connect(chipCache, &ChipCache::pageLoaded, this,
+        &DataViewer::adjustContent);
+    size = chipCache->size();
+    lastStartPos = 0;
+    isScrollForward = true;
     init();
     adjustContent();
 }
 
+void DataViewer::goTo(quint64 addr)
+{
+    verticalScrollBar()->setValue(static_cast<int>(addr / mBytesPerLine));
+}
+
+void DataViewer::setMarkFunc(const MarkFunc &markFunc)
+{
+    this->markFunc = markFunc;
+    adjustContent();
+}
+
+void DataViewer::setHolesErased(bool isHolesErased)
+{
+    if (file.isHolesErased() == isHolesErased)
+        return;
+
+    file.setHolesErased(isHolesErased);
+    if (file.isOpen())
+        setFile(file.fileName());
+}
+
 void DataViewer::resizeEvent(QResizeEvent *)
 {
     adjustContent();
@@ -148,15 +195,16 @@ void DataViewer::paintEvent(QPaintEvent *)
     painter.drawText(lx + pxWidth / 2 + (pxWidth * 3 * 16 - pxWidth * 3)
                    / 2 - offsetX, y - pxHeight * 0.2, "HEX");
     y += pxHeight;
+    QColor textColor = viewport()->palette().color(QPalette::WindowText);
     int bPos = 0;
     for (int row = 1; row < nRowsVisible; row++)
     {
         x = lx - offsetX;
-        for (int col = 0; (col < mBytesPerLine) && (bPos < dataHex.size());
+        for (int col = 0; (col < mBytesPerLine) && (bPos < hexCells.size());
              col++)
         {
-            QString str = dataHex.mid(bPos * 2, 2).toUpper();
-            painter.drawText(x, y, str);
+            painter.setPen(marks[bPos] ? QColor(Qt::red) : textColor);
+            painter.drawText(x, y, hexCells.at(bPos));
             x += 3 * pxWidth;
             bPos += 1;
         }
@@ -168,20 +216,18 @@ void DataViewer::paintEvent(QPaintEvent *)
     bPos = 0;
     y = pxHeight;
 
+    painter.setPen(textColor);
     painter.drawText(lx + pxWidth / 2 + (pxWidth * mBytesPerLine - pxWidth * 5)
                    / 2 - offsetX, y - pxHeight * 0.2, "ASCII");
     y += pxHeight;
-    QChar ch;
     for (int row = 1; row < nRowsVisible; row++)
     {
         x = lx - offsetX;
-        for (int col = 0; (col < mBytesPerLine) && (bPos < dataVisible.size());
+        for (int col = 0; (col < mBytesPerLine) && (bPos < asciiText.size());
                  col++)
         {
-            ch = QChar(dataVisible.at(bPos));
-            if (!ch.isPrint())
-              ch = QChar('.');
-            painter.drawText(x, y, ch);
+            painter.setPen(marks[bPos] ? QColor(Qt::red) : textColor);
+            painter.drawText(x, y, asciiText.at(bPos));
             x += pxWidth;
             bPos += 1;
         }
@@ -208,7 +254,49 @@ void DataViewer::adjustContent()
     {
         endPos = size - 1;
     }
-    dataVisible = data(startPos, endPos - startPos + mBytesPerLine + 1);
-    dataHex = dataVisible.toHex();
+
+    if (startPos != lastStartPos)
+        isScrollForward = startPos > lastStartPos;
+    lastStartPos = startPos;
+
+    std::vector<bool> isLoaded;
+    QByteArray dataVisible = chipCache ?
+        chipCache->read(startPos, endPos - startPos + 1, isLoaded) :
+        cache.read(startPos, endPos - startPos + 1);
+    hexCells.clear();
+    asciiText.clear();
+    hexCells.reserve(dataVisible.size());
+    asciiText.reserve(dataVisible.size());
+    marks.assign(dataVisible.size(), false);
+    for (int i = 0; i < dataVisible.size(); i++)
+    {
+        uchar byte = static_cast<uchar>(dataVisible.at(i));
+        QChar ch(byte);
+
+        /* Chip page is not read yet */
+        if (!isLoaded.empty() && !isLoaded[i])
+        {
+            hexCells.append("--");
+            asciiText.append(QChar(' '));
+            continue;
+        }
+
+        hexCells.append(QString("%1").arg(byte, 2, 16, QChar('0')).toUpper());
+        asciiText.append(ch.isPrint() ? ch : QChar('.'));
+    }
+    for (size_t i = 0; markFunc && i < marks.size(); i++)
+        marks[i] = markFunc(startPos + i);
     viewport()->update();
+
+    if (chipCache)
+    {
+        chipCache->request(startPos, endPos - startPos + 1, isScrollForward);
+        return;
+    }
+
+    /* Next data in scroll direction is read after repaint */
+    qint64 readAheadPos = isScrollForward ? endPos + 1 :
+        startPos - readAheadSize;
+    QTimer::singleShot(0, this, [this, readAheadPos]()
+        { cache.prefetch(readAheadPos, readAheadSize); });
 }
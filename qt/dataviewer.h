@@ -2,17 +2,34 @@
 #define DATAVIEWER_H
 
 #include <QAbstractScrollArea>
-#include <QBuffer>
 #include <QFile>
+#include <QStringList>
+
+#include "chip_cache.h"
+#include "page_cache.h"
+#include "sparse_file.h"
+#include <functional>
+#include <memory>
+#include <vector>
 
 class DataViewer : public QAbstractScrollArea {
     Q_OBJECT
 
 public:
+    /* Returns true for bytes shown highlighted */
+    typedef std::function<bool(quint64 addr)> MarkFunc;
+
     DataViewer(QWidget *parent = 0);
     ~DataViewer();
 
     void setFile(QString filePath);
+    /* Releases file, so it can be rewritten */
+    void closeFile();
+    /* Scrolls to show address in the first row */
+    void goTo(quint64 addr);
+    void setMarkFunc(const MarkFunc &markFunc);
+    void setChip(ChipCache *chipCache);
+    void setHolesErased(bool isHolesErased);
 
 protected:
     void paintEvent(QPaintEvent *);
@@ -26,8 +43,11 @@ private:
     int hexWidth();
     int asciiWidth();
 
-    QFile file;
-    QByteArray data(qint64 pos = 0, qint64 count = -1);
+    SparseFile file;
+    std::unique_ptr<QIODevice> imageDevice;
+    PageCache cache;
+    ChipCache *chipCache;
+    const qint64 readAheadSize = 256 * 1024;
 
     int nCharAddress;
     int mBytesPerLine;
@@ -37,14 +57,18 @@ private:
 
     qint64 startPos;
     qint64 endPos;
+    qint64 lastStartPos;
+    bool isScrollForward;
 
     int nRowsVisible;
 
-    QIODevice *ioDevice;
     qint64 size;
 
-    QByteArray dataVisible;
-    QByteArray dataHex;
+    /* Text of visible rows, built only when they change */
+    QStringList hexCells;
+    QString asciiText;
+    MarkFunc markFunc;
+    std::vector<bool> marks;
 };
 
 #endif // DATAVIEWER_H
@@ -0,0 +1,176 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "diff_dialog.h"
+#include "ui_diff_dialog.h"
+#include "dataviewer.h"
+#include <QFileDialog>
+#include <QScrollBar>
+#include <algorithm>
+
+DiffDialog::DiffDialog(QWidget *parent) : QDialog(parent),
+    ui(new Ui::DiffDialog)
+{
+    ui->setupUi(this);
+    blockSize = 0;
+    isHolesErased = false;
+    isRunning = false;
+    current = 0;
+
+    connect(ui->selectFilePushButton, SIGNAL(clicked()), this,
+        SLOT(slotSelectFile()));
+    connect(ui->comparePushButton, SIGNAL(clicked()), this,
+        SLOT(slotCompare()));
+    connect(ui->prevPushButton, SIGNAL(clicked()), this, SLOT(slotPrev()));
+    connect(ui->nextPushButton, SIGNAL(clicked()), this, SLOT(slotNext()));
+    connect(&diff, SIGNAL(progress(quint64, quint64)), this,
+        SLOT(slotProgress(quint64, quint64)));
+    connect(&diff, SIGNAL(finished(bool)), this, SLOT(slotFinished(bool)));
+
+    /* Both files are scrolled together */
+    connect(ui->leftViewer->verticalScrollBar(), &QScrollBar::valueChanged,
+        ui->rightViewer->verticalScrollBar(), &QScrollBar::setValue);
+    connect(ui->rightViewer->verticalScrollBar(), &QScrollBar::valueChanged,
+        ui->leftViewer->verticalScrollBar(), &QScrollBar::setValue);
+}
+
+DiffDialog::~DiffDialog()
+{
+    diff.stop();
+    delete ui;
+}
+
+void DiffDialog::setFile(const QString &fileName, quint64 blockSize,
+    bool isHolesErased)
+{
+    this->fileName = fileName;
+    this->blockSize = blockSize;
+    this->isHolesErased = isHolesErased;
+}
+
+void DiffDialog::stop()
+{
+    diff.stop();
+    ui->leftViewer->closeFile();
+    ui->rightViewer->closeFile();
+}
+
+void DiffDialog::setRunning(bool isRunning)
+{
+    /* Ranges are appended by worker until it is finished */
+    bool hasRanges = !isRunning && !diff.getRanges().empty();
+
+    this->isRunning = isRunning;
+    ui->comparePushButton->setText(isRunning ? tr("Stop") : tr("Compare"));
+    ui->otherFilePathLineEdit->setReadOnly(isRunning);
+    ui->selectFilePushButton->setEnabled(!isRunning);
+    ui->prevPushButton->setEnabled(hasRanges);
+    ui->nextPushButton->setEnabled(hasRanges);
+}
+
+void DiffDialog::slotSelectFile()
+{
+    QString filePath = QFileDialog::getOpenFileName(this,
+        tr("Choose a file."), ui->otherFilePathLineEdit->text(),
+        tr("Binary file(*.bin);;All Files(*)"));
+
+    if (!filePath.isEmpty())
+        ui->otherFilePathLineEdit->setText(filePath);
+}
+
+void DiffDialog::slotCompare()
+{
+    QString otherFileName = ui->otherFilePathLineEdit->text();
+
+    if (isRunning)
+    {
+        diff.stop();
+        return;
+    }
+
+    ui->statusLabel->clear();
+    if (diff.start(fileName, otherFileName, blockSize, isHolesErased))
+        return;
+
+    /* Differences are written by worker until it is finished */
+    ui->leftViewer->setMarkFunc(DataViewer::MarkFunc());
+    ui->rightViewer->setMarkFunc(DataViewer::MarkFunc());
+    ui->leftViewer->setHolesErased(isHolesErased);
+    ui->rightViewer->setHolesErased(isHolesErased);
+    ui->leftViewer->setFile(fileName);
+    ui->rightViewer->setFile(otherFileName);
+    setRunning(true);
+}
+
+void DiffDialog::slotProgress(quint64 done, quint64 total)
+{
+    ui->statusLabel->setText(tr("Compared %1 of %2 MiB").arg(done >> 20)
+        .arg(total >> 20));
+}
+
+void DiffDialog::slotFinished(bool isCompleted)
+{
+    const std::vector<DumpDiff::Range> &ranges = diff.getRanges();
+
+    /* Thread is done, it is joined here */
+    diff.stop();
+    setRunning(false);
+
+    if (!isCompleted)
+    {
+        ui->statusLabel->setText(tr("Stopped"));
+        return;
+    }
+
+    if (ranges.empty())
+    {
+        ui->statusLabel->setText(tr("Files are equal"));
+        return;
+    }
+
+    auto markFunc = [this](quint64 addr) { return isDifferent(addr); };
+    ui->leftViewer->setMarkFunc(markFunc);
+    ui->rightViewer->setMarkFunc(markFunc);
+    showRange(0);
+}
+
+/* Ranges are sorted and do not overlap */
+bool DiffDialog::isDifferent(quint64 addr)
+{
+    const std::vector<DumpDiff::Range> &ranges = diff.getRanges();
+
+    auto it = std::upper_bound(ranges.begin(), ranges.end(), addr,
+        [](quint64 a, const DumpDiff::Range &r) { return a < r.addr; });
+    if (it == ranges.begin())
+        return false;
+    --it;
+
+    return addr < it->addr + it->len;
+}
+
+void DiffDialog::showRange(size_t index)
+{
+    const std::vector<DumpDiff::Range> &ranges = diff.getRanges();
+
+    current = index;
+    ui->leftViewer->goTo(ranges[index].addr);
+    ui->rightViewer->goTo(ranges[index].addr);
+    ui->statusLabel->setText(tr("Difference %1 of %2 at 0x%3, %4 bytes, "
+        "%5 blocks differ").arg(index + 1).arg(ranges.size())
+        .arg(ranges[index].addr, 8, 16, QChar('0')).arg(ranges[index].len)
+        .arg(diff.getDiffBlockCount()));
+}
+
+void DiffDialog::slotPrev()
+{
+    if (current > 0)
+        showRange(current - 1);
+}
+
+void DiffDialog::slotNext()
+{
+    if (current + 1 < diff.getRanges().size())
+        showRange(current + 1);
+}
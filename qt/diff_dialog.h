@@ -0,0 +1,51 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef DIFF_DIALOG_H
+#define DIFF_DIALOG_H
+
+#include "dump_diff.h"
+#include <QDialog>
+
+namespace Ui {
+class DiffDialog;
+}
+
+/* Work file and other file side by side with differences highlighted */
+class DiffDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit DiffDialog(QWidget *parent = nullptr);
+    ~DiffDialog();
+    void setFile(const QString &fileName, quint64 blockSize,
+        bool isHolesErased);
+    void stop();
+
+private slots:
+    void slotSelectFile();
+    void slotCompare();
+    void slotProgress(quint64 done, quint64 total);
+    void slotFinished(bool isCompleted);
+    void slotPrev();
+    void slotNext();
+
+private:
+    Ui::DiffDialog *ui;
+    DumpDiff diff;
+    QString fileName;
+    quint64 blockSize;
+    bool isHolesErased;
+    bool isRunning;
+    /* Index of the shown difference */
+    size_t current;
+
+    bool isDifferent(quint64 addr);
+    void showRange(size_t index);
+    void setRunning(bool isRunning);
+};
+
+#endif // DIFF_DIALOG_H
@@ -0,0 +1,251 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "dump_diff.h"
+#include "crc32c.h"
+#include "image_device.h"
+#include "sparse_file.h"
+#include "verifier.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <algorithm>
+#include <memory>
+
+/* Plain file or image in a container */
+class DiffSource
+{
+    SparseFile file;
+    std::unique_ptr<QIODevice> imageDevice;
+
+public:
+    QIODevice *device = nullptr;
+
+    int open(const QString &fileName, bool isHolesErased)
+    {
+        if (ImageDevice::isContainer(fileName))
+        {
+            imageDevice.reset(ImageDevice::create(fileName));
+            if (!imageDevice)
+                return -1;
+            device = imageDevice.get();
+        }
+        else
+        {
+            file.setFileName(fileName);
+            file.setHolesErased(isHolesErased);
+            device = &file;
+        }
+
+        if (!device->open(QIODevice::ReadOnly))
+        {
+            qCritical() << "Failed to open file:" << fileName << ", error:"
+                << device->errorString();
+            return -1;
+        }
+
+        return 0;
+    }
+};
+
+DumpDiff::DumpDiff(QObject *parent) : QObject(parent)
+{
+    isHolesErased = false;
+    blockSize = blockSizeDefault;
+    sizes[0] = sizes[1] = 0;
+    isStopped = true;
+    done = 0;
+    total = 0;
+}
+
+DumpDiff::~DumpDiff()
+{
+    stop();
+}
+
+int DumpDiff::start(const QString &fileName, const QString &otherFileName,
+    quint64 blockSize, bool isHolesErased)
+{
+    stop();
+
+    for (const QString &name : { fileName, otherFileName })
+    {
+        if (!QFileInfo(name).isFile())
+        {
+            qCritical() << "File" << name << "does not exist";
+            return -1;
+        }
+    }
+
+    fileNames[0] = fileName;
+    fileNames[1] = otherFileName;
+    this->blockSize = blockSize ? blockSize : blockSizeDefault;
+    this->isHolesErased = isHolesErased;
+    sizes[0] = sizes[1] = 0;
+    hashes[0].clear();
+    hashes[1].clear();
+    diffBlocks.clear();
+    ranges.clear();
+    done = 0;
+    total = 0;
+    isStopped = false;
+
+    thread = std::thread(&DumpDiff::worker, this);
+
+    return 0;
+}
+
+void DumpDiff::stop()
+{
+    if (!thread.joinable())
+        return;
+
+    isStopped = true;
+    thread.join();
+}
+
+void DumpDiff::hashFile(int index, int *ret)
+{
+    DiffSource source;
+    QByteArray buf;
+
+    *ret = -1;
+    if (source.open(fileNames[index], isHolesErased))
+        return;
+
+    sizes[index] = static_cast<quint64>(source.device->size());
+    hashes[index].reserve((sizes[index] + blockSize - 1) / blockSize);
+    while (!isStopped)
+    {
+        buf = source.device->read(static_cast<qint64>(blockSize));
+        if (buf.isEmpty())
+            break;
+
+        hashes[index].push_back(crc32c(0,
+            reinterpret_cast<const uint8_t *>(buf.constData()), buf.size()));
+        done += buf.size();
+
+        /* Both files are counted, one thread reports */
+        if (!index && hashes[index].size() % progressBlocks == 0)
+            emit progress(done, total);
+    }
+
+    *ret = isStopped ? -1 : 0;
+}
+
+void DumpDiff::addRange(quint64 addr, quint64 len)
+{
+    /* Adjacent differences, e.g. across block boundary, are merged */
+    if (!ranges.empty() && ranges.back().addr + ranges.back().len == addr)
+        ranges.back().len += len;
+    else
+        ranges.push_back({ addr, len });
+}
+
+int DumpDiff::compareBlocks()
+{
+    DiffSource sources[2];
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (sources[i].open(fileNames[i], isHolesErased))
+            return -1;
+    }
+
+    for (quint64 block : diffBlocks)
+    {
+        quint64 addr = block * blockSize;
+        QByteArray data[2];
+
+        if (isStopped)
+            return -1;
+
+        for (int i = 0; i < 2; i++)
+        {
+            if (!sources[i].device->seek(static_cast<qint64>(addr)))
+                return -1;
+            data[i] = sources[i].device->read(static_cast<qint64>(blockSize));
+        }
+
+        const uint8_t *a = reinterpret_cast<const uint8_t *>(
+            data[0].constData());
+        const uint8_t *b = reinterpret_cast<const uint8_t *>(
+            data[1].constData());
+        size_t len = std::min(data[0].size(), data[1].size());
+        size_t maxLen = std::max(data[0].size(), data[1].size());
+
+        if (ranges.size() >= rangeMax)
+        {
+            addRange(addr, maxLen);
+            continue;
+        }
+
+        size_t off = 0;
+        while ((off += Verifier::findMismatch(a + off, b + off, len - off)) <
+            len)
+        {
+            size_t end = off + 1;
+
+            while (end < len && a[end] != b[end])
+                end++;
+            addRange(addr + off, end - off);
+            off = end;
+        }
+
+        /* Tail of longer file */
+        if (maxLen > len)
+            addRange(addr + len, maxLen - len);
+
+        done += 2 * maxLen;
+        emit progress(done, total);
+    }
+
+    return 0;
+}
+
+void DumpDiff::worker()
+{
+    int ret[2];
+
+    /* Image size of containers is not known before open, so progress is
+     * estimated by file size
+     */
+    total = static_cast<quint64>(QFileInfo(fileNames[0]).size() +
+        QFileInfo(fileNames[1]).size());
+
+    std::thread other(&DumpDiff::hashFile, this, 1, &ret[1]);
+    hashFile(0, &ret[0]);
+    other.join();
+
+    /* Tail of longer file has no pair, so its hashes are different */
+    size_t blocks = std::max(hashes[0].size(), hashes[1].size());
+    for (size_t i = 0; i < blocks; i++)
+    {
+        if (i >= hashes[0].size() || i >= hashes[1].size() ||
+            hashes[0][i] != hashes[1][i])
+        {
+            diffBlocks.push_back(i);
+        }
+    }
+
+    done = 0;
+    total = 2 * diffBlocks.size() * blockSize;
+
+    emit finished(!ret[0] && !ret[1] && !compareBlocks());
+}
+
+const std::vector<DumpDiff::Range> &DumpDiff::getRanges()
+{
+    return ranges;
+}
+
+quint64 DumpDiff::getDiffBlockCount()
+{
+    return diffBlocks.size();
+}
+
+quint64 DumpDiff::getBlockSize()
+{
+    return blockSize;
+}
@@ -0,0 +1,71 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef DUMP_DIFF_H
+#define DUMP_DIFF_H
+
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+/* Compares two images on worker threads. Both files are hashed per block
+ * by CRC32C in parallel, then only blocks with different hash are read
+ * again and compared byte by byte.
+ */
+class DumpDiff : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef struct
+    {
+        quint64 addr;
+        quint64 len;
+    } Range;
+
+private:
+    const quint64 blockSizeDefault = 128 * 1024;
+    /* More differences are saved as whole blocks */
+    const size_t rangeMax = 1000000;
+    const size_t progressBlocks = 64;
+
+    QString fileNames[2];
+    bool isHolesErased;
+    quint64 blockSize;
+    quint64 sizes[2];
+    std::vector<uint32_t> hashes[2];
+    std::vector<quint64> diffBlocks;
+    std::vector<Range> ranges;
+    std::thread thread;
+    std::atomic<bool> isStopped;
+    std::atomic<quint64> done;
+    quint64 total;
+
+    void hashFile(int index, int *ret);
+    int compareBlocks();
+    void addRange(quint64 addr, quint64 len);
+    void worker();
+
+public:
+    explicit DumpDiff(QObject *parent = nullptr);
+    ~DumpDiff();
+    /* Block size 0 selects default */
+    int start(const QString &fileName, const QString &otherFileName,
+        quint64 blockSize, bool isHolesErased);
+    void stop();
+    /* Valid after finished signal */
+    const std::vector<Range> &getRanges();
+    quint64 getDiffBlockCount();
+    quint64 getBlockSize();
+
+signals:
+    void progress(quint64 done, quint64 total);
+    void finished(bool isCompleted);
+};
+
+#endif // DUMP_DIFF_H
@@ -0,0 +1,420 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "dump_file.h"
+#include "crc32c.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+#define DUMP_MAGIC "NANDODMP"
+#define DUMP_VERSION 1
+#define DUMP_NAME_SIZE 64
+#define DUMP_COMPRESS_LEVEL 1
+
+typedef struct __attribute__((__packed__))
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    char chipName[DUMP_NAME_SIZE];
+    ChipId chipId;
+    uint8_t incSpare;
+    uint8_t reserved[2];
+    uint32_t pageSize;
+    uint32_t spareSize;
+    uint64_t blockSize;
+    uint64_t totalSize;
+    uint64_t startBlock;
+    uint64_t blockCount;
+    uint64_t indexOffset;
+    uint64_t bbtOffset;
+    uint64_t bbtCount;
+} DumpHeader;
+
+DumpFile::DumpFile()
+{
+    info = {};
+    isWritable = false;
+}
+
+DumpFile::~DumpFile()
+{
+    close();
+}
+
+bool DumpFile::isDump(const QString &fileName)
+{
+    QFile f(fileName);
+    char magic[sizeof(DUMP_MAGIC) - 1];
+
+    if (!f.open(QIODevice::ReadOnly))
+        return false;
+
+    return f.read(magic, sizeof(magic)) == sizeof(magic) &&
+        !memcmp(magic, DUMP_MAGIC, sizeof(magic));
+}
+
+int DumpFile::writeHeader(quint64 indexOffset, quint64 bbtOffset)
+{
+    DumpHeader header = {};
+    QByteArray name = info.chipName.toLatin1();
+
+    memcpy(header.magic, DUMP_MAGIC, sizeof(header.magic));
+    header.version = DUMP_VERSION;
+    header.headerSize = sizeof(header);
+    memcpy(header.chipName, name.constData(),
+        std::min<size_t>(name.size(), DUMP_NAME_SIZE - 1));
+    header.chipId = info.chipId;
+    header.incSpare = info.incSpare;
+    header.pageSize = info.pageSize;
+    header.spareSize = info.spareSize;
+    header.blockSize = info.blockSize;
+    header.totalSize = info.totalSize;
+    header.startBlock = info.startBlock;
+    header.blockCount = index.size();
+    header.indexOffset = indexOffset;
+    header.bbtOffset = bbtOffset;
+    header.bbtCount = badBlocks.size();
+
+    if (!file.seek(0) || file.write(reinterpret_cast<const char *>(&header),
+        sizeof(header)) != sizeof(header))
+    {
+        qCritical() << "Failed to write dump header:" << file.errorString();
+        return -1;
+    }
+
+    return 0;
+}
+
+int DumpFile::create(const QString &fileName, const DumpInfo &info)
+{
+    close();
+
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qCritical() << "Failed to open file:" << fileName << ", error:"
+            << file.errorString();
+        return -1;
+    }
+
+    this->info = info;
+    index.clear();
+    badBlocks.clear();
+    isWritable = true;
+
+    /* Offsets are updated on close */
+    return writeHeader(0, 0);
+}
+
+/* Block is compressed only if it saves space, erased blocks mostly. Packed
+ * is left empty if block is stored as is.
+ */
+void DumpFile::packBlock(const uint8_t *data, uint32_t size,
+    std::vector<uint8_t> &packed, uint32_t &flags, uint32_t &crc)
+{
+    QByteArray buf;
+
+    packed.clear();
+    crc = 0;
+    if (!size)
+        return;
+
+    crc = crc32c(0, data, size);
+    buf = qCompress(data, static_cast<int>(size), DUMP_COMPRESS_LEVEL);
+    if (static_cast<uint32_t>(buf.size()) < size)
+    {
+        packed.assign(buf.constData(), buf.constData() + buf.size());
+        flags |= BLOCK_COMPRESSED;
+    }
+}
+
+int DumpFile::writePackedBlock(const uint8_t *data, uint32_t size,
+    const std::vector<uint8_t> &packed, uint32_t flags, uint32_t crc)
+{
+    BlockEntry entry = {};
+    const char *buf = reinterpret_cast<const char *>(data);
+
+    entry.offset = file.pos();
+    entry.size = size;
+    entry.rawSize = size;
+    entry.crc = crc;
+    entry.flags = flags;
+
+    if (flags & BLOCK_COMPRESSED)
+    {
+        buf = reinterpret_cast<const char *>(packed.data());
+        entry.size = static_cast<uint32_t>(packed.size());
+    }
+
+    if (entry.size &&
+        file.write(buf, entry.size) != static_cast<qint64>(entry.size))
+    {
+        qCritical() << "Failed to write dump block:" << file.errorString();
+        return -1;
+    }
+
+    index.push_back(entry);
+
+    return 0;
+}
+
+int DumpFile::writeBlock(const uint8_t *data, uint32_t size, uint32_t flags)
+{
+    std::vector<uint8_t> packed;
+    uint32_t crc;
+
+    packBlock(data, size, packed, flags, crc);
+
+    return writePackedBlock(data, size, packed, flags, crc);
+}
+
+void DumpFile::addBadBlock(quint64 block)
+{
+    if (std::find(badBlocks.begin(), badBlocks.end(), block) !=
+        badBlocks.end())
+    {
+        return;
+    }
+
+    badBlocks.push_back(block);
+}
+
+int DumpFile::open(const QString &fileName)
+{
+    DumpHeader header;
+
+    close();
+
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qCritical() << "Failed to open file:" << fileName << ", error:"
+            << file.errorString();
+        return -1;
+    }
+
+    if (file.read(reinterpret_cast<char *>(&header), sizeof(header)) !=
+        sizeof(header) || memcmp(header.magic, DUMP_MAGIC,
+        sizeof(header.magic)) || header.version != DUMP_VERSION ||
+        !header.indexOffset)
+    {
+        qCritical() << "File" << fileName << "is not a valid dump";
+        file.close();
+        return -1;
+    }
+
+    header.chipName[DUMP_NAME_SIZE - 1] = '\0';
+    info.chipName = QString::fromLatin1(header.chipName);
+    info.chipId = header.chipId;
+    info.incSpare = header.incSpare;
+    info.pageSize = header.pageSize;
+    info.spareSize = header.spareSize;
+    info.blockSize = header.blockSize;
+    info.totalSize = header.totalSize;
+    info.startBlock = header.startBlock;
+
+    index.resize(header.blockCount);
+    badBlocks.resize(header.bbtCount);
+    qint64 indexSize = index.size() * sizeof(BlockEntry);
+    qint64 bbtSize = badBlocks.size() * sizeof(quint64);
+    if (!file.seek(header.indexOffset) ||
+        file.read(reinterpret_cast<char *>(index.data()), indexSize) !=
+        indexSize || !file.seek(header.bbtOffset) ||
+        file.read(reinterpret_cast<char *>(badBlocks.data()), bbtSize) !=
+        bbtSize)
+    {
+        qCritical() << "Failed to read dump index:" << file.errorString();
+        file.close();
+        return -1;
+    }
+
+    isWritable = false;
+
+    return 0;
+}
+
+int DumpFile::readBlock(quint64 num, QByteArray &data)
+{
+    const BlockEntry &entry = index[num];
+
+    data.clear();
+    if (entry.flags & BLOCK_SKIPPED)
+        return 0;
+
+    if (!file.seek(entry.offset))
+        return -1;
+
+    data = file.read(entry.size);
+    if (static_cast<uint32_t>(data.size()) != entry.size)
+        return -1;
+
+    if (entry.flags & BLOCK_COMPRESSED)
+        data = qUncompress(data);
+
+    if (static_cast<uint32_t>(data.size()) != entry.rawSize ||
+        crc32c(0, reinterpret_cast<const uint8_t *>(data.constData()),
+        data.size()) != entry.crc)
+    {
+        qCritical() << "Dump block" << info.startBlock + num << "is corrupted";
+        return -1;
+    }
+
+    return 0;
+}
+
+int DumpFile::close()
+{
+    int ret = 0;
+
+    if (!file.isOpen())
+        return 0;
+
+    if (isWritable)
+    {
+        /* Blocks may be reported bad before they are written */
+        for (quint64 block : badBlocks)
+        {
+            if (block >= info.startBlock &&
+                block - info.startBlock < index.size())
+            {
+                index[block - info.startBlock].flags |= BLOCK_BAD;
+            }
+        }
+
+        quint64 indexOffset = file.pos();
+        quint64 bbtOffset = indexOffset + index.size() * sizeof(BlockEntry);
+        qint64 indexSize = index.size() * sizeof(BlockEntry);
+        qint64 bbtSize = badBlocks.size() * sizeof(quint64);
+
+        if (file.write(reinterpret_cast<const char *>(index.data()),
+            indexSize) != indexSize ||
+            file.write(reinterpret_cast<const char *>(badBlocks.data()),
+            bbtSize) != bbtSize)
+        {
+            qCritical() << "Failed to write dump index:" << file.errorString();
+            ret = -1;
+        }
+        else
+            ret = writeHeader(indexOffset, bbtOffset);
+    }
+
+    file.close();
+    isWritable = false;
+
+    return ret;
+}
+
+bool DumpFile::isOpen()
+{
+    return file.isOpen();
+}
+
+const DumpInfo &DumpFile::getInfo()
+{
+    return info;
+}
+
+quint64 DumpFile::getBlockCount()
+{
+    return index.size();
+}
+
+const DumpFile::BlockEntry &DumpFile::getBlockEntry(quint64 num)
+{
+    return index[num];
+}
+
+const std::vector<quint64> &DumpFile::getBadBlocks()
+{
+    return badBlocks;
+}
+
+DumpDevice::DumpDevice()
+{
+    dataSize = 0;
+    cacheBlock = -1;
+}
+
+int DumpDevice::setFileName(const QString &fileName)
+{
+    dataBlocks.clear();
+    dataSize = 0;
+    cacheBlock = -1;
+
+    if (dump.open(fileName))
+        return -1;
+
+    for (quint64 i = 0; i < dump.getBlockCount(); i++)
+    {
+        const DumpFile::BlockEntry &entry = dump.getBlockEntry(i);
+
+        if (entry.flags & DumpFile::BLOCK_SKIPPED)
+            continue;
+
+        dataBlocks.push_back(i);
+        dataSize += entry.rawSize;
+    }
+
+    return 0;
+}
+
+qint64 DumpDevice::readData(char *data, qint64 maxSize)
+{
+    quint64 blockSize = dump.getInfo().blockSize;
+    quint64 offset = static_cast<quint64>(pos());
+    qint64 done = 0;
+
+    if (!blockSize)
+        return -1;
+
+    while (done < maxSize && offset < dataSize)
+    {
+        quint64 block = offset / blockSize;
+        quint64 blockOff = offset % blockSize;
+
+        if (cacheBlock != static_cast<qint64>(block))
+        {
+            if (dump.readBlock(dataBlocks[block], cache))
+                return done ? done : -1;
+            cacheBlock = static_cast<qint64>(block);
+        }
+
+        qint64 len = std::min<qint64>(maxSize - done,
+            static_cast<qint64>(cache.size() - blockOff));
+        if (len <= 0)
+            break;
+
+        memcpy(data + done, cache.constData() + blockOff, len);
+        done += len;
+        offset += len;
+    }
+
+    return done;
+}
+
+qint64 DumpDevice::writeData(const char *data, qint64 maxSize)
+{
+    (void)data;
+    (void)maxSize;
+
+    return -1;
+}
+
+bool DumpDevice::isSequential() const
+{
+    return false;
+}
+
+qint64 DumpDevice::size() const
+{
+    return static_cast<qint64>(dataSize);
+}
+
+DumpFile &DumpDevice::getDump()
+{
+    return dump;
+}
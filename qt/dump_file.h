@@ -0,0 +1,105 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef DUMP_FILE_H
+#define DUMP_FILE_H
+
+#include "cmd.h"
+#include <QFile>
+#include <QIODevice>
+#include <QString>
+#include <cstdint>
+#include <vector>
+
+typedef struct
+{
+    QString chipName;
+    ChipId chipId;
+    /* Page and block sizes of stored data, with spare area if included */
+    uint32_t pageSize;
+    quint64 blockSize;
+    uint32_t spareSize;
+    quint64 totalSize;
+    bool incSpare;
+    quint64 startBlock;
+} DumpInfo;
+
+/* NAND dump container: header, blocks, block index and bad block table.
+ * Index has an entry per block starting from start block, so any block
+ * is found without reading the data before it.
+ */
+class DumpFile
+{
+public:
+    enum
+    {
+        BLOCK_COMPRESSED = 0x01,
+        BLOCK_BAD        = 0x02,
+        BLOCK_SKIPPED    = 0x04,
+    };
+
+    typedef struct __attribute__((__packed__))
+    {
+        uint64_t offset;
+        uint32_t size;
+        uint32_t rawSize;
+        uint32_t crc;
+        uint32_t flags;
+    } BlockEntry;
+
+private:
+    QFile file;
+    DumpInfo info;
+    std::vector<BlockEntry> index;
+    std::vector<quint64> badBlocks;
+    bool isWritable;
+
+    int writeHeader(quint64 indexOffset, quint64 bbtOffset);
+
+public:
+    DumpFile();
+    ~DumpFile();
+    static bool isDump(const QString &fileName);
+    int create(const QString &fileName, const DumpInfo &info);
+    static void packBlock(const uint8_t *data, uint32_t size,
+        std::vector<uint8_t> &packed, uint32_t &flags, uint32_t &crc);
+    int writePackedBlock(const uint8_t *data, uint32_t size,
+        const std::vector<uint8_t> &packed, uint32_t flags, uint32_t crc);
+    int writeBlock(const uint8_t *data, uint32_t size, uint32_t flags);
+    void addBadBlock(quint64 block);
+    int open(const QString &fileName);
+    int readBlock(quint64 num, QByteArray &data);
+    int close();
+    bool isOpen();
+    const DumpInfo &getInfo();
+    quint64 getBlockCount();
+    const BlockEntry &getBlockEntry(quint64 num);
+    const std::vector<quint64> &getBadBlocks();
+};
+
+/* Read only access to dump data as a plain image, skipped blocks are not
+ * included like in raw file.
+ */
+class DumpDevice : public QIODevice
+{
+    DumpFile dump;
+    std::vector<quint64> dataBlocks;
+    quint64 dataSize;
+    qint64 cacheBlock;
+    QByteArray cache;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+public:
+    DumpDevice();
+    int setFileName(const QString &fileName);
+    bool isSequential() const override;
+    qint64 size() const override;
+    DumpFile &getDump();
+};
+
+#endif // DUMP_FILE_H
@@ -0,0 +1,391 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "ecc.h"
+#include <cstring>
+
+#define ECC_BCH_M_MIN 5
+#define ECC_BCH_M_MAX 15
+#define ECC_BCH_T_MAX 64
+
+/* Primitive polynomials of GF(2^m), m = 5..15 */
+static const uint32_t bchPrimPoly[] =
+{
+    0x25, 0x43, 0x83, 0x11d, 0x211, 0x409, 0x805, 0x1053, 0x201b, 0x402b,
+    0x8003
+};
+
+Ecc::Ecc(uint32_t step)
+{
+    this->step = step;
+    eccBytes = 0;
+}
+
+Ecc::~Ecc()
+{
+}
+
+uint32_t Ecc::getStep()
+{
+    return step;
+}
+
+uint32_t Ecc::getEccBytes()
+{
+    return eccBytes;
+}
+
+Ecc *Ecc::create(uint32_t step, uint32_t strength)
+{
+    uint32_t m;
+
+    if (strength == 1)
+    {
+        if (step != 256 && step != 512)
+            return nullptr;
+
+        return new EccHamming(step);
+    }
+
+    if (!step || strength > ECC_BCH_T_MAX)
+        return nullptr;
+
+    for (m = ECC_BCH_M_MIN; m <= ECC_BCH_M_MAX; m++)
+    {
+        if ((1U << m) - 1 >= step * 8 + m * strength)
+            return new EccBch(step, strength);
+    }
+
+    return nullptr;
+}
+
+EccHamming::EccHamming(uint32_t step) : Ecc(step)
+{
+    eccBytes = 3;
+
+    /* Bits 0-5: column parity CP0-CP5, bit 6: parity of the whole byte */
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint8_t cp[6] = {}, par = 0;
+
+        for (uint32_t bit = 0; bit < 8; bit++)
+        {
+            if (!(i & (1 << bit)))
+                continue;
+
+            cp[(bit & 1) ? 1 : 0] ^= 1;
+            cp[(bit & 2) ? 3 : 2] ^= 1;
+            cp[(bit & 4) ? 5 : 4] ^= 1;
+            par ^= 1;
+        }
+
+        parityTable[i] = par << 6;
+        for (uint32_t j = 0; j < 6; j++)
+            parityTable[i] |= cp[j] << j;
+    }
+}
+
+void EccHamming::encode(const uint8_t *data, uint8_t *ecc)
+{
+    uint32_t lineOdd = 0, lineEven = 0, lp = 0;
+    uint8_t col = 0;
+
+    for (uint32_t i = 0; i < step; i++)
+    {
+        uint8_t idx = parityTable[data[i]];
+
+        col ^= idx & 0x3f;
+        if (idx & 0x40)
+        {
+            lineOdd ^= i;
+            lineEven ^= ~i;
+        }
+    }
+    lineEven &= step - 1;
+
+    /* Interleave line parity: LP(2k + 1) from odd, LP(2k) from even rows */
+    for (uint32_t k = 0; (1U << k) < step; k++)
+    {
+        lp |= ((lineOdd >> k) & 1) << (2 * k + 1);
+        lp |= ((lineEven >> k) & 1) << (2 * k);
+    }
+
+    /* Inverted so that erased data has erased ECC */
+    ecc[0] = static_cast<uint8_t>(~(lp >> 8));
+    ecc[1] = static_cast<uint8_t>(~lp);
+    ecc[2] = static_cast<uint8_t>(~((col << 2) | ((lp >> 16) & 0x3)));
+}
+
+int EccHamming::decode(uint8_t *data, uint8_t *ecc)
+{
+    uint8_t calc[3];
+    uint32_t diff, lp, pairMask, byte = 0, bit, col;
+
+    encode(data, calc);
+    diff = static_cast<uint32_t>(calc[0] ^ ecc[0]) << 16 |
+        static_cast<uint32_t>(calc[1] ^ ecc[1]) << 8 | (calc[2] ^ ecc[2]);
+    if (!diff)
+        return 0;
+
+    /* Single bit data error flips exactly one bit of each parity pair */
+    pairMask = step == 256 ? 0x555554 : 0x555555;
+    if (((diff ^ (diff >> 1)) & pairMask) == pairMask)
+    {
+        lp = ((diff >> 8) & 0xFFFF) | ((diff & 0x3) << 16);
+        for (uint32_t k = 0; (1U << k) < step; k++)
+            byte |= ((lp >> (2 * k + 1)) & 1) << k;
+
+        col = (diff >> 2) & 0x3F;
+        bit = ((col >> 1) & 1) | ((col >> 3) & 1) << 1 | ((col >> 5) & 1) << 2;
+
+        data[byte] ^= 1 << bit;
+        return 1;
+    }
+
+    /* Single bit error in ECC itself */
+    if (!(diff & (diff - 1)))
+    {
+        memcpy(ecc, calc, sizeof(calc));
+        return 1;
+    }
+
+    return -1;
+}
+
+EccBch::EccBch(uint32_t step, uint32_t strength) : Ecc(step)
+{
+    std::vector<uint8_t> poly;
+
+    t = strength;
+    for (m = ECC_BCH_M_MIN; m < ECC_BCH_M_MAX; m++)
+    {
+        if ((1U << m) - 1 >= step * 8 + m * t)
+            break;
+    }
+    n = (1U << m) - 1;
+
+    alphaTo.resize(n + 1);
+    indexOf.resize(n + 1);
+    for (uint32_t i = 0, x = 1; i < n; i++)
+    {
+        alphaTo[i] = x;
+        indexOf[x] = i;
+        x <<= 1;
+        if (x & (1U << m))
+            x ^= bchPrimPoly[m - ECC_BCH_M_MIN];
+    }
+    alphaTo[n] = 1;
+    indexOf[0] = n;
+
+    genPoly(poly);
+    eccBits = static_cast<uint32_t>(poly.size()) - 1;
+    eccBytes = (eccBits + 7) / 8;
+
+    /* Generator polynomial without x^eccBits term, MSB aligned */
+    std::vector<uint8_t> gen(eccBytes, 0);
+    for (uint32_t k = 0; k < eccBits; k++)
+    {
+        if (poly[eccBits - 1 - k])
+            gen[k / 8] |= 0x80 >> (k % 8);
+    }
+
+    /* Remainder of byte value * x^eccBits, processed 8 bits at once */
+    encodeTable.assign(256 * eccBytes, 0);
+    for (uint32_t v = 0; v < 256; v++)
+    {
+        uint8_t *reg = &encodeTable[v * eccBytes];
+
+        for (int bit = 7; bit >= 0; bit--)
+        {
+            uint32_t fb = (reg[0] >> 7) ^ ((v >> bit) & 1);
+
+            for (uint32_t i = 0; i < eccBytes; i++)
+            {
+                reg[i] <<= 1;
+                if (i + 1 < eccBytes)
+                    reg[i] |= reg[i + 1] >> 7;
+            }
+
+            if (fb)
+            {
+                for (uint32_t i = 0; i < eccBytes; i++)
+                    reg[i] ^= gen[i];
+            }
+        }
+    }
+}
+
+/* Product of minimal polynomials of alpha^1, alpha^3 ... alpha^(2t - 1) */
+void EccBch::genPoly(std::vector<uint8_t> &poly)
+{
+    std::vector<bool> roots(n, false);
+    std::vector<uint32_t> g(1, 1);
+
+    for (uint32_t i = 0; i < t; i++)
+    {
+        for (uint32_t j = 0, r = 2 * i + 1; j < m; j++, r = (r * 2) % n)
+            roots[r] = true;
+    }
+
+    for (uint32_t r = 0; r < n; r++)
+    {
+        if (!roots[r])
+            continue;
+
+        /* g(x) = g(x) * (x + alpha^r), g[i] is coefficient of x^i */
+        g.push_back(0);
+        for (size_t i = g.size() - 1; i > 0; i--)
+        {
+            uint32_t prod = g[i] ? alphaTo[(indexOf[g[i]] + r) % n] : 0;
+            g[i] = g[i - 1] ^ prod;
+        }
+        g[0] = g[0] ? alphaTo[(indexOf[g[0]] + r) % n] : 0;
+    }
+
+    poly.resize(g.size());
+    for (size_t i = 0; i < g.size(); i++)
+        poly[i] = static_cast<uint8_t>(g[i] & 1);
+}
+
+void EccBch::encode(const uint8_t *data, uint8_t *ecc)
+{
+    memset(ecc, 0, eccBytes);
+
+    for (uint32_t i = 0; i < step; i++)
+    {
+        const uint8_t *rem = &encodeTable[(ecc[0] ^ data[i]) * eccBytes];
+
+        memmove(ecc, ecc + 1, eccBytes - 1);
+        ecc[eccBytes - 1] = 0;
+        for (uint32_t j = 0; j < eccBytes; j++)
+            ecc[j] ^= rem[j];
+    }
+}
+
+uint32_t EccBch::gfMul(uint32_t a, uint32_t b)
+{
+    if (!a || !b)
+        return 0;
+
+    return alphaTo[(indexOf[a] + indexOf[b]) % n];
+}
+
+uint32_t EccBch::gfDiv(uint32_t a, uint32_t b)
+{
+    if (!a)
+        return 0;
+
+    return alphaTo[(indexOf[a] + n - indexOf[b]) % n];
+}
+
+/* Berlekamp-Massey, returns degree of error locator polynomial */
+uint32_t EccBch::errorLocator(const std::vector<uint32_t> &syn,
+    std::vector<uint32_t> &lambda)
+{
+    std::vector<uint32_t> prev(2 * t + 1, 0), tmp;
+    uint32_t l = 0, shift = 1, prevDisc = 1;
+
+    lambda.assign(2 * t + 1, 0);
+    lambda[0] = prev[0] = 1;
+
+    for (uint32_t i = 0; i < 2 * t; i++)
+    {
+        uint32_t disc = syn[i];
+
+        for (uint32_t j = 1; j <= l; j++)
+            disc ^= gfMul(lambda[j], syn[i - j]);
+
+        if (!disc)
+        {
+            shift++;
+            continue;
+        }
+
+        uint32_t coef = gfDiv(disc, prevDisc);
+        tmp = lambda;
+        for (uint32_t j = 0; j + shift <= 2 * t; j++)
+            lambda[j + shift] ^= gfMul(coef, prev[j]);
+
+        if (2 * l <= i)
+        {
+            l = i + 1 - l;
+            prev = tmp;
+            prevDisc = disc;
+            shift = 1;
+        }
+        else
+            shift++;
+    }
+
+    return l;
+}
+
+int EccBch::decode(uint8_t *data, uint8_t *ecc)
+{
+    std::vector<uint8_t> rem(eccBytes);
+    std::vector<uint32_t> syn(2 * t, 0), lambda;
+    std::vector<uint32_t> errPos;
+    uint32_t len = step * 8 + eccBits, errNum;
+
+    /* Remainder of received codeword is calculated ECC xor received ECC */
+    encode(data, rem.data());
+    bool isError = false;
+    for (uint32_t i = 0; i < eccBytes; i++)
+    {
+        rem[i] ^= ecc[i];
+        isError |= rem[i] != 0;
+    }
+    if (!isError)
+        return 0;
+
+    /* Syndromes S(j) = rem(alpha^j), j = 1..2t */
+    for (uint32_t k = 0; k < eccBits; k++)
+    {
+        if (!(rem[k / 8] & (0x80 >> (k % 8))))
+            continue;
+
+        uint32_t pos = eccBits - 1 - k;
+        for (uint32_t j = 0; j < 2 * t; j++)
+            syn[j] ^= alphaTo[((j + 1) * pos) % n];
+    }
+
+    errNum = errorLocator(syn, lambda);
+    if (errNum > t)
+        return -1;
+
+    /* Chien search, error at position p if lambda(alpha^-p) = 0 */
+    for (uint32_t p = 0; p < len && errPos.size() < errNum; p++)
+    {
+        uint32_t sum = 1;
+
+        for (uint32_t i = 1; i <= errNum; i++)
+        {
+            if (lambda[i])
+                sum ^= alphaTo[(indexOf[lambda[i]] + n - (p * i) % n) % n];
+        }
+
+        if (!sum)
+            errPos.push_back(p);
+    }
+
+    if (errPos.size() != errNum)
+        return -1;
+
+    for (uint32_t p : errPos)
+    {
+        if (p < eccBits)
+        {
+            uint32_t k = eccBits - 1 - p;
+            ecc[k / 8] ^= 0x80 >> (k % 8);
+        }
+        else
+        {
+            uint32_t k = step * 8 - 1 - (p - eccBits);
+            data[k / 8] ^= 0x80 >> (k % 8);
+        }
+    }
+
+    return static_cast<int>(errNum);
+}
@@ -0,0 +1,71 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef ECC_H
+#define ECC_H
+
+#include <cstdint>
+#include <vector>
+
+typedef struct
+{
+    uint32_t step;
+    uint32_t strength;
+    uint32_t offset;
+} EccLayout;
+
+class Ecc
+{
+protected:
+    uint32_t step;
+    uint32_t eccBytes;
+
+public:
+    Ecc(uint32_t step);
+    virtual ~Ecc();
+    uint32_t getStep();
+    uint32_t getEccBytes();
+    virtual void encode(const uint8_t *data, uint8_t *ecc) = 0;
+    /* Returns number of corrected bits or -1 if data is uncorrectable */
+    virtual int decode(uint8_t *data, uint8_t *ecc) = 0;
+
+    static Ecc *create(uint32_t step, uint32_t strength);
+};
+
+/* SmartMedia compatible Hamming code, corrects 1 bit per 256 or 512 bytes */
+class EccHamming : public Ecc
+{
+    uint8_t parityTable[256];
+
+public:
+    explicit EccHamming(uint32_t step);
+    void encode(const uint8_t *data, uint8_t *ecc) override;
+    int decode(uint8_t *data, uint8_t *ecc) override;
+};
+
+/* Binary BCH code over GF(2^m), corrects t bits per step */
+class EccBch : public Ecc
+{
+    uint32_t m;
+    uint32_t t;
+    uint32_t n;
+    uint32_t eccBits;
+    std::vector<uint32_t> alphaTo;
+    std::vector<uint32_t> indexOf;
+    std::vector<uint8_t> encodeTable;
+
+    void genPoly(std::vector<uint8_t> &poly);
+    uint32_t gfMul(uint32_t a, uint32_t b);
+    uint32_t gfDiv(uint32_t a, uint32_t b);
+    uint32_t errorLocator(const std::vector<uint32_t> &syn,
+        std::vector<uint32_t> &lambda);
+
+public:
+    EccBch(uint32_t step, uint32_t strength);
+    void encode(const uint8_t *data, uint8_t *ecc) override;
+    int decode(uint8_t *data, uint8_t *ecc) override;
+};
+
+#endif // ECC_H
@@ -0,0 +1,115 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "ecc_corrector.h"
+#include <QDebug>
+#include <vector>
+
+EccCorrector::EccCorrector(QObject *parent) : QObject(parent)
+{
+    isStopped = true;
+    total = 0;
+}
+
+EccCorrector::~EccCorrector()
+{
+    stop();
+}
+
+int EccCorrector::start(const QString &fileName, const EccLayout &layout,
+    uint32_t pageSize, uint32_t spareSize)
+{
+    stop();
+
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qCritical() << "Failed to open file:" << fileName << ", error:"
+            << file.errorString();
+        return -1;
+    }
+
+    total = static_cast<quint64>(file.size());
+    if (!total)
+    {
+        qInfo() << "File is empty";
+        file.close();
+        return -1;
+    }
+
+    if (engine.init(layout, pageSize, spareSize))
+    {
+        qCritical() << "ECC layout is not supported";
+        file.close();
+        return -1;
+    }
+
+    if (decoder.open(&engine, fileName, 0))
+    {
+        engine.uninit();
+        file.close();
+        return -1;
+    }
+
+    isStopped = false;
+    thread = std::thread(&EccCorrector::worker, this);
+
+    return 0;
+}
+
+void EccCorrector::stop()
+{
+    if (!thread.joinable())
+        return;
+
+    isStopped = true;
+    thread.join();
+}
+
+bool EccCorrector::isRunning()
+{
+    return thread.joinable();
+}
+
+void EccCorrector::worker()
+{
+    std::vector<uint8_t> buf(engine.batchPages * engine.getRawPageSize());
+    quint64 done = 0;
+    qint64 readSize = 0;
+    int ret = 0;
+
+    while (!isStopped && (readSize = file.read(
+        reinterpret_cast<char *>(buf.data()), buf.size())) > 0)
+    {
+        if ((ret = decoder.write(buf.data(), readSize)))
+            break;
+
+        done += readSize;
+        emit progress(done, total);
+    }
+
+    if (!ret && readSize < 0)
+    {
+        qCritical() << "Failed to read file:" << file.errorString();
+        ret = -1;
+    }
+
+    if (decoder.close())
+        ret = -1;
+    engine.uninit();
+    file.close();
+
+    emit finished(!ret && !isStopped);
+}
+
+quint64 EccCorrector::getCorrectedBits()
+{
+    return decoder.getCorrectedBits();
+}
+
+quint64 EccCorrector::getFailedPages()
+{
+    return decoder.getFailedPages();
+}
@@ -0,0 +1,50 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef ECC_CORRECTOR_H
+#define ECC_CORRECTOR_H
+
+#include "ecc_decoder.h"
+#include "ecc_engine.h"
+#include <QFile>
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+/* Corrects raw dump by software ECC on a worker thread, result is written
+ * by EccDecoder next to the dump.
+ */
+class EccCorrector : public QObject
+{
+    Q_OBJECT
+
+    EccEngine engine;
+    EccDecoder decoder;
+    QFile file;
+    std::thread thread;
+    std::atomic<bool> isStopped;
+    quint64 total;
+
+    void worker();
+
+public:
+    explicit EccCorrector(QObject *parent = nullptr);
+    ~EccCorrector();
+    int start(const QString &fileName, const EccLayout &layout,
+        uint32_t pageSize, uint32_t spareSize);
+    void stop();
+    bool isRunning();
+    /* Valid after finished signal */
+    quint64 getCorrectedBits();
+    quint64 getFailedPages();
+
+signals:
+    void progress(quint64 done, quint64 total);
+    void finished(bool isCompleted);
+};
+
+#endif // ECC_CORRECTOR_H
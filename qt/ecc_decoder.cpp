@@ -0,0 +1,136 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "ecc_decoder.h"
+#include <QDebug>
+
+EccDecoder::EccDecoder()
+{
+    engine = nullptr;
+    page = 0;
+    correctedBits = 0;
+    failedPages = 0;
+}
+
+EccDecoder::~EccDecoder()
+{
+    dataFile.close();
+    reportFile.close();
+}
+
+/* Creates <fileName>.corrected image and <fileName>.report */
+int EccDecoder::open(EccEngine *engine, const QString &fileName,
+    quint64 startPage)
+{
+    dataFile.setFileName(fileName + ".corrected");
+    if (!dataFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qCritical() << "Failed to open file:" << dataFile.fileName()
+            << ", error:" << dataFile.errorString();
+        return -1;
+    }
+
+    reportFile.setFileName(fileName + ".report");
+    if (!reportFile.open(QIODevice::WriteOnly | QIODevice::Truncate |
+        QIODevice::Text))
+    {
+        qCritical() << "Failed to open file:" << reportFile.fileName()
+            << ", error:" << reportFile.errorString();
+        dataFile.close();
+        return -1;
+    }
+    reportFile.write("# page, corrected bits (-1 - uncorrectable)\n");
+
+    this->engine = engine;
+    page = startPage;
+    correctedBits = 0;
+    failedPages = 0;
+    raw.clear();
+
+    return 0;
+}
+
+int EccDecoder::decodeBatch(const uint8_t *buf, uint32_t pages)
+{
+    std::vector<uint8_t> data(pages * engine->getPageSize());
+    std::vector<int> bits(pages);
+    QByteArray report;
+
+    engine->decode(buf, data.data(), bits.data(), pages);
+
+    for (uint32_t i = 0; i < pages; i++, page++)
+    {
+        if (bits[i] < 0)
+            failedPages++;
+        else
+            correctedBits += static_cast<quint64>(bits[i]);
+
+        report.append(QString("%1, %2\n").arg(page).arg(bits[i]).toLatin1());
+    }
+
+    if (dataFile.write(reinterpret_cast<const char *>(data.data()),
+        static_cast<qint64>(data.size())) < 0 ||
+        reportFile.write(report) < 0)
+    {
+        qCritical() << "Failed to write ECC corrected data";
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Raw data is buffered until the batch of pages is complete */
+int EccDecoder::write(const uint8_t *buf, size_t len)
+{
+    uint32_t rawPageSize = engine->getRawPageSize();
+    size_t batchSize = engine->batchPages * rawPageSize;
+
+    raw.insert(raw.end(), buf, buf + len);
+    if (raw.size() < batchSize)
+        return 0;
+
+    uint32_t pages = static_cast<uint32_t>(raw.size() / rawPageSize);
+    int ret = decodeBatch(raw.data(), pages);
+    raw.erase(raw.begin(), raw.begin() + pages * rawPageSize);
+
+    return ret;
+}
+
+int EccDecoder::close()
+{
+    uint32_t rawPageSize = engine->getRawPageSize();
+    uint32_t pages = static_cast<uint32_t>(raw.size() / rawPageSize);
+    int ret = 0;
+
+    if (pages)
+        ret = decodeBatch(raw.data(), pages);
+
+    if (raw.size() % rawPageSize)
+        qWarning() << "ECC decoder skipped incomplete page at the end";
+
+    reportFile.write(QString("# corrected bits: %1, uncorrectable pages: %2\n")
+        .arg(correctedBits).arg(failedPages).toLatin1());
+
+    raw.clear();
+    dataFile.close();
+    reportFile.close();
+
+    return ret;
+}
+
+bool EccDecoder::isOpen()
+{
+    return dataFile.isOpen();
+}
+
+quint64 EccDecoder::getCorrectedBits()
+{
+    return correctedBits;
+}
+
+quint64 EccDecoder::getFailedPages()
+{
+    return failedPages;
+}
@@ -0,0 +1,38 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef ECC_DECODER_H
+#define ECC_DECODER_H
+
+#include "ecc_engine.h"
+#include <QFile>
+#include <QString>
+#include <vector>
+
+/* Corrects raw pages with spare area into data only image and report */
+class EccDecoder
+{
+    EccEngine *engine;
+    QFile dataFile;
+    QFile reportFile;
+    std::vector<uint8_t> raw;
+    quint64 page;
+    quint64 correctedBits;
+    quint64 failedPages;
+
+    int decodeBatch(const uint8_t *buf, uint32_t pages);
+
+public:
+    EccDecoder();
+    ~EccDecoder();
+    int open(EccEngine *engine, const QString &fileName, quint64 startPage);
+    int write(const uint8_t *buf, size_t len);
+    int close();
+    bool isOpen();
+    quint64 getCorrectedBits();
+    quint64 getFailedPages();
+};
+
+#endif // ECC_DECODER_H
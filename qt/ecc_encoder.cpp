@@ -0,0 +1,142 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "ecc_encoder.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+EccEncoder::EccEncoder()
+{
+    engine = nullptr;
+    queuePos = 0;
+    isStopped = true;
+    isDone = false;
+    isError = false;
+}
+
+EccEncoder::~EccEncoder()
+{
+    stop();
+}
+
+int EccEncoder::start(EccEngine *engine, const SourceFunc &source)
+{
+    stop();
+
+    if (!engine->isActive())
+        return -1;
+
+    this->engine = engine;
+    this->source = source;
+    queue.clear();
+    queuePos = 0;
+    isStopped = false;
+    isDone = false;
+    isError = false;
+
+    thread = std::thread(&EccEncoder::producer, this);
+
+    return 0;
+}
+
+void EccEncoder::stop()
+{
+    if (thread.joinable())
+    {
+        {
+            std::unique_lock<std::mutex> lck(mutex);
+            isStopped = true;
+            cv.notify_all();
+        }
+        thread.join();
+    }
+
+    queue.clear();
+    source = nullptr;
+}
+
+bool EccEncoder::isRunning()
+{
+    return thread.joinable();
+}
+
+/* Waits while queue is full, returns -1 if encoder is stopped */
+int EccEncoder::push(std::vector<uint8_t> &raw)
+{
+    std::unique_lock<std::mutex> lck(mutex);
+
+    cv.wait(lck, [this] { return isStopped || queue.size() < queueMax; });
+    if (isStopped)
+        return -1;
+
+    queue.push_back(std::move(raw));
+    cv.notify_all();
+
+    return 0;
+}
+
+void EccEncoder::producer()
+{
+    uint32_t dataPageSize = engine->getPageSize();
+    uint32_t rawPageSize = engine->getRawPageSize();
+    std::vector<uint8_t> data(engine->batchPages * dataPageSize);
+    qint64 readSize;
+    int ret = 0;
+
+    while ((readSize = source(data.data(), data.size())) > 0)
+    {
+        uint32_t pages = (readSize + dataPageSize - 1) / dataPageSize;
+        std::vector<uint8_t> raw(pages * rawPageSize);
+
+        std::fill(data.begin() + readSize, data.end(), 0xFF);
+        engine->encode(data.data(), raw.data(), pages);
+        if ((ret = push(raw)))
+            break;
+    }
+
+    if (readSize < 0)
+        ret = -1;
+
+    std::unique_lock<std::mutex> lck(mutex);
+    isDone = true;
+    isError = ret != 0;
+    cv.notify_all();
+}
+
+qint64 EccEncoder::read(uint8_t *buf, qint64 len)
+{
+    std::unique_lock<std::mutex> lck(mutex);
+    qint64 done = 0;
+
+    while (done < len)
+    {
+        cv.wait(lck, [this] { return isDone || !queue.empty(); });
+        if (queue.empty())
+            break;
+
+        std::vector<uint8_t> &chunk = queue.front();
+        size_t copyLen = std::min<size_t>(chunk.size() - queuePos,
+            static_cast<size_t>(len - done));
+
+        memcpy(buf + done, chunk.data() + queuePos, copyLen);
+        done += copyLen;
+        queuePos += copyLen;
+        if (queuePos == chunk.size())
+        {
+            queue.pop_front();
+            queuePos = 0;
+            cv.notify_all();
+        }
+    }
+
+    if (isError && done < len)
+    {
+        qCritical() << "Failed to encode data pages";
+        return -1;
+    }
+
+    return done;
+}
@@ -0,0 +1,53 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef ECC_ENCODER_H
+#define ECC_ENCODER_H
+
+#include "ecc_engine.h"
+#include <QtGlobal>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Encodes data pages into raw pages with spare area on a producer thread
+ * ahead of writer, encoded batches are kept in a bounded queue.
+ */
+class EccEncoder
+{
+    typedef std::function<qint64(uint8_t *buf, qint64 len)> SourceFunc;
+
+    const size_t queueMax = 4;
+
+    EccEngine *engine;
+    SourceFunc source;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::vector<uint8_t>> queue;
+    size_t queuePos;
+    bool isStopped;
+    bool isDone;
+    bool isError;
+
+    int push(std::vector<uint8_t> &raw);
+    void producer();
+
+public:
+    EccEncoder();
+    ~EccEncoder();
+    /* Source is read only by producer thread until encoder is stopped */
+    int start(EccEngine *engine, const SourceFunc &source);
+    void stop();
+    bool isRunning();
+    /* Returns less than len only at the end of data */
+    qint64 read(uint8_t *buf, qint64 len);
+};
+
+#endif // ECC_ENCODER_H
@@ -0,0 +1,228 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "ecc_engine.h"
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+
+EccEngine::EccEngine()
+{
+    ecc = nullptr;
+    pageSize = 0;
+    spareSize = 0;
+    steps = 0;
+    threadNum = std::max(std::thread::hardware_concurrency(), 1U);
+    job = nullptr;
+    jobPages = 0;
+    jobChunk = 0;
+    jobNext = 0;
+    jobChunksLeft = 0;
+    isStopped = false;
+}
+
+EccEngine::~EccEngine()
+{
+    {
+        std::unique_lock<std::mutex> lck(mutex);
+        isStopped = true;
+        cv.notify_all();
+    }
+
+    for (std::thread &thread : threads)
+        thread.join();
+
+    uninit();
+}
+
+int EccEngine::init(const EccLayout &layout, uint32_t pageSize,
+    uint32_t spareSize)
+{
+    uninit();
+
+    if (!layout.step || pageSize % layout.step)
+        return -1;
+
+    ecc = Ecc::create(layout.step, layout.strength);
+    if (!ecc)
+        return -1;
+
+    steps = pageSize / layout.step;
+    if (layout.offset + steps * ecc->getEccBytes() > spareSize)
+    {
+        uninit();
+        return -1;
+    }
+
+    this->layout = layout;
+    this->pageSize = pageSize;
+    this->spareSize = spareSize;
+
+    return 0;
+}
+
+void EccEngine::uninit()
+{
+    delete ecc;
+    ecc = nullptr;
+}
+
+bool EccEngine::isActive()
+{
+    return ecc != nullptr;
+}
+
+uint32_t EccEngine::getPageSize()
+{
+    return pageSize;
+}
+
+uint32_t EccEngine::getRawPageSize()
+{
+    return pageSize + spareSize;
+}
+
+/* Takes chunks of the current job until all of them are taken */
+void EccEngine::worker()
+{
+    std::unique_lock<std::mutex> lck(mutex);
+
+    while (true)
+    {
+        cv.wait(lck, [this] { return isStopped || jobNext < jobPages; });
+        if (isStopped)
+            return;
+
+        uint32_t first = jobNext;
+        uint32_t last = std::min(first + jobChunk, jobPages);
+
+        jobNext = last;
+        lck.unlock();
+        (*job)(first, last);
+        lck.lock();
+
+        if (!--jobChunksLeft)
+            doneCv.notify_all();
+    }
+}
+
+/* Split pages between worker threads, f(first, last) handles a range */
+void EccEngine::run(uint32_t pages,
+    const std::function<void(uint32_t, uint32_t)> &f)
+{
+    std::lock_guard<std::mutex> runLck(runMutex);
+    uint32_t chunk = (pages + threadNum - 1) / threadNum;
+
+    if (threadNum == 1 || pages < 2)
+    {
+        f(0, pages);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lck(mutex);
+
+    while (threads.size() < threadNum)
+        threads.emplace_back(&EccEngine::worker, this);
+
+    job = &f;
+    jobPages = pages;
+    jobChunk = chunk;
+    jobNext = 0;
+    jobChunksLeft = (pages + chunk - 1) / chunk;
+    cv.notify_all();
+
+    doneCv.wait(lck, [this] { return !jobChunksLeft; });
+    job = nullptr;
+    jobPages = 0;
+    jobNext = 0;
+}
+
+void EccEngine::encodePage(const uint8_t *in, uint8_t *out)
+{
+    uint8_t *spare = out + pageSize;
+
+    memcpy(out, in, pageSize);
+    memset(spare, 0xFF, spareSize);
+
+    /* Keep erased pages erased so they can be programmed later */
+    if (std::all_of(in, in + pageSize, [](uint8_t b) { return b == 0xFF; }))
+        return;
+
+    for (uint32_t i = 0; i < steps; i++)
+    {
+        ecc->encode(in + i * layout.step,
+            spare + layout.offset + i * ecc->getEccBytes());
+    }
+}
+
+void EccEngine::encode(const uint8_t *in, uint8_t *out, uint32_t pages)
+{
+    uint32_t rawPageSize = getRawPageSize();
+
+    run(pages, [this, in, out, rawPageSize](uint32_t first, uint32_t last)
+    {
+        for (uint32_t i = first; i < last; i++)
+            encodePage(in + i * pageSize, out + i * rawPageSize);
+    });
+}
+
+/* Erased step may have few bitflips, ECC does not match it */
+int EccEngine::decodeErased(uint8_t *data, uint8_t *ecc)
+{
+    uint32_t eccBytes = this->ecc->getEccBytes();
+    uint32_t zeroBits = 0;
+
+    for (uint32_t i = 0; i < layout.step + eccBytes; i++)
+    {
+        uint8_t b = i < layout.step ? data[i] : ecc[i - layout.step];
+
+        zeroBits += 8 - std::bitset<8>(b).count();
+        if (zeroBits > layout.strength)
+            return -1;
+    }
+
+    memset(data, 0xFF, layout.step);
+
+    return static_cast<int>(zeroBits);
+}
+
+int EccEngine::decodePage(const uint8_t *in, uint8_t *out)
+{
+    std::vector<uint8_t> spare(in + pageSize, in + pageSize + spareSize);
+    int bits = 0;
+    bool isFailed = false;
+
+    memcpy(out, in, pageSize);
+
+    for (uint32_t i = 0; i < steps; i++)
+    {
+        uint8_t *data = out + i * layout.step;
+        uint8_t *code = spare.data() + layout.offset + i * ecc->getEccBytes();
+        int ret;
+
+        if ((ret = decodeErased(data, code)) < 0)
+            ret = ecc->decode(data, code);
+
+        if (ret < 0)
+            isFailed = true;
+        else
+            bits += ret;
+    }
+
+    return isFailed ? -1 : bits;
+}
+
+void EccEngine::decode(const uint8_t *in, uint8_t *out, int *bits,
+    uint32_t pages)
+{
+    uint32_t rawPageSize = getRawPageSize();
+
+    run(pages, [this, in, out, bits, rawPageSize](uint32_t first,
+        uint32_t last)
+    {
+        for (uint32_t i = first; i < last; i++)
+            bits[i] = decodePage(in + i * rawPageSize, out + i * pageSize);
+    });
+}
@@ -0,0 +1,60 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef ECC_ENGINE_H
+#define ECC_ENGINE_H
+
+#include "ecc.h"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class EccEngine
+{
+    Ecc *ecc;
+    EccLayout layout;
+    uint32_t pageSize;
+    uint32_t spareSize;
+    uint32_t steps;
+    uint32_t threadNum;
+
+    /* Worker threads are kept alive between batches */
+    std::vector<std::thread> threads;
+    std::mutex runMutex;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::condition_variable doneCv;
+    const std::function<void(uint32_t, uint32_t)> *job;
+    uint32_t jobPages;
+    uint32_t jobChunk;
+    uint32_t jobNext;
+    uint32_t jobChunksLeft;
+    bool isStopped;
+
+    void worker();
+    void run(uint32_t pages, const std::function<void(uint32_t, uint32_t)> &f);
+    void encodePage(const uint8_t *in, uint8_t *out);
+    int decodeErased(uint8_t *data, uint8_t *ecc);
+    int decodePage(const uint8_t *in, uint8_t *out);
+
+public:
+    /* Pages processed at once to keep all threads busy */
+    const uint32_t batchPages = 256;
+
+    EccEngine();
+    ~EccEngine();
+    int init(const EccLayout &layout, uint32_t pageSize, uint32_t spareSize);
+    void uninit();
+    bool isActive();
+    uint32_t getPageSize();
+    uint32_t getRawPageSize();
+    void encode(const uint8_t *in, uint8_t *out, uint32_t pages);
+    void decode(const uint8_t *in, uint8_t *out, int *bits, uint32_t pages);
+};
+
+#endif // ECC_ENGINE_H
@@ -0,0 +1,40 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "image_device.h"
+#include "dump_file.h"
+#include "zstd_seekable.h"
+#include <memory>
+
+bool ImageDevice::isContainer(const QString &fileName)
+{
+#ifdef HAVE_ZSTD
+    if (ZstdSeekTable::isSeekable(fileName))
+        return true;
+#endif
+
+    return DumpFile::isDump(fileName);
+}
+
+QIODevice *ImageDevice::create(const QString &fileName)
+{
+    if (DumpFile::isDump(fileName))
+    {
+        std::unique_ptr<DumpDevice> device(new DumpDevice());
+
+        return device->setFileName(fileName) ? nullptr : device.release();
+    }
+
+#ifdef HAVE_ZSTD
+    if (ZstdSeekTable::isSeekable(fileName))
+    {
+        std::unique_ptr<ZstdDevice> device(new ZstdDevice());
+
+        return device->setFileName(fileName) ? nullptr : device.release();
+    }
+#endif
+
+    return nullptr;
+}
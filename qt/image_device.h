@@ -0,0 +1,23 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef IMAGE_DEVICE_H
+#define IMAGE_DEVICE_H
+
+#include <QIODevice>
+#include <QString>
+
+/* Read files which store chip image in a container: dump file or seekable
+ * zstd file. Plain files are read by QFile.
+ */
+class ImageDevice
+{
+public:
+    static bool isContainer(const QString &fileName);
+    /* Returns device not opened yet or nullptr on error */
+    static QIODevice *create(const QString &fileName);
+};
+
+#endif // IMAGE_DEVICE_H
@@ -0,0 +1,631 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "image_source.h"
+#include "zstd_seekable.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#include <lzma.h>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+enum
+{
+    IMAGE_FORMAT_NONE,
+    IMAGE_FORMAT_GZIP,
+    IMAGE_FORMAT_XZ,
+    IMAGE_FORMAT_ZSTD,
+};
+
+enum
+{
+    DECODE_ERROR = -1,
+    DECODE_OK    =  0,
+    DECODE_END   =  1,
+};
+
+static const uint8_t gzipMagic[] = { 0x1F, 0x8B };
+static const uint8_t xzMagic[] = { 0xFD, 0x37, 0x7A, 0x58, 0x5A, 0x00 };
+static const uint8_t zstdMagic[] = { 0x28, 0xB5, 0x2F, 0xFD };
+
+/* Decodes input into output, advances buffers by consumed and produced
+ * bytes. Returns DECODE_END after the last stream of input.
+ */
+class ImageDecoder
+{
+public:
+    virtual ~ImageDecoder() {}
+    virtual int decode(const uint8_t *&in, size_t &inLen, uint8_t *&out,
+        size_t &outLen, bool isInputEnd) = 0;
+};
+
+/* Concatenated gzip members are decoded as one stream like gunzip does */
+class GzipDecoder : public ImageDecoder
+{
+    z_stream zs;
+    bool isInit;
+    bool isMemberEnd;
+
+public:
+    GzipDecoder()
+    {
+        memset(&zs, 0, sizeof(zs));
+        isInit = inflateInit2(&zs, 15 + 16) == Z_OK;
+        isMemberEnd = false;
+    }
+
+    ~GzipDecoder() override
+    {
+        if (isInit)
+            inflateEnd(&zs);
+    }
+
+    int decode(const uint8_t *&in, size_t &inLen, uint8_t *&out,
+        size_t &outLen, bool isInputEnd) override
+    {
+        int ret;
+
+        if (!isInit)
+            return DECODE_ERROR;
+
+        zs.next_in = const_cast<Bytef *>(in);
+        zs.avail_in = static_cast<uInt>(inLen);
+        zs.next_out = out;
+        zs.avail_out = static_cast<uInt>(outLen);
+
+        ret = inflate(&zs, Z_NO_FLUSH);
+
+        in = zs.next_in;
+        inLen = zs.avail_in;
+        out = zs.next_out;
+        outLen = zs.avail_out;
+
+        if (ret == Z_STREAM_END)
+        {
+            isMemberEnd = true;
+            return inflateReset(&zs) == Z_OK ? DECODE_OK : DECODE_ERROR;
+        }
+
+        /* No progress is possible, input ends after a member or truncated */
+        if (ret == Z_BUF_ERROR && isInputEnd && !inLen)
+            return isMemberEnd ? DECODE_END : DECODE_ERROR;
+
+        if (ret != Z_OK && ret != Z_BUF_ERROR)
+            return DECODE_ERROR;
+
+        if (ret == Z_OK)
+            isMemberEnd = false;
+
+        return DECODE_OK;
+    }
+};
+
+class XzDecoder : public ImageDecoder
+{
+    lzma_stream strm;
+    bool isInit;
+
+public:
+    XzDecoder()
+    {
+        strm = LZMA_STREAM_INIT;
+        isInit = lzma_stream_decoder(&strm, UINT64_MAX, LZMA_CONCATENATED) ==
+            LZMA_OK;
+    }
+
+    ~XzDecoder() override
+    {
+        lzma_end(&strm);
+    }
+
+    int decode(const uint8_t *&in, size_t &inLen, uint8_t *&out,
+        size_t &outLen, bool isInputEnd) override
+    {
+        lzma_ret ret;
+
+        if (!isInit)
+            return DECODE_ERROR;
+
+        strm.next_in = in;
+        strm.avail_in = inLen;
+        strm.next_out = out;
+        strm.avail_out = outLen;
+
+        ret = lzma_code(&strm, isInputEnd ? LZMA_FINISH : LZMA_RUN);
+
+        in = strm.next_in;
+        inLen = strm.avail_in;
+        out = strm.next_out;
+        outLen = strm.avail_out;
+
+        if (ret == LZMA_STREAM_END)
+            return DECODE_END;
+
+        /* Buffer error at the end of input means truncated stream */
+        if (ret == LZMA_BUF_ERROR && !isInputEnd)
+            return DECODE_OK;
+
+        return ret == LZMA_OK ? DECODE_OK : DECODE_ERROR;
+    }
+};
+
+#ifdef HAVE_ZSTD
+class ZstdDecoder : public ImageDecoder
+{
+    ZSTD_DStream *ds;
+    bool isFrameEnd;
+
+public:
+    ZstdDecoder()
+    {
+        ds = ZSTD_createDStream();
+        if (ds)
+            ZSTD_initDStream(ds);
+        isFrameEnd = false;
+    }
+
+    ~ZstdDecoder() override
+    {
+        ZSTD_freeDStream(ds);
+    }
+
+    int decode(const uint8_t *&in, size_t &inLen, uint8_t *&out,
+        size_t &outLen, bool isInputEnd) override
+    {
+        ZSTD_inBuffer inBuf = { in, inLen, 0 };
+        ZSTD_outBuffer outBuf = { out, outLen, 0 };
+        size_t ret;
+
+        if (!ds)
+            return DECODE_ERROR;
+
+        ret = ZSTD_decompressStream(ds, &outBuf, &inBuf);
+
+        in += inBuf.pos;
+        inLen -= inBuf.pos;
+        out += outBuf.pos;
+        outLen -= outBuf.pos;
+
+        if (ZSTD_isError(ret))
+            return DECODE_ERROR;
+
+        /* Frame is complete when all its data is flushed */
+        if (isInputEnd && !inBuf.pos && !outBuf.pos)
+            return isFrameEnd ? DECODE_END : DECODE_ERROR;
+        isFrameEnd = !ret;
+
+        return DECODE_OK;
+    }
+};
+#endif
+
+static bool hasMagic(const QByteArray &header, const uint8_t *magic,
+    size_t len)
+{
+    return static_cast<size_t>(header.size()) >= len &&
+        !memcmp(header.constData(), magic, len);
+}
+
+static int detectFormat(QFile &file)
+{
+    QByteArray header = file.peek(sizeof(xzMagic));
+
+    if (hasMagic(header, gzipMagic, sizeof(gzipMagic)))
+        return IMAGE_FORMAT_GZIP;
+    if (hasMagic(header, xzMagic, sizeof(xzMagic)))
+        return IMAGE_FORMAT_XZ;
+    if (hasMagic(header, zstdMagic, sizeof(zstdMagic)))
+        return IMAGE_FORMAT_ZSTD;
+
+    return IMAGE_FORMAT_NONE;
+}
+
+static ImageDecoder *createDecoder(int format)
+{
+    switch (format)
+    {
+    case IMAGE_FORMAT_GZIP:
+        return new GzipDecoder();
+    case IMAGE_FORMAT_XZ:
+        return new XzDecoder();
+#ifdef HAVE_ZSTD
+    case IMAGE_FORMAT_ZSTD:
+        return new ZstdDecoder();
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+ImageSource::ImageSource(QObject *parent) : QObject(parent)
+{
+    format = IMAGE_FORMAT_NONE;
+    imageSize = 0;
+    isSizeValid = false;
+    queuePos = 0;
+    isStopped = true;
+    isDone = false;
+    isError = false;
+}
+
+ImageSource::~ImageSource()
+{
+    close();
+}
+
+bool ImageSource::isCompressed(const QString &fileName)
+{
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    return detectFormat(file) != IMAGE_FORMAT_NONE;
+}
+
+/* Reads whole input and passes decoded data to sink */
+int ImageSource::decodeStream(const SinkFunc &sink)
+{
+    std::vector<uint8_t> inBuf(inChunkSize), outBuf(outChunkSize);
+    const uint8_t *in = inBuf.data();
+    size_t inLen = 0;
+    bool isInputEnd = false;
+
+    while (true)
+    {
+        if (!inLen && !isInputEnd)
+        {
+            qint64 readSize = file.read(reinterpret_cast<char *>(inBuf.data()),
+                static_cast<qint64>(inBuf.size()));
+
+            if (readSize < 0)
+            {
+                errorString = "Failed to read file: " + file.errorString();
+                return -1;
+            }
+            in = inBuf.data();
+            inLen = static_cast<size_t>(readSize);
+            isInputEnd = !readSize;
+        }
+
+        uint8_t *out = outBuf.data();
+        size_t outLen = outBuf.size(), prevInLen = inLen;
+        int ret = decoder->decode(in, inLen, out, outLen, isInputEnd);
+        size_t produced = outBuf.size() - outLen;
+
+        if (produced && sink(outBuf.data(), produced))
+            return -1;
+
+        if (ret == DECODE_END)
+            return 0;
+
+        if (ret == DECODE_ERROR ||
+            (isInputEnd && !produced && inLen == prevInLen))
+        {
+            errorString = "Image is corrupted or truncated";
+            return -1;
+        }
+    }
+}
+
+/* Size is stored by xz index and zstd frame header, gzip keeps it only
+ * modulo 4 GiB, so it is counted by a decode pass without output.
+ */
+int ImageSource::sizeFromHeader()
+{
+    if (format == IMAGE_FORMAT_XZ)
+        return sizeFromXzIndex();
+
+#ifdef HAVE_ZSTD
+    if (format == IMAGE_FORMAT_ZSTD)
+    {
+        std::vector<ZstdSeekTable::Entry> seekTable;
+
+        /* Seekable file has many frames, size is in seek table */
+        if (!ZstdSeekTable::read(file, seekTable))
+        {
+            imageSize = 0;
+            for (const ZstdSeekTable::Entry &entry : seekTable)
+                imageSize += entry.decompressedSize;
+
+            return 0;
+        }
+
+        return sizeFromZstdFrames();
+    }
+#endif
+
+    return -1;
+}
+
+#ifdef HAVE_ZSTD
+/* Image may be a number of concatenated frames, size is known only if it is
+ * stored in the header of every frame.
+ */
+int ImageSource::sizeFromZstdFrames()
+{
+    qint64 fileSize = file.size();
+    uchar *data = fileSize > 0 ? file.map(0, fileSize) : nullptr;
+    size_t pos = 0, left = static_cast<size_t>(fileSize);
+    int ret = 0;
+
+    if (!data)
+        return -1;
+
+    imageSize = 0;
+    while (left)
+    {
+        unsigned long long contentSize =
+            ZSTD_getFrameContentSize(data + pos, left);
+        size_t frameSize = ZSTD_findFrameCompressedSize(data + pos, left);
+
+        if (contentSize == ZSTD_CONTENTSIZE_UNKNOWN ||
+            contentSize == ZSTD_CONTENTSIZE_ERROR ||
+            ZSTD_isError(frameSize) || frameSize > left)
+        {
+            ret = -1;
+            break;
+        }
+
+        imageSize += contentSize;
+        pos += frameSize;
+        left -= frameSize;
+    }
+
+    file.unmap(data);
+
+    return ret;
+}
+#endif
+
+/* Index is trusted only if file is a single stream */
+int ImageSource::sizeFromXzIndex()
+{
+    lzma_stream_flags flags;
+    lzma_index *index = nullptr;
+    uint64_t memLimit = UINT64_MAX;
+    size_t pos = 0;
+    qint64 end = file.size();
+    QByteArray footer;
+    int ret = -1;
+
+    /* Stream padding is a multiple of 4 zero bytes */
+    while (end >= 4 && end % 4 == 0)
+    {
+        if (!file.seek(end - 4))
+            return -1;
+        if (file.read(4) != QByteArray(4, 0))
+            break;
+        end -= 4;
+    }
+
+    if (end < 2 * LZMA_STREAM_HEADER_SIZE ||
+        !file.seek(end - LZMA_STREAM_HEADER_SIZE))
+    {
+        return -1;
+    }
+
+    footer = file.read(LZMA_STREAM_HEADER_SIZE);
+    if (footer.size() != LZMA_STREAM_HEADER_SIZE ||
+        lzma_stream_footer_decode(&flags,
+        reinterpret_cast<const uint8_t *>(footer.constData())) != LZMA_OK)
+    {
+        return -1;
+    }
+
+    qint64 indexOffset = end - LZMA_STREAM_HEADER_SIZE -
+        static_cast<qint64>(flags.backward_size);
+    if (indexOffset < LZMA_STREAM_HEADER_SIZE || !file.seek(indexOffset))
+        return -1;
+
+    QByteArray indexBuf = file.read(flags.backward_size);
+    if (static_cast<uint64_t>(indexBuf.size()) == flags.backward_size &&
+        lzma_index_buffer_decode(&index, &memLimit, nullptr,
+        reinterpret_cast<const uint8_t *>(indexBuf.constData()), &pos,
+        indexBuf.size()) == LZMA_OK)
+    {
+        if (lzma_index_file_size(index) == static_cast<uint64_t>(end))
+        {
+            imageSize = lzma_index_uncompressed_size(index);
+            ret = 0;
+        }
+        lzma_index_end(index, nullptr);
+    }
+
+    return ret;
+}
+
+int ImageSource::open(const QString &fileName)
+{
+    close();
+
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qCritical() << "Failed to open file:" << fileName << ", error:"
+            << file.errorString();
+        return -1;
+    }
+
+    format = detectFormat(file);
+    decoder.reset(createDecoder(format));
+    if (!decoder)
+    {
+        qCritical() << "Image format of" << fileName << "is not supported";
+        file.close();
+        return -1;
+    }
+
+    isSizeValid = !sizeFromHeader();
+    if (!isSizeValid)
+        qInfo() << "Calculating size of image ...";
+
+    if (!file.seek(0))
+    {
+        qCritical() << "Failed to seek file:" << file.errorString();
+        file.close();
+        return -1;
+    }
+
+    queue.clear();
+    queuePos = 0;
+    isStopped = false;
+    isDone = false;
+    isError = false;
+    errorString.clear();
+
+    thread = std::thread(&ImageSource::producer, this);
+
+    return 0;
+}
+
+void ImageSource::close()
+{
+    if (thread.joinable())
+    {
+        {
+            std::unique_lock<std::mutex> lck(mutex);
+            isStopped = true;
+            cv.notify_all();
+        }
+        thread.join();
+    }
+
+    queue.clear();
+    decoder.reset();
+    file.close();
+}
+
+bool ImageSource::isOpen()
+{
+    return file.isOpen();
+}
+
+bool ImageSource::isSizeKnown()
+{
+    std::unique_lock<std::mutex> lck(mutex);
+
+    return isSizeValid;
+}
+
+quint64 ImageSource::size()
+{
+    return imageSize;
+}
+
+/* Waits while queue is full, returns -1 if source is closed */
+int ImageSource::push(const uint8_t *buf, size_t len)
+{
+    std::unique_lock<std::mutex> lck(mutex);
+
+    cv.wait(lck, [this] { return isStopped || queue.size() < queueMax; });
+    if (isStopped)
+        return -1;
+
+    queue.emplace_back(buf, buf + len);
+    cv.notify_all();
+
+    return 0;
+}
+
+/* Decode pass without output, it is stopped if source is closed */
+int ImageSource::countSize()
+{
+    int ret;
+
+    imageSize = 0;
+    ret = decodeStream([this](const uint8_t *, size_t len)
+    {
+        std::unique_lock<std::mutex> lck(mutex);
+
+        imageSize += len;
+        return isStopped ? -1 : 0;
+    });
+
+    if (!ret)
+    {
+        decoder.reset(createDecoder(format));
+        if (!file.seek(0))
+        {
+            errorString = "Failed to seek file: " + file.errorString();
+            ret = -1;
+        }
+    }
+
+    std::unique_lock<std::mutex> lck(mutex);
+    isSizeValid = !ret;
+
+    return ret;
+}
+
+void ImageSource::producer()
+{
+    quint64 decoded = 0;
+    int ret = 0;
+
+    if (!isSizeKnown())
+    {
+        ret = countSize();
+        if (!ret || !errorString.isEmpty())
+            emit sizeReady(!ret);
+    }
+
+    if (!ret)
+    {
+        ret = decodeStream([this, &decoded](const uint8_t *buf, size_t len)
+            { decoded += len; return push(buf, len); });
+    }
+
+    if (!ret && decoded != imageSize)
+    {
+        errorString = QString("Image size %1 differs from expected %2")
+            .arg(decoded).arg(imageSize);
+        ret = -1;
+    }
+
+    std::unique_lock<std::mutex> lck(mutex);
+    isDone = true;
+    isError = ret != 0;
+    cv.notify_all();
+}
+
+/* Returns less than len only at the end of image */
+qint64 ImageSource::read(uint8_t *buf, qint64 len)
+{
+    std::unique_lock<std::mutex> lck(mutex);
+    qint64 done = 0;
+
+    while (done < len)
+    {
+        cv.wait(lck, [this] { return isDone || !queue.empty(); });
+        if (queue.empty())
+            break;
+
+        std::vector<uint8_t> &chunk = queue.front();
+        size_t copyLen = std::min<size_t>(chunk.size() - queuePos,
+            static_cast<size_t>(len - done));
+
+        memcpy(buf + done, chunk.data() + queuePos, copyLen);
+        done += copyLen;
+        queuePos += copyLen;
+        if (queuePos == chunk.size())
+        {
+            queue.pop_front();
+            queuePos = 0;
+            cv.notify_all();
+        }
+    }
+
+    if (isError && done < len)
+    {
+        qCritical() << errorString;
+        return -1;
+    }
+
+    return done;
+}
@@ -0,0 +1,78 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef IMAGE_SOURCE_H
+#define IMAGE_SOURCE_H
+
+#include <QFile>
+#include <QObject>
+#include <QString>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ImageDecoder;
+
+/* Compressed write image, decompressed by producer thread into a bounded
+ * queue. Format is detected by magic: gzip, xz and zstd if built with it.
+ * If size is not stored in the image, producer counts it by a decode pass
+ * without output first and emits sizeReady.
+ */
+class ImageSource : public QObject
+{
+    Q_OBJECT
+
+    typedef std::function<int(const uint8_t *buf, size_t len)> SinkFunc;
+
+    const size_t inChunkSize = 1 << 20;
+    const size_t outChunkSize = 1 << 20;
+    const size_t queueMax = 16;
+
+    QFile file;
+    int format;
+    std::unique_ptr<ImageDecoder> decoder;
+    quint64 imageSize;
+    bool isSizeValid;
+    QString errorString;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::vector<uint8_t>> queue;
+    size_t queuePos;
+    bool isStopped;
+    bool isDone;
+    bool isError;
+
+    int decodeStream(const SinkFunc &sink);
+    int sizeFromHeader();
+    int sizeFromXzIndex();
+    int sizeFromZstdFrames();
+    int countSize();
+    int push(const uint8_t *buf, size_t len);
+    void producer();
+
+public:
+    explicit ImageSource(QObject *parent = nullptr);
+    ~ImageSource();
+    static bool isCompressed(const QString &fileName);
+    int open(const QString &fileName);
+    void close();
+    bool isOpen();
+    bool isSizeKnown();
+    /* Size of decompressed image, valid once isSizeKnown */
+    quint64 size();
+    qint64 read(uint8_t *buf, qint64 len);
+
+signals:
+    void sizeReady(bool isOk);
+};
+
+#endif // IMAGE_SOURCE_H
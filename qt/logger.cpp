@@ -6,6 +6,7 @@
 #include "logger.h"
 #include <QDebug>
 #include <QScrollBar>
+#include <QThread>
 #include <QObject>
 
 Q_DECLARE_METATYPE(QTextCursor)
@@ -50,14 +51,26 @@ void Logger::logHandler(QtMsgType type, const QMessageLogContext &context ,
         if (type == QtFatalMsg)
             abort();
     }
-    else
+    else if (QThread::currentThread() != logTextEdit->thread())
     {
-        logTextEdit->moveCursor(QTextCursor::End);
-        logTextEdit->insertPlainText(formatMsg);
-
-        logTextEdit->verticalScrollBar()->
-            setValue(logTextEdit->verticalScrollBar()->maximum());
+        /* Messages of worker threads are printed by GUI thread */
+        QMetaObject::invokeMethod(logger, "slotPrint", Qt::QueuedConnection,
+            Q_ARG(QString, formatMsg));
     }
+    else
+        print(formatMsg);
+}
+
+void Logger::print(const QString &msg)
+{
+    if (!logTextEdit)
+        return;
+
+    logTextEdit->moveCursor(QTextCursor::End);
+    logTextEdit->insertPlainText(msg);
+
+    logTextEdit->verticalScrollBar()->
+        setValue(logTextEdit->verticalScrollBar()->maximum());
 }
 
 Logger::Logger()
@@ -127,3 +140,8 @@ void Logger::slotLog(QString msg)
     qCritical() << msg;
 }
 
+void Logger::slotPrint(QString msg)
+{
+    print(msg);
+}
+
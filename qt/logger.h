@@ -26,6 +26,7 @@ private:
 
     static void logHandler(QtMsgType type, const QMessageLogContext &context,
         const QString &msg);
+    static void print(const QString &msg);
 
 protected:
     virtual std::basic_streambuf<char>::int_type overflow(int_type v) override;
@@ -33,6 +34,7 @@ protected:
 
 private slots:
     void slotLog(QString msg);
+    void slotPrint(QString msg);
 
 public:
     static Logger *getInstance();
@@ -13,9 +13,13 @@
 #include "spi_chip_db.h"
 #include "logger.h"
 #include "about_dialog.h"
+#include "search_dialog.h"
+#include "diff_dialog.h"
 #include "settings.h"
+#include "image_device.h"
 #include <QDebug>
 #include <QFileDialog>
+#include <QInputDialog>
 #include <QFile>
 #include <QSettings>
 #include <QStringList>
@@ -53,6 +57,10 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent),
     Logger *logger = Logger::getInstance();
 
     ui->setupUi(this);
+    searchDialog = nullptr;
+    diffDialog = nullptr;
+    isUbiWrite = false;
+    isPlaneWrite = false;
 
     logger->setTextEdit(ui->logTextEdit);
 
@@ -81,12 +89,24 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent),
         SLOT(slotProgErase()));
     connect(ui->actionRead, SIGNAL(triggered()), this,
         SLOT(slotProgRead()));
+    connect(ui->actionReadSpare, SIGNAL(triggered()), this,
+        SLOT(slotProgReadSpare()));
+    connect(ui->actionReadVote, SIGNAL(triggered()), this,
+        SLOT(slotProgReadVote()));
+    connect(ui->actionReadRegions, SIGNAL(triggered()), this,
+        SLOT(slotProgReadRegions()));
+    connect(ui->actionWriteRegions, SIGNAL(triggered()), this,
+        SLOT(slotProgWriteRegions()));
     connect(ui->actionVerify, SIGNAL(triggered()), this,
             SLOT(slotProgVerify()));
     connect(ui->actionWrite, SIGNAL(triggered()), this,
         SLOT(slotProgWrite()));
+    connect(ui->actionWriteUbi, SIGNAL(triggered()), this,
+        SLOT(slotProgWriteUbi()));
     connect(ui->actionReadBadBlocks, SIGNAL(triggered()), this,
         SLOT(slotProgReadBadBlocks()));
+    connect(ui->actionCorrectEcc, SIGNAL(triggered()), this,
+        SLOT(slotCorrectEcc()));
     connect(ui->actionProgrammer, SIGNAL(triggered()), this,
         SLOT(slotSettingsProgrammer()));
     connect(ui->actionParallelChipDb, SIGNAL(triggered()), this,
@@ -103,6 +123,30 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent),
         SLOT(slotSelectFilePath()));
     connect(ui->filePathLineEdit, SIGNAL(editingFinished()), this,
         SLOT(slotFilePathEditingFinished()));
+    connect(ui->actionSearch, SIGNAL(triggered()), this,
+        SLOT(slotSearchDialog()));
+    connect(ui->actionCompare, SIGNAL(triggered()), this,
+        SLOT(slotDiffDialog()));
+    connect(ui->actionBrowseChip, SIGNAL(triggered(bool)), this,
+        SLOT(slotBrowseChip(bool)));
+    connect(&chipCache, SIGNAL(stopped()), this,
+        SLOT(slotChipCacheStopped()));
+    connect(&eccCorrector, SIGNAL(progress(quint64, quint64)), this,
+        SLOT(slotCorrectEccProgress(quint64, quint64)));
+    connect(&eccCorrector, SIGNAL(finished(bool)), this,
+        SLOT(slotCorrectEccFinished(bool)));
+    connect(&imageSource, SIGNAL(sizeReady(bool)), this,
+        SLOT(slotImageSizeReady(bool)));
+    connect(&majorityVote, SIGNAL(progress(quint64, quint64)), this,
+        SLOT(slotVoteProgress(quint64, quint64)));
+    connect(&majorityVote, SIGNAL(finished(bool)), this,
+        SLOT(slotVoteFinished(bool)));
+    connect(ui->actionLoadPartitions, SIGNAL(triggered()), this,
+        SLOT(slotLoadPartitions()));
+    connect(ui->menuPartitions, SIGNAL(triggered(QAction *)), this,
+        SLOT(slotSelectPartition(QAction *)));
+    connect(ui->actionTrimRange, SIGNAL(triggered()), this,
+        SLOT(slotProgTrimRange()));
 
     ui->filePathLineEdit->setText(QDir::tempPath() + "/nando_tmp.bin");
     QSettings settings(SETTINGS_ORGANIZATION_NAME, SETTINGS_APPLICATION_NAME);
@@ -131,9 +175,18 @@ void MainWindow::setUiStateSelected(bool isSelected)
     ui->actionReadId->setEnabled(isSelected);
     ui->actionErase->setEnabled(isSelected);
     ui->actionRead->setEnabled(isSelected);
+    ui->actionReadSpare->setEnabled(isSelected);
+    ui->actionReadVote->setEnabled(isSelected);
+    ui->actionReadRegions->setEnabled(isSelected);
+    ui->actionWriteRegions->setEnabled(isSelected);
     ui->actionWrite->setEnabled(isSelected);
+    ui->actionWriteUbi->setEnabled(isSelected);
     ui->actionVerify->setEnabled(isSelected);
     ui->actionReadBadBlocks->setEnabled(isSelected);
+    ui->actionCorrectEcc->setEnabled(isSelected);
+    ui->actionBrowseChip->setEnabled(isSelected);
+    ui->actionLoadPartitions->setEnabled(isSelected);
+    ui->actionTrimRange->setEnabled(isSelected);
 
     ui->firstSpinBox->setEnabled(isSelected);
     ui->lastSpinBox->setEnabled(isSelected);
@@ -149,7 +202,11 @@ void MainWindow::setUiStateSelected(bool isSelected)
             currentChipDb->extendedTotalSizeGetByName(chipName) :
             currentChipDb->totalSizeGetByName(chipName);
         ui->blockSizeValueLabel->setText(QString("0x%1").arg(chipSize / blocksCount, 8, 16, QLatin1Char( '0' )));
+        partitionsLoad();
     }
+    else
+        partitionTable.clear();
+    updatePartitionMenu();
 }
 
 void MainWindow::slotProgConnectCompleted(quint64 status)
@@ -283,6 +340,11 @@ void MainWindow::slotProgReadCompleted(quint64 readBytes)
         SLOT(slotProgReadProgress(quint64)));
     disconnect(prog, SIGNAL(readChipCompleted(quint64)), this,
         SLOT(slotProgReadCompleted(quint64)));
+    disconnect(prog, SIGNAL(readChipEcc(quint64, quint32)), this,
+        SLOT(slotProgReadEcc(quint64, quint32)));
+    disconnect(prog, SIGNAL(readChipBadBlock(quint64, bool)), this,
+        SLOT(slotProgReadBadBlock(quint64, bool)));
+    eccFile.close();
 
     ui->filePathLineEdit->setDisabled(false);
     ui->selectFilePushButton->setDisabled(false);
@@ -291,24 +353,36 @@ void MainWindow::slotProgReadCompleted(quint64 readBytes)
 
     if (readBytes == UINT64_MAX)
     {
-        workFile.close();
+        readSink->close();
+        readSink.reset();
+        eccDecoderClose();
         return;
     }
 
     buffer.mutex.lock();
-    workFile.write((const char *)buffer.buf.data(), buffer.buf.size());
+    readSink->write(buffer.buf.data(), buffer.buf.size());
+    if (eccDecoder.isOpen())
+        eccDecoder.write(buffer.buf.data(), buffer.buf.size());
     buffer.buf.clear();
     buffer.mutex.unlock();
+    eccDecoderClose();
 
-    if (readBytes != (quint64)workFile.size())
+    quint64 sinkSize = readSink->size();
+    int ret = readSink->close();
+    readSink.reset();
+
+    if (readBytes != sinkSize)
     {
         qCritical() << "Read operation returned more or less than requested: " <<
-            readBytes << "!=" << workFile.size();
-        workFile.resize(0);
+            readBytes << "!=" << sinkSize;
+        QFile::resize(ui->filePathLineEdit->text(), 0);
+    }
+    else if (!ret)
+    {
+        qInfo() << "Data has been successfully read";
+        bbMapSave(ui->filePathLineEdit->text());
     }
 
-    workFile.close();
-    qInfo() << "Data has been successfully read";
     ui->dataViewer->setFile(ui->filePathLineEdit->text());
 }
 
@@ -320,11 +394,84 @@ void MainWindow::slotProgReadProgress(quint64 progress)
     setProgress(progressPercent);
 
     buffer.mutex.lock();
-    workFile.write((const char *)buffer.buf.data(), buffer.buf.size());
+    readSink->write(buffer.buf.data(), buffer.buf.size());
+    if (eccDecoder.isOpen())
+        eccDecoder.write(buffer.buf.data(), buffer.buf.size());
     buffer.buf.clear();
     buffer.mutex.unlock();
 }
 
+void MainWindow::slotProgReadBadBlock(quint64 addr, bool isSkipped)
+{
+    readSink->badBlock(addr, isSkipped);
+    slotProgBbMapBadBlock(addr, isSkipped);
+}
+
+void MainWindow::bbMapInit(quint64 startAddr, quint64 len,
+    quint64 fileBlockSize)
+{
+    quint64 blockSize =
+        ui->blockSizeValueLabel->text().toULongLong(nullptr, 16);
+
+    if (!blockSize)
+        return;
+
+    bbMap.init(fileBlockSize, startAddr / blockSize,
+        (len + blockSize - 1) / blockSize);
+}
+
+/* Logical block of data file is found without rescanning the chip */
+void MainWindow::bbMapSave(const QString &fileName)
+{
+    QString mapFileName = BbMap::mapFileName(fileName);
+
+    if (bbMap.save(mapFileName))
+        return;
+
+    if (!bbMap.getSkipped().empty())
+    {
+        qInfo() << bbMap.getSkipped().size() <<
+            "skipped bad blocks are saved to" << mapFileName;
+    }
+}
+
+void MainWindow::slotProgBbMapBadBlock(quint64 addr, bool isSkipped)
+{
+    quint64 blockSize =
+        ui->blockSizeValueLabel->text().toULongLong(nullptr, 16);
+
+    if (isSkipped && blockSize)
+        bbMap.addSkipped(addr / blockSize);
+}
+
+void MainWindow::getDumpInfo(DumpInfo &info, quint64 startAddr)
+{
+    QString chipName = ui->chipSelectComboBox->currentText();
+    ChipInfo *chipInfo = currentChipDb->chipInfoGetByName(chipName);
+
+    info = {};
+    info.chipName = chipName;
+    info.chipId = chipId;
+    info.incSpare = prog->isIncSpare();
+    info.blockSize = ui->blockSizeValueLabel->text().toULongLong(nullptr, 16);
+    if (info.blockSize)
+        info.startBlock = startAddr / info.blockSize;
+    if (!chipInfo)
+        return;
+
+    info.pageSize = chipInfo->getPageSize();
+    if (info.incSpare)
+        info.pageSize += chipInfo->getSpareSize();
+    info.spareSize = chipInfo->getSpareSize();
+    info.totalSize = chipInfo->getTotalSize();
+}
+
+void MainWindow::slotProgReadEcc(quint64 addr, quint32 ecc)
+{
+    eccFile.write(QString("0x%1 0x%2\n").arg(addr, 8, 16, QLatin1Char('0'))
+        .arg(ecc, 8, 16, QLatin1Char('0')).toLatin1());
+}
+
 void MainWindow::slotProgRead()
 {
     quint64 start_address =
@@ -340,8 +487,8 @@ void MainWindow::slotProgRead()
         return;
     }
 
-    workFile.setFileName(ui->filePathLineEdit->text());
-    if (workFile.exists())
+    QString fileName = ui->filePathLineEdit->text();
+    if (QFile::exists(fileName))
     {
         QMessageBox msgBox;
         msgBox.setIcon(QMessageBox::Warning);
@@ -350,23 +497,71 @@ void MainWindow::slotProgRead()
         msgBox.setStandardButtons(QMessageBox::Ok | QMessageBox::Cancel);
         msgBox.setDefaultButton(QMessageBox::Cancel);
         if (msgBox.exec() == QMessageBox::Cancel)
-        {
-            workFile.close();
             return;
-        }
     }
 
-    if (!workFile.open(QIODevice::WriteOnly))
+    /* Viewer and search must not hold the file while it is rewritten */
+    ui->dataViewer->closeFile();
+    if (searchDialog)
+        searchDialog->stop();
+    if (diffDialog)
+        diffDialog->stop();
+
+    /* Dump container or raw file is chosen by file name */
+    DumpInfo dumpInfo;
+    getDumpInfo(dumpInfo, start_address);
+    readSink.reset(ReadSink::create(fileName, prog->isSparseFile()));
+    if (readSink && prog->isIncSpare() &&
+        prog->getSpareMode() != Programmer::SPARE_MODE_KEEP)
+    {
+        readSink.reset(new DeinterleaveSink(readSink.release(),
+            prog->getSpareMode() == Programmer::SPARE_MODE_SPLIT));
+    }
+    if (!readSink || readSink->open(fileName, dumpInfo))
     {
-        qCritical() << "Failed to open file:" << ui->filePathLineEdit->text()
-            << ", error:" << workFile.errorString();
+        readSink.reset();
         return;
     }
 
-    workFile.resize(0);
     resetBufTable();
     buffer.buf.clear();
 
+    /* ECC calculated by programmer is saved next to the data file */
+    if (prog->isChipFsmcEcc())
+    {
+        eccFile.setFileName(fileName + ".ecc");
+        if (!eccFile.open(QIODevice::WriteOnly | QIODevice::Truncate |
+            QIODevice::Text))
+        {
+            qCritical() << "Failed to open file:" << eccFile.fileName()
+                << ", error:" << eccFile.errorString();
+            readSink->close();
+            readSink.reset();
+            return;
+        }
+        connect(prog, SIGNAL(readChipEcc(quint64, quint32)), this,
+            SLOT(slotProgReadEcc(quint64, quint32)));
+    }
+
+    /* Raw pages are corrected by software ECC while they are read */
+    eccEngine.uninit();
+    if (prog->isIncSpare() && prog->isSwEcc())
+    {
+        QString chipName = ui->chipSelectComboBox->currentText();
+
+        if (eccEngineInit(chipName) || eccDecoder.open(&eccEngine,
+            fileName, start_address / eccEngine.getRawPageSize()))
+        {
+            disconnect(prog, SIGNAL(readChipEcc(quint64, quint32)), this,
+                SLOT(slotProgReadEcc(quint64, quint32)));
+            eccEngine.uninit();
+            eccFile.close();
+            readSink->close();
+            readSink.reset();
+            return;
+        }
+    }
+
     qInfo() << "Reading data ...";
     setProgress(0);
 
@@ -374,68 +569,558 @@ void MainWindow::slotProgRead()
         SLOT(slotProgReadCompleted(quint64)));
     connect(prog, SIGNAL(readChipProgress(quint64)), this,
         SLOT(slotProgReadProgress(quint64)));
+    connect(prog, SIGNAL(readChipBadBlock(quint64, bool)), this,
+        SLOT(slotProgReadBadBlock(quint64, bool)));
 
     ui->filePathLineEdit->setDisabled(true);
     ui->selectFilePushButton->setDisabled(true);
 
+    /* Deinterleaved file has data blocks without spare area */
+    bbMapInit(start_address, areaSize, prog->isIncSpare() &&
+        prog->getSpareMode() != Programmer::SPARE_MODE_KEEP ?
+        dataBlockSize() :
+        ui->blockSizeValueLabel->text().toULongLong(nullptr, 16));
+
     prog->readChip(&buffer, start_address, areaSize, true);
 }
 
-void MainWindow::slotProgVerifyCompleted(quint64 readBytes)
+void MainWindow::slotProgReadSinkCompleted(quint64 readBytes)
 {
     disconnect(prog, SIGNAL(readChipProgress(quint64)), this,
-               SLOT(slotProgVerifyProgress(quint64)));
+        SLOT(slotProgReadProgress(quint64)));
     disconnect(prog, SIGNAL(readChipCompleted(quint64)), this,
-               SLOT(slotProgVerifyCompleted(quint64)));
+        SLOT(slotProgReadSinkCompleted(quint64)));
 
     ui->filePathLineEdit->setDisabled(false);
     ui->selectFilePushButton->setDisabled(false);
 
     setProgress(100);
-    workFile.close();
+
+    if (readBytes == UINT64_MAX)
+    {
+        readSink->close();
+        readSink.reset();
+        return;
+    }
+
+    buffer.mutex.lock();
+    readSink->write(buffer.buf.data(), buffer.buf.size());
     buffer.buf.clear();
+    buffer.mutex.unlock();
 
-    qInfo() << readBytes << " bytes read. Verify end."  ;
+    quint64 sinkSize = readSink->size();
+    int ret = readSink->close();
+    readSink.reset();
+
+    if (readBytes != sinkSize)
+    {
+        qCritical() << "Read operation returned more or less than requested: " <<
+            readBytes << "!=" << sinkSize;
+    }
+    else if (!ret)
+        qInfo() << "Data has been successfully read";
+
+    ui->dataViewer->setFile(ui->filePathLineEdit->text());
 }
 
-void MainWindow::slotProgVerifyProgress(quint64 progress)
+/* Only spare area of each page is transferred, it is saved next to the data
+ * file.
+ */
+void MainWindow::slotProgReadSpare()
 {
-    uint32_t progressPercent;
+    QString chipName = ui->chipSelectComboBox->currentText();
+    ChipInfo *chipInfo = currentChipDb->chipInfoGetByName(chipName);
 
-    progressPercent = progress * 100ULL / areaSize;
-    setProgress(progressPercent);
+    if (!chipInfo || !chipInfo->getSpareSize())
+    {
+        qCritical() << "Chip has no spare area";
+        return;
+    }
+
+    quint64 blockSize = chipInfo->getBlockSize();
+    quint64 start_address = blockSize * ui->firstSpinBox->value();
+    quint64 dataSize = blockSize * (ui->lastSpinBox->value() + 1) -
+        start_address;
+    areaSize = dataSize / chipInfo->getPageSize() * chipInfo->getSpareSize();
+
+    if (!areaSize)
+    {
+        qCritical() << "Chip size is not set";
+        return;
+    }
+
+    QString fileName = ui->filePathLineEdit->text() + ".oob";
+    DumpInfo dumpInfo;
+    getDumpInfo(dumpInfo, start_address);
+    readSink.reset(new RawFileSink());
+    if (readSink->open(fileName, dumpInfo))
+    {
+        readSink.reset();
+        return;
+    }
+
+    buffer.buf.clear();
+
+    qInfo() << "Reading spare area to" << fileName << "...";
+    setProgress(0);
+
+    connect(prog, SIGNAL(readChipCompleted(quint64)), this,
+        SLOT(slotProgReadSinkCompleted(quint64)));
+    connect(prog, SIGNAL(readChipProgress(quint64)), this,
+        SLOT(slotProgReadProgress(quint64)));
+
+    ui->filePathLineEdit->setDisabled(true);
+    ui->selectFilePushButton->setDisabled(true);
+
+    prog->readChipSpare(&buffer, start_address, dataSize, areaSize);
+}
+
+/* Weak cells may return different data on each read, range is read several
+ * times and the most likely value of each bit is saved to the work file.
+ */
+void MainWindow::slotProgReadVote()
+{
+    quint64 blockSize =
+        ui->blockSizeValueLabel->text().toULongLong(nullptr, 16);
+    bool isOk;
+
+    if (majorityVote.isRunning())
+    {
+        qInfo() << "Reads are being combined";
+        return;
+    }
+
+    voteAddr = blockSize * ui->firstSpinBox->value();
+    areaSize = blockSize * (ui->lastSpinBox->value() + 1) - voteAddr;
+
+    if (!areaSize)
+    {
+        qCritical() << "Chip size is not set";
+        return;
+    }
+
+    int passes = QInputDialog::getInt(this, tr("Read with majority vote"),
+        tr("Number of reads:"), 5, MajorityVote::minPasses,
+        MajorityVote::maxPasses, 1, &isOk);
+    if (!isOk)
+        return;
+
+    QString fileName = ui->filePathLineEdit->text();
+    if (QFile::exists(fileName))
+    {
+        QMessageBox msgBox;
+        msgBox.setIcon(QMessageBox::Warning);
+        msgBox.setText("Replace data in current file?");
+        msgBox.setInformativeText("Selected file name is exist.");
+        msgBox.setStandardButtons(QMessageBox::Ok | QMessageBox::Cancel);
+        msgBox.setDefaultButton(QMessageBox::Cancel);
+        if (msgBox.exec() == QMessageBox::Cancel)
+            return;
+    }
+
+    if (majorityVote.init(fileName, passes))
+        return;
+
+    ui->dataViewer->closeFile();
+    if (searchDialog)
+        searchDialog->stop();
+    if (diffDialog)
+        diffDialog->stop();
+
+    ui->filePathLineEdit->setDisabled(true);
+    ui->selectFilePushButton->setDisabled(true);
+
+    bbMapInit(voteAddr, areaSize, blockSize);
+    votePass = 0;
+    votePassStart();
+}
+
+void MainWindow::votePassStart()
+{
+    QString fileName = majorityVote.passFileName(votePass);
+    DumpInfo dumpInfo;
+
+    getDumpInfo(dumpInfo, voteAddr);
+    readSink.reset(new RawFileSink());
+    if (readSink->open(fileName, dumpInfo))
+    {
+        readSink.reset();
+        slotProgReadVoteCompleted(UINT64_MAX);
+        return;
+    }
+
+    buffer.buf.clear();
+
+    qInfo() << "Reading pass" << votePass + 1 << "of" <<
+        majorityVote.getPasses() << "...";
+    setProgress(0);
+
+    connect(prog, SIGNAL(readChipCompleted(quint64)), this,
+        SLOT(slotProgReadVoteCompleted(quint64)));
+    connect(prog, SIGNAL(readChipProgress(quint64)), this,
+        SLOT(slotProgReadProgress(quint64)));
+    connect(prog, SIGNAL(readChipBadBlock(quint64, bool)), this,
+        SLOT(slotProgBbMapBadBlock(quint64, bool)));
+
+    prog->readChip(&buffer, voteAddr, areaSize, true);
+}
+
+void MainWindow::slotProgReadVoteCompleted(quint64 readBytes)
+{
+    disconnect(prog, SIGNAL(readChipProgress(quint64)), this,
+        SLOT(slotProgReadProgress(quint64)));
+    disconnect(prog, SIGNAL(readChipCompleted(quint64)), this,
+        SLOT(slotProgReadVoteCompleted(quint64)));
+    disconnect(prog, SIGNAL(readChipBadBlock(quint64, bool)), this,
+        SLOT(slotProgBbMapBadBlock(quint64, bool)));
+
+    setProgress(100);
+
+    if (readSink)
+    {
+        quint64 sinkSize;
+
+        buffer.mutex.lock();
+        readSink->write(buffer.buf.data(), buffer.buf.size());
+        buffer.buf.clear();
+        buffer.mutex.unlock();
+
+        sinkSize = readSink->size();
+        if (readSink->close())
+            readBytes = UINT64_MAX;
+        else if (readBytes != UINT64_MAX && readBytes != sinkSize)
+        {
+            qCritical() << "Read operation returned more or less than "
+                "requested: " << readBytes << "!=" << sinkSize;
+            readBytes = UINT64_MAX;
+        }
+        readSink.reset();
+    }
+
+    if (readBytes != UINT64_MAX && ++votePass < majorityVote.getPasses())
+    {
+        QTimer::singleShot(50, this, &MainWindow::votePassStart);
+        return;
+    }
+
+    if (readBytes == UINT64_MAX)
+    {
+        majorityVote.removePasses();
+        voteFinish();
+        return;
+    }
+
+    qInfo() << "Combining reads ...";
+    setProgress(0);
+    majorityVote.start(ui->blockSizeValueLabel->text().toULongLong(nullptr,
+        16));
+}
+
+void MainWindow::slotVoteProgress(quint64 done, quint64 total)
+{
+    setProgress(total ? done * 100ULL / total : 100);
+}
+
+/* Reads are kept if they failed to combine, so they can be looked at */
+void MainWindow::slotVoteFinished(bool isCompleted)
+{
+    majorityVote.stop();
+    setProgress(100);
+
+    if (isCompleted)
+    {
+        voteReport();
+        bbMapSave(ui->filePathLineEdit->text());
+        majorityVote.removePasses();
+    }
+    else
+    {
+        qWarning() << "Reads are kept in" << majorityVote.passFileName(0)
+            << "and next pass files";
+    }
+
+    voteFinish();
+}
+
+void MainWindow::voteFinish()
+{
+    ui->filePathLineEdit->setDisabled(false);
+    ui->selectFilePushButton->setDisabled(false);
+    ui->dataViewer->setFile(ui->filePathLineEdit->text());
+}
+
+void MainWindow::voteReport()
+{
+    const std::vector<quint64> &histogram = majorityVote.getHistogram();
+    const QMap<quint64, quint64> &stats = majorityVote.getBlockStats();
+    uint32_t passes = majorityVote.getPasses();
+    QString histStr;
+
+    if (!majorityVote.getUnstableBits())
+    {
+        qInfo() << "Data has been successfully read," << passes <<
+            "reads are the same";
+        return;
+    }
+
+    for (size_t i = 0; i < histogram.size(); i++)
+    {
+        if (histogram[i])
+            histStr += QString(" %1:%2").arg(i).arg(histogram[i]);
+    }
+    qInfo() << "Unstable bits per number of reads as 1 (reads:bits):"
+        << histStr.toLatin1().constData();
+
+    for (auto it = stats.constBegin(); it != stats.constEnd(); ++it)
+    {
+        qWarning() << "Unstable block:" << bbMap.getStartBlock() + it.key()
+            << ", physical block:" << bbMap.physicalBlock(it.key())
+            << ", bits:" << it.value();
+    }
+
+    qWarning() << "Data has been read with" << majorityVote.getUnstableBits()
+        << "unstable bits in" << stats.size() << "blocks, see"
+        << MajorityVote::unstableFileName(ui->filePathLineEdit->text());
+}
+
+int MainWindow::regionsGet(RegionList &regions, quint64 blockSize)
+{
+    QString chipName = ui->chipSelectComboBox->currentText();
+    QSettings settings(SETTINGS_ORGANIZATION_NAME, SETTINGS_APPLICATION_NAME);
+    bool isOk;
+
+    QString text = QInputDialog::getMultiLineText(this, tr("Regions"),
+        tr("First block, block count, optional file and file offset:"),
+        settings.value(SETTINGS_REGIONS).toString(), &isOk);
+    if (!isOk)
+        return -1;
+    settings.setValue(SETTINGS_REGIONS, text);
+
+    return regions.parse(text, ui->filePathLineEdit->text(),
+        currentChipDb->blockCountGetByName(chipName), blockSize);
+}
+
+/* Several partitions are read by one command, each to its own file */
+void MainWindow::slotProgReadRegions()
+{
+    RegionList regions;
+    DumpInfo dumpInfo;
+    quint64 blockSize =
+        ui->blockSizeValueLabel->text().toULongLong(nullptr, 16);
+
+    if (!blockSize)
+    {
+        qCritical() << "Chip size is not set";
+        return;
+    }
+
+    if (regionsGet(regions, blockSize))
+        return;
+    areaSize = regions.dataSize(blockSize);
+
+    /* Work file can be one of region files */
+    ui->dataViewer->closeFile();
+    if (searchDialog)
+        searchDialog->stop();
+    if (diffDialog)
+        diffDialog->stop();
+
+    getDumpInfo(dumpInfo, 0);
+    readSink.reset(new RegionSink(regions, blockSize));
+    if (readSink->open(ui->filePathLineEdit->text(), dumpInfo))
+    {
+        readSink.reset();
+        ui->dataViewer->setFile(ui->filePathLineEdit->text());
+        return;
+    }
+
+    buffer.buf.clear();
+
+    qInfo() << "Reading" << regions.get().size() << "regions ...";
+    setProgress(0);
+
+    connect(prog, SIGNAL(readChipCompleted(quint64)), this,
+        SLOT(slotProgReadSinkCompleted(quint64)));
+    connect(prog, SIGNAL(readChipProgress(quint64)), this,
+        SLOT(slotProgReadProgress(quint64)));
+
+    ui->filePathLineEdit->setDisabled(true);
+    ui->selectFilePushButton->setDisabled(true);
+
+    prog->readChipRegions(&buffer, regions, areaSize);
+}
+
+void MainWindow::eccDecoderClose()
+{
+    if (!eccDecoder.isOpen())
+        return;
+
+    if (!eccDecoder.close())
+    {
+        qInfo() << "ECC corrected bits:" << eccDecoder.getCorrectedBits()
+            << ", uncorrectable pages:" << eccDecoder.getFailedPages();
+    }
+    eccEngine.uninit();
+}
+
+/* Dump is decoded on a worker thread, GUI is updated by its signals */
+void MainWindow::slotCorrectEcc()
+{
+    QString chipName = ui->chipSelectComboBox->currentText();
+    ChipInfo *info = currentChipDb->chipInfoGetByName(chipName);
+    EccLayout layout;
+
+    if (ui->chipSelectComboBox->currentIndex() <= CHIP_INDEX_DEFAULT)
+    {
+        qInfo() << "Chip is not selected";
+        return;
+    }
+
+    if (eccCorrector.isRunning())
+    {
+        qInfo() << "ECC correction is in progress";
+        return;
+    }
+
+    if (eccLayoutGet(chipName, layout) ||
+        eccCorrector.start(ui->filePathLineEdit->text(), layout,
+        info->getPageSize(), info->getSpareSize()))
+    {
+        return;
+    }
+
+    qInfo() << "Correcting ECC ...";
+    setProgress(0);
+
+    ui->actionCorrectEcc->setEnabled(false);
+    ui->filePathLineEdit->setDisabled(true);
+    ui->selectFilePushButton->setDisabled(true);
+}
+
+void MainWindow::slotCorrectEccProgress(quint64 done, quint64 total)
+{
+    setProgress(done * 100ULL / total);
+}
+
+void MainWindow::slotCorrectEccFinished(bool isCompleted)
+{
+    eccCorrector.stop();
+
+    if (isCompleted)
+    {
+        qInfo() << "ECC corrected bits:" << eccCorrector.getCorrectedBits()
+            << ", uncorrectable pages:" << eccCorrector.getFailedPages();
+    }
+
+    setProgress(100);
+    ui->actionCorrectEcc->setEnabled(true);
+    ui->filePathLineEdit->setDisabled(false);
+    ui->selectFilePushButton->setDisabled(false);
+}
+
+void MainWindow::slotProgVerifyCompleted(quint64 readBytes)
+{
+    disconnect(prog, SIGNAL(readChipProgress(quint64)), this,
+               SLOT(slotProgVerifyProgress(quint64)));
+    disconnect(prog, SIGNAL(readChipCompleted(quint64)), this,
+               SLOT(slotProgVerifyCompleted(quint64)));
+    disconnect(prog, SIGNAL(readChipBadBlock(quint64, bool)), this,
+        SLOT(slotProgBbMapBadBlock(quint64, bool)));
+
+    ui->filePathLineEdit->setDisabled(false);
+    ui->selectFilePushButton->setDisabled(false);
 
-    QVector<uint8_t> cmpBuffer;
     buffer.mutex.lock();
-    cmpBuffer.resize(buffer.buf.size());
+    verifier.push(buffer.buf);
+    buffer.buf.clear();
+    buffer.mutex.unlock();
+    verifier.finish();
 
-    qint64 readSize = workFile.read((char *)cmpBuffer.data(), buffer.buf.size());
+    setProgress(100);
 
-    if (readSize < 0)
+    if (readBytes == UINT64_MAX)
+        return;
+
+    qInfo() << readBytes << " bytes read. Verify end."  ;
+    verifyReport();
+}
+
+void MainWindow::verifyReport()
+{
+    const QMap<quint64, Verifier::BlockStat> &stats =
+        verifier.getBlockStats();
+    BbMap fileMap;
+
+    /* Data written to chip with other bad blocks is shifted */
+    if (!fileMap.load(BbMap::mapFileName(ui->filePathLineEdit->text())) &&
+        !bbMap.isSameLayout(fileMap))
     {
-        qCritical() << "Failed to read file";
+        qWarning() << "Blocks are placed differently than in bad block map"
+            << BbMap::mapFileName(ui->filePathLineEdit->text());
     }
-    else if (readSize == 0)
+
+    if (verifier.isTolerant())
+    {
+        const std::vector<quint64> &histogram = verifier.getHistogram();
+        QString histStr;
+
+        for (size_t i = 0; i < histogram.size(); i++)
+        {
+            if (histogram[i])
+                histStr += QString(" %1:%2").arg(i).arg(histogram[i]);
+        }
+        qInfo() << "Bitflips per ECC step (bits:steps):"
+            << histStr.toLatin1().constData();
+    }
+
+    if (verifier.isPassed())
     {
-        qCritical() << "File read 0 byte";
+        qInfo() << "Data has been successfully verified";
+        return;
     }
 
-    for(uint32_t i = 0; i < readSize; i++)
+    if (verifier.isTolerant())
     {
-        if(cmpBuffer.at(i) != buffer.buf.at(i))
+        for (auto it = stats.constBegin(); it != stats.constEnd(); ++it)
         {
-            uint64_t block = progress / ui->blockSizeValueLabel->text().toULongLong(nullptr, 16)
-                             + ui->firstSpinBox->text().toULongLong(nullptr, 10) - 1;
-            uint64_t byte = progress - ui->blockSizeValueLabel->text().toULongLong(nullptr, 16)
-                            + ui->firstSpinBox->text().toULongLong(nullptr, 10)
-                            * ui->blockSizeValueLabel->text().toULongLong(nullptr, 16) + i;
-            qCritical() << "Wrong block: " << QString("%1").arg(block)
-                << ", Wrong byte addr: "
-                << QString("0x%1").arg(byte, 8, 16, QLatin1Char( '0' ));
-            break;
+            if (!it.value().failedSteps)
+                continue;
+
+            qCritical() << "Wrong block:" << it.key() << ", physical block:"
+                << bbMap.physicalBlock(it.key() - bbMap.getStartBlock())
+                << ", failed steps:" << it.value().failedSteps << ", bits:"
+                << it.value().bits;
         }
+
+        qCritical() << "Verify failed," << verifier.getFailedSteps()
+            << "ECC steps exceed ECC strength, see"
+            << verifier.getReportFileName();
+        return;
+    }
+
+    for (auto it = stats.constBegin(); it != stats.constEnd(); ++it)
+    {
+        qCritical() << "Wrong block:" << it.key() << ", physical block:"
+            << bbMap.physicalBlock(it.key() - bbMap.getStartBlock())
+            << ", bytes:" << it.value().bytes << ", bits:"
+            << it.value().bits;
     }
 
+    qCritical() << "Verify failed," << verifier.getMismatchBytes()
+        << "bytes (" << verifier.getMismatchBits() << "bits ) differ in"
+        << stats.size() << "blocks, see" << verifier.getReportFileName();
+}
+
+void MainWindow::slotProgVerifyProgress(quint64 progress)
+{
+    uint32_t progressPercent;
+
+    progressPercent = progress * 100ULL / areaSize;
+    setProgress(progressPercent);
+
+    /* Data is compared with file by verifier thread */
+    buffer.mutex.lock();
+    verifier.push(buffer.buf);
     buffer.buf.clear();
     buffer.mutex.unlock();
 }
@@ -458,6 +1143,15 @@ void MainWindow::slotProgVerify()
         return;
     }
 
+    /* Verifier compares file as is, compressed image is not decoded */
+    if (ImageSource::isCompressed(workFile.fileName()))
+    {
+        qCritical() << "Compressed image can't be verified, decompress it "
+            "first";
+        workFile.close();
+        return;
+    }
+
     index = ui->chipSelectComboBox->currentIndex();
     if (index <= CHIP_INDEX_DEFAULT)
     {
@@ -475,55 +1169,296 @@ void MainWindow::slotProgVerify()
         return;
     }
 
-    quint64 start_address =
-        ui->blockSizeValueLabel->text().toULongLong(nullptr, 16)
-        * ui->firstSpinBox->value();
+    quint64 start_address =
+        ui->blockSizeValueLabel->text().toULongLong(nullptr, 16)
+        * ui->firstSpinBox->value();
+
+    areaSize = workFile.size();
+    if (ImageDevice::isContainer(workFile.fileName()))
+    {
+        std::unique_ptr<QIODevice> device(
+            ImageDevice::create(workFile.fileName()));
+
+        if (!device)
+            return;
+        areaSize = device->size();
+    }
+
+    if (areaSize % pageSize)
+    {
+        areaSize = (areaSize / pageSize + 1) * pageSize;
+    }
+
+    quint64 setSize =
+        ui->blockSizeValueLabel->text().toULongLong(nullptr, 16)
+            * (ui->lastSpinBox->value() + 1) - start_address;
+
+    if (setSize < areaSize)
+        areaSize = setSize;
+
+    /* Tolerant verify allows bitflips up to ECC strength per ECC step */
+    EccLayout layout = {};
+    if (prog->isVerifyTolerant())
+    {
+        ChipInfo *info = currentChipDb->chipInfoGetByName(chipName);
+
+        if (!info || info->getEccLayout(layout) || !layout.step)
+        {
+            qCritical() << "ECC layout is not defined for chip" << chipName;
+            return;
+        }
+    }
+
+    workFile.close();
+    if (verifier.start(workFile.fileName(), start_address, pageSize,
+        ui->blockSizeValueLabel->text().toULongLong(nullptr, 16),
+        layout.step, layout.strength))
+    {
+        return;
+    }
+
+    qInfo() << "Reading data ...";
+    setProgress(0);
+
+    connect(prog, SIGNAL(readChipCompleted(quint64)), this,
+            SLOT(slotProgVerifyCompleted(quint64)));
+    connect(prog, SIGNAL(readChipProgress(quint64)), this,
+            SLOT(slotProgVerifyProgress(quint64)));
+    connect(prog, SIGNAL(readChipBadBlock(quint64, bool)), this,
+        SLOT(slotProgBbMapBadBlock(quint64, bool)));
+
+    ui->filePathLineEdit->setDisabled(true);
+    ui->selectFilePushButton->setDisabled(true);
+
+    buffer.buf.clear();
+    bbMapInit(start_address, areaSize,
+        ui->blockSizeValueLabel->text().toULongLong(nullptr, 16));
+
+    prog->readChip(&buffer, start_address, areaSize, true);
+}
+
+void MainWindow::slotProgWriteCompleted(int status)
+{
+    disconnect(prog, SIGNAL(writeChipProgress(quint64)), this,
+        SLOT(slotProgWriteProgress(quint64)));
+    disconnect(prog, SIGNAL(writeChipCompleted(int)), this,
+        SLOT(slotProgWriteCompleted(int)));
+    disconnect(prog, SIGNAL(writeChipBadBlock(quint64, bool)), this,
+        SLOT(slotProgBbMapBadBlock(quint64, bool)));
+
+    ui->filePathLineEdit->setDisabled(false);
+    ui->selectFilePushButton->setDisabled(false);
+
+    if (!status)
+        qInfo() << "Data has been successfully written";
+
+    /* Region files are not mapped as a whole */
+    if (!status && !regionFile.isOpen())
+        bbMapSave(ui->filePathLineEdit->text());
+
+    if (isUbiWrite)
+    {
+        qInfo() << "UBI image:" << ubiImage.getDataPages() << "of" <<
+            ubiImage.getPages() << "pages are programmed," <<
+            ubiImage.getFreePebs() << "of" << ubiImage.getPebs() <<
+            "PEBs are free";
+        isUbiWrite = false;
+        ubiBuf.clear();
+    }
+    isPlaneWrite = false;
+    planeBuf.clear();
+
+    setProgress(100);
+    eccEncoder.stop();
+    workFile.close();
+    imageSource.close();
+    regionFile.close();
+    eccEngine.uninit();
+}
+
+int MainWindow::eccLayoutGet(const QString &chipName, EccLayout &layout)
+{
+    ChipInfo *info = currentChipDb->chipInfoGetByName(chipName);
+
+    if (!info || info->getEccLayout(layout))
+    {
+        qCritical() << "ECC layout is not defined for chip" << chipName;
+        return -1;
+    }
+
+    return 0;
+}
+
+int MainWindow::eccEngineInit(const QString &chipName)
+{
+    EccLayout layout;
+    ChipInfo *info = currentChipDb->chipInfoGetByName(chipName);
+
+    if (eccLayoutGet(chipName, layout))
+        return -1;
+
+    if (eccEngine.init(layout, info->getPageSize(), info->getSpareSize()))
+    {
+        qCritical() << "ECC layout of chip" << chipName << "is not supported";
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Compressed image is decompressed on the fly without temporary file */
+int MainWindow::openWriteFile(const QString &fileName)
+{
+    if (ImageSource::isCompressed(fileName))
+        return imageSource.open(fileName);
+
+    workFile.setFileName(fileName);
+    if (!workFile.open(QIODevice::ReadOnly))
+    {
+        qCritical() << "Failed to open file:" << fileName << ", error:" <<
+            workFile.errorString();
+        return -1;
+    }
+
+    return 0;
+}
+
+quint64 MainWindow::writeFileSize()
+{
+    if (imageSource.isOpen())
+        return imageSource.size();
+
+    return workFile.size();
+}
+
+qint64 MainWindow::readWriteFile(uint8_t *buf, qint64 len)
+{
+    if (regionFile.isOpen())
+        return regionFile.read(buf, len);
+
+    if (imageSource.isOpen())
+        return imageSource.read(buf, len);
+
+    return workFile.read(reinterpret_cast<char *>(buf), len);
+}
+
+/* Whole PEB is needed to find out if it is free */
+qint64 MainWindow::readUbiPage(uint8_t *buf)
+{
+    if (ubiBufPos >= ubiDataSize)
+    {
+        qint64 readSize = readWriteFile(ubiBuf.data(), ubiBuf.size());
+        if (readSize <= 0)
+            return readSize;
+
+        if (!ubiImage.getPebs() &&
+            !UbiImage::isUbi(ubiBuf.data(), static_cast<uint32_t>(readSize)))
+        {
+            qCritical() << "File is not UBI image";
+            return -1;
+        }
+
+        std::fill(ubiBuf.begin() + readSize, ubiBuf.end(), 0xFF);
+        ubiDataSize = (readSize + pageSize - 1) / pageSize * pageSize;
+        ubiImage.preparePeb(ubiBuf.data(), ubiDataSize, pageSize);
+        ubiBufPos = 0;
+    }
+
+    std::copy(ubiBuf.begin() + ubiBufPos, ubiBuf.begin() + ubiBufPos + pageSize,
+        buf);
+    ubiBufPos += pageSize;
 
-    areaSize = workFile.size();
+    return pageSize;
+}
 
-    if (areaSize % pageSize)
+/* Same pages of two blocks are passed one after another for multi-plane
+ * program while at least two blocks are left, the rest is passed in order.
+ */
+qint64 MainWindow::readPlanePage(uint8_t *buf)
+{
+    quint64 pairPages = 2 * planeBlockPages, page;
+
+    if (planeOffset >= areaSize)
+        return 0;
+
+    if (planeBufPos == planeBuf.size())
     {
-        areaSize = (areaSize / pageSize + 1) * pageSize;
+        planeBuf.clear();
+        planeBufPos = 0;
+        if (areaSize - planeOffset < pairPages * pageSize)
+        {
+            planeOffset += pageSize;
+            return readFilePage(buf);
+        }
+
+        planeBuf.resize(pairPages * pageSize);
+        for (page = 0; page < pairPages; page++)
+        {
+            uint8_t *pageBuf = planeBuf.data() + page * pageSize;
+            qint64 readSize = readFilePage(pageBuf);
+
+            if (readSize < 0)
+                return -1;
+            std::fill(pageBuf + readSize, pageBuf + pageSize, 0xFF);
+        }
     }
 
-    quint64 setSize =
-        ui->blockSizeValueLabel->text().toULongLong(nullptr, 16)
-            * (ui->lastSpinBox->value() + 1) - start_address;
+    /* Page n of the pair is page n / 2 of its first or second block */
+    page = planeBufPos / pageSize;
+    page = page % 2 * planeBlockPages + page / 2;
+    std::copy(planeBuf.begin() + page * pageSize,
+        planeBuf.begin() + (page + 1) * pageSize, buf);
+    planeBufPos += pageSize;
+    planeOffset += pageSize;
 
-    if (setSize < areaSize)
-        areaSize = setSize;
+    return pageSize;
+}
 
-    qInfo() << "Reading data ...";
-    setProgress(0);
+/* Multi-plane program is used if chip has the command and the first block
+ * of each pair is in the first plane.
+ */
+bool MainWindow::isMultiPlaneWrite(quint64 startBlock)
+{
+    QString chipName = ui->chipSelectComboBox->currentText();
+    ChipInfo *info = currentChipDb->chipInfoGetByName(chipName);
+    quint64 planes, cmd;
 
-    connect(prog, SIGNAL(readChipCompleted(quint64)), this,
-            SLOT(slotProgVerifyCompleted(quint64)));
-    connect(prog, SIGNAL(readChipProgress(quint64)), this,
-            SLOT(slotProgVerifyProgress(quint64)));
+    if (currentChipDb != &parallelChipDb || !info || !info->getPageSize())
+        return false;
 
-    ui->filePathLineEdit->setDisabled(true);
-    ui->selectFilePushButton->setDisabled(true);
+    planes = info->getParam(ParallelChipInfo::CHIP_PARAM_PLANES);
+    cmd = info->getParam(ParallelChipInfo::CHIP_PARAM_WRITE_MP_CMD);
+    if (planes < 2 || planes > UINT8_MAX || cmd > UINT8_MAX || startBlock % 2)
+        return false;
 
-    buffer.buf.clear();
+    planeBlockPages = info->getBlockSize() / info->getPageSize();
+    planeBuf.clear();
+    planeBufPos = 0;
+    planeOffset = 0;
 
-    prog->readChip(&buffer, start_address, areaSize, true);
+    return true;
 }
 
-void MainWindow::slotProgWriteCompleted(int status)
+/* Read next page to write */
+qint64 MainWindow::readWritePage(uint8_t *buf)
 {
-    disconnect(prog, SIGNAL(writeChipProgress(quint64)), this,
-        SLOT(slotProgWriteProgress(quint64)));
-    disconnect(prog, SIGNAL(writeChipCompleted(int)), this,
-        SLOT(slotProgWriteCompleted(int)));
+    if (isPlaneWrite)
+        return readPlanePage(buf);
 
-    ui->filePathLineEdit->setDisabled(false);
-    ui->selectFilePushButton->setDisabled(false);
+    return readFilePage(buf);
+}
 
-    if (!status)
-        qInfo() << "Data has been successfully written";
+/* Read next page of write file */
+qint64 MainWindow::readFilePage(uint8_t *buf)
+{
+    if (isUbiWrite)
+        return readUbiPage(buf);
 
-    setProgress(100);
-    workFile.close();
+    /* With software ECC pages are encoded ahead by encoder thread */
+    if (eccEncoder.isRunning())
+        return eccEncoder.read(buf, pageSize);
+
+    return readWriteFile(buf, pageSize);
 }
 
 void MainWindow::slotProgWriteProgress(quint64 progress)
@@ -535,7 +1470,11 @@ void MainWindow::slotProgWriteProgress(quint64 progress)
 
     std::unique_lock<std::mutex> lck(buffer.mutex);
 
-    qint64 readSize = workFile.read((char *)buffer.buf.data(), pageSize);
+    /* Page following skipped erased pages is not written yet */
+    if (buffer.ready)
+        return;
+
+    qint64 readSize = readWritePage(buffer.buf.data());
     if (readSize < 0)
     {
         qCritical() << "Failed to read file";
@@ -556,23 +1495,23 @@ void MainWindow::slotProgWriteProgress(quint64 progress)
 }
 
 void MainWindow::slotProgWrite()
+{
+    progWrite(false);
+}
+
+/* Pages left erased by UBI image are skipped, so write time depends on the
+ * amount of data in the image instead of its size.
+ */
+void MainWindow::slotProgWriteUbi()
+{
+    progWrite(true);
+}
+
+void MainWindow::progWrite(bool isUbi)
 {
     int index;
     QString chipName;
 
-    workFile.setFileName(ui->filePathLineEdit->text());
-    if (!workFile.open(QIODevice::ReadOnly))
-    {
-        qCritical() << "Failed to open file:" << ui->filePathLineEdit->text() << ", error:" <<
-            workFile.errorString();
-        return;
-    }
-    if (!workFile.size())
-    {
-        qInfo() << "Write file is empty";
-        return;
-    }
-
     index = ui->chipSelectComboBox->currentIndex();
     if (index <= CHIP_INDEX_DEFAULT)
     {
@@ -590,11 +1529,94 @@ void MainWindow::slotProgWrite()
         return;
     }
 
+    /* File contains data only, spare area is built by software ECC */
+    eccEngine.uninit();
+    if (prog->isIncSpare() && prog->isSwEcc() && eccEngineInit(chipName))
+        return;
+
+    if (isUbi)
+    {
+        if (prog->isIncSpare())
+        {
+            qCritical() << "UBI image has no spare area, disable it in "
+                "programmer settings";
+            return;
+        }
+
+        QMessageBox msgBox;
+        msgBox.setIcon(QMessageBox::Question);
+        msgBox.setText(tr("Leave free PEBs erased without erase counter "
+            "header?"));
+        msgBox.setStandardButtons(QMessageBox::Yes | QMessageBox::No |
+            QMessageBox::Cancel);
+        msgBox.setDefaultButton(QMessageBox::No);
+        int ret = msgBox.exec();
+        if (ret == QMessageBox::Cancel)
+            return;
+
+        ubiImage.init(ret == QMessageBox::Yes);
+        ubiBuf.resize(ui->blockSizeValueLabel->text().toULongLong(nullptr,
+            16));
+        ubiBufPos = 0;
+        ubiDataSize = 0;
+    }
+
+    if (openWriteFile(ui->filePathLineEdit->text()))
+        return;
+
+    isUbiWrite = isUbi;
+
+    /* Write is started once size of compressed image is counted */
+    if (imageSource.isOpen() && !imageSource.isSizeKnown())
+    {
+        ui->filePathLineEdit->setDisabled(true);
+        ui->selectFilePushButton->setDisabled(true);
+        return;
+    }
+
+    progWriteStart();
+}
+
+void MainWindow::slotImageSizeReady(bool isOk)
+{
+    if (!imageSource.isOpen())
+        return;
+
+    if (isOk)
+    {
+        progWriteStart();
+        return;
+    }
+
+    ui->filePathLineEdit->setDisabled(false);
+    ui->selectFilePushButton->setDisabled(false);
+    isUbiWrite = false;
+    imageSource.close();
+}
+
+void MainWindow::progWriteStart()
+{
+    if (!writeFileSize())
+    {
+        qInfo() << "Write file is empty";
+        ui->filePathLineEdit->setDisabled(false);
+        ui->selectFilePushButton->setDisabled(false);
+        isUbiWrite = false;
+        workFile.close();
+        imageSource.close();
+        return;
+    }
+
     quint64 start_address =
             ui->blockSizeValueLabel->text().toULongLong(nullptr, 16)
             * ui->firstSpinBox->value();
 
-    areaSize = workFile.size();
+    areaSize = writeFileSize();
+    if (eccEngine.isActive())
+    {
+        areaSize = (areaSize + eccEngine.getPageSize() - 1) /
+            eccEngine.getPageSize() * pageSize;
+    }
 
     if (areaSize % pageSize)
     {
@@ -618,18 +1640,51 @@ void MainWindow::slotProgWrite()
     ui->filePathLineEdit->setDisabled(true);
     ui->selectFilePushButton->setDisabled(true);
 
+    isPlaneWrite = isMultiPlaneWrite(ui->firstSpinBox->value());
+    if (writeBufferInit())
+    {
+        isUbiWrite = false;
+        isPlaneWrite = false;
+        return;
+    }
+
+    /* With software ECC file contains data only */
+    quint64 fileBlockSize =
+        ui->blockSizeValueLabel->text().toULongLong(nullptr, 16);
+    if (eccEngine.isActive())
+        fileBlockSize = fileBlockSize / pageSize * eccEngine.getPageSize();
+    bbMapInit(start_address, areaSize, fileBlockSize);
+    connect(prog, SIGNAL(writeChipBadBlock(quint64, bool)), this,
+        SLOT(slotProgBbMapBadBlock(quint64, bool)));
+
+    prog->writeChip(&buffer, start_address, areaSize, pageSize, isUbiWrite,
+        isPlaneWrite);
+}
+
+/* First page is passed to writer before write is started */
+int MainWindow::writeBufferInit()
+{
+    /* Write file is read only by encoder thread while it is running */
+    if (eccEngine.isActive() && eccEncoder.start(&eccEngine,
+        [this](uint8_t *buf, qint64 len) { return readWriteFile(buf, len); }))
+    {
+        return -1;
+    }
+
     buffer.buf.reserve(pageSize);
     buffer.buf.resize(pageSize);
-    qint64 readSize = workFile.read((char *)buffer.buf.data(), (qint64)pageSize);
+    qint64 readSize = readWritePage(buffer.buf.data());
     if (readSize < 0)
     {
         qCritical() << "Failed to read file";
-        return;
+        eccEncoder.stop();
+        return -1;
     }
     else if (readSize == 0)
     {
         qInfo() << "File is empty";
-        return;
+        eccEncoder.stop();
+        return -1;
     }
     else if (readSize < pageSize)
     {
@@ -637,7 +1692,68 @@ void MainWindow::slotProgWrite()
     }
 
     buffer.ready = true;
-    prog->writeChip(&buffer, start_address, areaSize, pageSize);
+
+    return 0;
+}
+
+/* Several partitions are written by one command, each from its own file.
+ * Region data after the end of its file is written as erased.
+ */
+void MainWindow::slotProgWriteRegions()
+{
+    RegionList regions;
+    QString chipName = ui->chipSelectComboBox->currentText();
+    quint64 blockSize =
+        ui->blockSizeValueLabel->text().toULongLong(nullptr, 16);
+    quint64 fileBlockSize;
+
+    if (ui->chipSelectComboBox->currentIndex() <= CHIP_INDEX_DEFAULT)
+    {
+        qInfo() << "Chip is not selected";
+        return;
+    }
+
+    pageSize = prog->isIncSpare() ?
+        currentChipDb->extendedPageSizeGetByName(chipName) :
+        currentChipDb->pageSizeGetByName(chipName);
+    if (!pageSize || !blockSize)
+    {
+        qInfo() << "Chip page size is unknown";
+        return;
+    }
+
+    eccEngine.uninit();
+    if (prog->isIncSpare() && prog->isSwEcc() && eccEngineInit(chipName))
+        return;
+
+    /* With software ECC files contain data only */
+    fileBlockSize = blockSize;
+    if (eccEngine.isActive())
+        fileBlockSize = blockSize / pageSize * eccEngine.getPageSize();
+
+    if (regionsGet(regions, fileBlockSize) ||
+        regionFile.open(regions, fileBlockSize, false))
+    {
+        eccEngine.uninit();
+        return;
+    }
+    areaSize = regions.dataSize(blockSize);
+
+    qInfo() << "Writing" << regions.get().size() << "regions ...";
+
+    connect(prog, SIGNAL(writeChipCompleted(int)), this,
+        SLOT(slotProgWriteCompleted(int)));
+    connect(prog, SIGNAL(writeChipProgress(quint64)), this,
+        SLOT(slotProgWriteProgress(quint64)));
+
+    ui->filePathLineEdit->setDisabled(true);
+    ui->selectFilePushButton->setDisabled(true);
+
+    isPlaneWrite = false;
+    if (writeBufferInit())
+        return;
+
+    prog->writeChipRegions(&buffer, regions, areaSize, pageSize);
 }
 
 void MainWindow::slotProgReadBadBlocksCompleted(quint64 status)
@@ -844,6 +1960,20 @@ void MainWindow::slotSettingsProgrammer()
         prog->isIncSpare())).toBool());
     progDialog.setHwEccEnabled((settings.value(SETTINGS_ENABLE_HW_ECC,
         prog->isHwEccEnabled())).toBool());
+    progDialog.setEraseOnWrite((settings.value(SETTINGS_ERASE_ON_WRITE,
+        prog->isEraseOnWrite())).toBool());
+    progDialog.setFsmcEcc((settings.value(SETTINGS_FSMC_ECC,
+        prog->isFsmcEcc())).toBool());
+    progDialog.setSwEcc((settings.value(SETTINGS_SW_ECC,
+        prog->isSwEcc())).toBool());
+    progDialog.setVerifyTolerant((settings.value(SETTINGS_VERIFY_TOLERANT,
+        prog->isVerifyTolerant())).toBool());
+    progDialog.setSparseFile((settings.value(SETTINGS_SPARSE_FILE,
+        prog->isSparseFile())).toBool());
+    progDialog.setHolesErased((settings.value(SETTINGS_HOLES_ERASED,
+        prog->isHolesErased())).toBool());
+    progDialog.setSpareMode((settings.value(SETTINGS_SPARE_MODE,
+        prog->getSpareMode())).toInt());
     progDialog.setAlertEnabled((settings.value(SETTINGS_ENABLE_ALERT,
         isAlertEnabled)).toBool());
 
@@ -853,6 +1983,14 @@ void MainWindow::slotSettingsProgrammer()
         settings.setValue(SETTINGS_SKIP_BAD_BLOCKS, progDialog.isSkipBB());
         settings.setValue(SETTINGS_INCLUDE_SPARE_AREA, progDialog.isIncSpare());
         settings.setValue(SETTINGS_ENABLE_HW_ECC, progDialog.isHwEccEnabled());
+        settings.setValue(SETTINGS_ERASE_ON_WRITE, progDialog.isEraseOnWrite());
+        settings.setValue(SETTINGS_FSMC_ECC, progDialog.isFsmcEcc());
+        settings.setValue(SETTINGS_SW_ECC, progDialog.isSwEcc());
+        settings.setValue(SETTINGS_VERIFY_TOLERANT,
+            progDialog.isVerifyTolerant());
+        settings.setValue(SETTINGS_SPARSE_FILE, progDialog.isSparseFile());
+        settings.setValue(SETTINGS_HOLES_ERASED, progDialog.isHolesErased());
+        settings.setValue(SETTINGS_SPARE_MODE, progDialog.getSpareMode());
         settings.setValue(SETTINGS_ENABLE_ALERT, progDialog.isAlertEnabled());
         settings.sync();
 
@@ -875,6 +2013,26 @@ void MainWindow::updateProgSettings()
     }
     if (settings.contains(SETTINGS_ENABLE_HW_ECC))
         prog->setHwEccEnabled(settings.value(SETTINGS_ENABLE_HW_ECC).toBool());
+    if (settings.contains(SETTINGS_ERASE_ON_WRITE))
+        prog->setEraseOnWrite(settings.value(SETTINGS_ERASE_ON_WRITE).toBool());
+    if (settings.contains(SETTINGS_FSMC_ECC))
+        prog->setFsmcEcc(settings.value(SETTINGS_FSMC_ECC).toBool());
+    if (settings.contains(SETTINGS_SW_ECC))
+        prog->setSwEcc(settings.value(SETTINGS_SW_ECC).toBool());
+    if (settings.contains(SETTINGS_VERIFY_TOLERANT))
+    {
+        prog->setVerifyTolerant(settings.value(SETTINGS_VERIFY_TOLERANT)
+            .toBool());
+    }
+    if (settings.contains(SETTINGS_SPARSE_FILE))
+        prog->setSparseFile(settings.value(SETTINGS_SPARSE_FILE).toBool());
+    if (settings.contains(SETTINGS_HOLES_ERASED))
+        prog->setHolesErased(settings.value(SETTINGS_HOLES_ERASED).toBool());
+    if (settings.contains(SETTINGS_SPARE_MODE))
+        prog->setSpareMode(settings.value(SETTINGS_SPARE_MODE).toInt());
+    workFile.setHolesErased(prog->isHolesErased());
+    verifier.setHolesErased(prog->isHolesErased());
+    ui->dataViewer->setHolesErased(prog->isHolesErased());
     if (settings.contains(SETTINGS_ENABLE_ALERT))
         isAlertEnabled = settings.value(SETTINGS_ENABLE_ALERT).toBool();
 
@@ -981,6 +2139,227 @@ void MainWindow::slotProgFirmwareUpdateProgress(quint64 progress)
     setProgress(progress);
 }
 
+void MainWindow::slotSearchDialog()
+{
+    /* Dialog is not modal and is kept to preserve results */
+    if (!searchDialog)
+    {
+        searchDialog = new SearchDialog(this);
+        connect(searchDialog, &SearchDialog::jumpTo, ui->dataViewer,
+            &DataViewer::goTo);
+    }
+
+    searchDialog->setFile(ui->filePathLineEdit->text(),
+        prog->isHolesErased());
+    searchDialog->show();
+    searchDialog->raise();
+    searchDialog->activateWindow();
+}
+
+void MainWindow::slotDiffDialog()
+{
+    if (!diffDialog)
+        diffDialog = new DiffDialog(this);
+
+    /* Differences are found per chip block if chip is selected */
+    diffDialog->setFile(ui->filePathLineEdit->text(),
+        ui->blockSizeValueLabel->text().toULongLong(nullptr, 16),
+        prog->isHolesErased());
+    diffDialog->show();
+    diffDialog->raise();
+    diffDialog->activateWindow();
+}
+
+/* Other chip operations are disabled while viewer reads chip */
+void MainWindow::setUiStateBrowsing(bool isBrowsing)
+{
+    ui->actionConnect->setEnabled(!isBrowsing);
+    ui->actionReadId->setEnabled(!isBrowsing);
+    ui->actionErase->setEnabled(!isBrowsing);
+    ui->actionRead->setEnabled(!isBrowsing);
+    ui->actionReadSpare->setEnabled(!isBrowsing);
+    ui->actionReadVote->setEnabled(!isBrowsing);
+    ui->actionReadRegions->setEnabled(!isBrowsing);
+    ui->actionWriteRegions->setEnabled(!isBrowsing);
+    ui->actionWrite->setEnabled(!isBrowsing);
+    ui->actionWriteUbi->setEnabled(!isBrowsing);
+    ui->actionVerify->setEnabled(!isBrowsing);
+    ui->actionReadBadBlocks->setEnabled(!isBrowsing);
+    ui->actionTrimRange->setEnabled(!isBrowsing);
+    ui->chipSelectComboBox->setEnabled(!isBrowsing);
+    ui->detectPushButton->setEnabled(!isBrowsing);
+    ui->filePathLineEdit->setDisabled(isBrowsing);
+    ui->selectFilePushButton->setDisabled(isBrowsing);
+    ui->actionBrowseChip->setEnabled(true);
+}
+
+void MainWindow::slotBrowseChip(bool isChecked)
+{
+    QString chipName = ui->chipSelectComboBox->currentText();
+    ChipInfo *chipInfo = currentChipDb->chipInfoGetByName(chipName);
+
+    if (!isChecked)
+    {
+        /* UI is restored when pending read is completed */
+        ui->actionBrowseChip->setEnabled(false);
+        chipCache.stop();
+        return;
+    }
+
+    if (!chipInfo)
+    {
+        ui->actionBrowseChip->setChecked(false);
+        return;
+    }
+
+    setUiStateBrowsing(true);
+    chipCache.start(prog, chipInfo->getTotalSize(), chipInfo->getPageSize());
+    ui->dataViewer->setChip(&chipCache);
+    qInfo() << "Browsing chip, pages are read on demand";
+}
+
+void MainWindow::slotChipCacheStopped()
+{
+    setUiStateBrowsing(false);
+    ui->dataViewer->setFile(ui->filePathLineEdit->text());
+}
+
+/* Partition offsets do not include spare area */
+quint64 MainWindow::dataBlockSize()
+{
+    QString chipName = ui->chipSelectComboBox->currentText();
+    quint32 blocksCount = currentChipDb->blockCountGetByName(chipName);
+
+    if (!blocksCount)
+        return 0;
+
+    return currentChipDb->totalSizeGetByName(chipName) / blocksCount;
+}
+
+void MainWindow::partitionsLoad()
+{
+    QString chipName = ui->chipSelectComboBox->currentText();
+    QSettings settings(SETTINGS_ORGANIZATION_NAME, SETTINGS_APPLICATION_NAME);
+    QString text = settings.value(SETTINGS_PARTITIONS + chipName).toString();
+
+    partitionTable.clear();
+    if (text.isEmpty())
+        return;
+
+    partitionTable.parse(text, currentChipDb->totalSizeGetByName(chipName),
+        dataBlockSize());
+}
+
+void MainWindow::updatePartitionMenu()
+{
+    ui->menuPartitions->clear();
+    for (const PartitionTable::Partition &partition : partitionTable.get())
+    {
+        QAction *action = ui->menuPartitions->addAction(
+            tr("%1 (0x%2, 0x%3)%4").arg(partition.name)
+            .arg(partition.offset, 0, 16).arg(partition.size, 0, 16)
+            .arg(partition.isReadOnly ? tr(" read-only") : QString()));
+        action->setData(partition.name);
+    }
+    ui->menuPartitions->setEnabled(!partitionTable.get().empty());
+}
+
+void MainWindow::slotLoadPartitions()
+{
+    QString chipName = ui->chipSelectComboBox->currentText();
+    QSettings settings(SETTINGS_ORGANIZATION_NAME, SETTINGS_APPLICATION_NAME);
+    bool isOk;
+
+    QString text = QInputDialog::getMultiLineText(this, tr("Partitions"),
+        tr("Partitions of %1 as mtdparts or device tree partitions node:")
+        .arg(chipName),
+        settings.value(SETTINGS_PARTITIONS + chipName).toString(), &isOk);
+    if (!isOk)
+        return;
+
+    if (text.trimmed().isEmpty())
+    {
+        settings.remove(SETTINGS_PARTITIONS + chipName);
+        partitionTable.clear();
+        updatePartitionMenu();
+        qInfo() << "Partitions of" << chipName << "are removed";
+        return;
+    }
+
+    if (!partitionTable.parse(text,
+        currentChipDb->totalSizeGetByName(chipName), dataBlockSize()))
+    {
+        settings.setValue(SETTINGS_PARTITIONS + chipName, text);
+        qInfo() << partitionTable.get().size() << "partitions of" <<
+            chipName << "are loaded";
+    }
+    updatePartitionMenu();
+}
+
+/* Read, write, erase and verify work on the selected block range */
+void MainWindow::slotSelectPartition(QAction *action)
+{
+    const PartitionTable::Partition *partition =
+        partitionTable.find(action->data().toString());
+    quint64 blockSize = dataBlockSize();
+
+    if (!partition || !blockSize)
+        return;
+
+    ui->firstSpinBox->setValue(partition->offset / blockSize);
+    ui->lastSpinBox->setValue((partition->offset + partition->size) /
+        blockSize - 1);
+
+    qInfo() << "Partition" << partition->name << "is selected, blocks" <<
+        ui->firstSpinBox->value() << "-" << ui->lastSpinBox->value();
+    if (partition->isReadOnly)
+        qWarning() << "Partition" << partition->name << "is read-only";
+}
+
+void MainWindow::slotProgTrimRangeCompleted(quint64 status)
+{
+    quint64 blocks;
+
+    disconnect(prog, SIGNAL(scanChipBlankCompleted(quint64)), this,
+        SLOT(slotProgTrimRangeCompleted(quint64)));
+    ui->actionTrimRange->setEnabled(true);
+
+    if (status == UINT64_MAX)
+        return;
+
+    blocks = usedLen / dataBlockSize();
+    if (!blocks)
+    {
+        qInfo() << "Range is blank";
+        return;
+    }
+
+    ui->lastSpinBox->setValue(ui->firstSpinBox->value() + blocks - 1);
+    qInfo() << "Range is trimmed to" << blocks << "used blocks";
+}
+
+/* Shrinks the range to its last used block, so operations skip erased tail of
+ * partition.
+ */
+void MainWindow::slotProgTrimRange()
+{
+    quint64 blockSize = dataBlockSize();
+    quint64 start_address = blockSize * ui->firstSpinBox->value();
+    quint64 len = blockSize * (ui->lastSpinBox->value() + 1) - start_address;
+
+    if (!blockSize || ui->lastSpinBox->value() < ui->firstSpinBox->value())
+    {
+        qCritical() << "Wrong block range";
+        return;
+    }
+
+    qInfo() << "Scanning range for used blocks ...";
+    ui->actionTrimRange->setEnabled(false);
+    connect(prog, SIGNAL(scanChipBlankCompleted(quint64)), this,
+        SLOT(slotProgTrimRangeCompleted(quint64)));
+    prog->scanChipBlank(start_address, len, &usedLen);
+}
+
 void MainWindow::slotFirmwareUpdateDialog()
 {
     FirmwareUpdateDialog fwUpdateDialog(this);
@@ -9,6 +9,19 @@
 #include "programmer.h"
 #include "parallel_chip_db.h"
 #include "spi_chip_db.h"
+#include "ecc_engine.h"
+#include "ecc_decoder.h"
+#include "ecc_encoder.h"
+#include "ecc_corrector.h"
+#include "verifier.h"
+#include "read_sink.h"
+#include "image_source.h"
+#include "chip_cache.h"
+#include "region_list.h"
+#include "partition_table.h"
+#include "ubi_image.h"
+#include "bb_map.h"
+#include "majority_vote.h"
 #include <QMainWindow>
 #include <QVector>
 #include <QElapsedTimer>
@@ -17,6 +30,9 @@ namespace Ui {
 class MainWindow;
 }
 
+class SearchDialog;
+class DiffDialog;
+
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
@@ -35,14 +51,43 @@ private:
     ChipDb *currentChipDb;
     QElapsedTimer timer;
     bool isAlertEnabled;
-    QFile workFile;
+    SparseFile workFile;
+    ImageSource imageSource;
+    QFile eccFile;
     quint64 areaSize;
     uint32_t pageSize;
+    EccEngine eccEngine;
+    EccDecoder eccDecoder;
+    Verifier verifier;
+    std::unique_ptr<ReadSink> readSink;
+    EccEncoder eccEncoder;
+    EccCorrector eccCorrector;
+    SearchDialog *searchDialog;
+    DiffDialog *diffDialog;
+    ChipCache chipCache;
+    RegionFile regionFile;
+    PartitionTable partitionTable;
+    quint64 usedLen;
+    UbiImage ubiImage;
+    bool isUbiWrite;
+    std::vector<uint8_t> ubiBuf;
+    size_t ubiBufPos;
+    size_t ubiDataSize;
+    bool isPlaneWrite;
+    std::vector<uint8_t> planeBuf;
+    size_t planeBufPos;
+    quint64 planeOffset;
+    quint64 planeBlockPages;
+    BbMap bbMap;
+    MajorityVote majorityVote;
+    quint64 voteAddr;
+    uint32_t votePass;
 
     void initBufTable();
     void resetBufTable();
     void setUiStateConnected(bool isConnected);
     void setUiStateSelected(bool isSelected);
+    void setUiStateBrowsing(bool isBrowsing);
     void updateChipList();
     void setProgress(unsigned int progress);
     void updateProgSettings();
@@ -50,15 +95,46 @@ private:
     void detectChipReadChipIdDelayed();
     void detectChipDelayed();
     void setChipNameDelayed();
+    int eccLayoutGet(const QString &chipName, EccLayout &layout);
+    int eccEngineInit(const QString &chipName);
+    int openWriteFile(const QString &fileName);
+    quint64 writeFileSize();
+    qint64 readWriteFile(uint8_t *buf, qint64 len);
+    qint64 readWritePage(uint8_t *buf);
+    qint64 readFilePage(uint8_t *buf);
+    qint64 readUbiPage(uint8_t *buf);
+    qint64 readPlanePage(uint8_t *buf);
+    bool isMultiPlaneWrite(quint64 startBlock);
+    void progWrite(bool isUbi);
+    void progWriteStart();
+    void bbMapInit(quint64 startAddr, quint64 len, quint64 fileBlockSize);
+    void bbMapSave(const QString &fileName);
+    void votePassStart();
+    void voteReport();
+    void voteFinish();
+    int writeBufferInit();
+    int regionsGet(RegionList &regions, quint64 blockSize);
+    quint64 dataBlockSize();
+    void partitionsLoad();
+    void updatePartitionMenu();
+    void eccDecoderClose();
+    void verifyReport();
+    void getDumpInfo(DumpInfo &info, quint64 startAddr);
 private slots:
     void slotProgConnectCompleted(quint64 status);
     void slotProgReadDeviceIdCompleted(quint64 status);
     void slotProgReadCompleted(quint64 readBytes);
     void slotProgReadProgress(quint64 progress);
+    void slotProgReadEcc(quint64 addr, quint32 ecc);
+    void slotProgReadBadBlock(quint64 addr, bool isSkipped);
+    void slotProgReadSinkCompleted(quint64 readBytes);
+    void slotProgReadVoteCompleted(quint64 readBytes);
+    void slotProgTrimRangeCompleted(quint64 status);
     void slotProgVerifyCompleted(quint64 readBytes);
     void slotProgVerifyProgress(quint64 progress);
     void slotProgWriteCompleted(int status);
     void slotProgWriteProgress(quint64 progress);
+    void slotProgBbMapBadBlock(quint64 addr, bool isSkipped);
     void slotProgEraseCompleted(quint64 status);
     void slotProgEraseProgress(quint64 progress);
     void slotProgReadBadBlocksCompleted(quint64 status);
@@ -70,14 +146,27 @@ private slots:
     void slotProgFirmwareUpdateProgress(quint64 progress);
     void slotSelectFilePath();
     void slotFilePathEditingFinished();
+    void slotChipCacheStopped();
+    void slotCorrectEccProgress(quint64 done, quint64 total);
+    void slotCorrectEccFinished(bool isCompleted);
+    void slotImageSizeReady(bool isOk);
+    void slotVoteProgress(quint64 done, quint64 total);
+    void slotVoteFinished(bool isCompleted);
+    void slotSelectPartition(QAction *action);
 
 public slots:
     void slotProgConnect();
     void slotProgReadDeviceId();
     void slotProgErase();
     void slotProgRead();
+    void slotProgReadSpare();
+    void slotProgReadVote();
+    void slotProgReadRegions();
+    void slotProgWriteRegions();
+    void slotCorrectEcc();
     void slotProgVerify();
     void slotProgWrite();
+    void slotProgWriteUbi();
     void slotProgReadBadBlocks();
     void slotSelectChip(int selectedChipNum);
     void slotDetectChip();
@@ -86,6 +175,11 @@ public slots:
     void slotSettingsSpiChipDb();
     void slotAboutDialog();
     void slotFirmwareUpdateDialog();
+    void slotSearchDialog();
+    void slotDiffDialog();
+    void slotBrowseChip(bool isChecked);
+    void slotLoadPartitions();
+    void slotProgTrimRange();
 };
 
 #endif // MAIN_WINDOW_H
@@ -0,0 +1,384 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "majority_vote.h"
+#include "cpu_features.h"
+#include <QDebug>
+#include <QFile>
+#include <algorithm>
+#include <memory>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MAJORITY_VOTE_X86
+#endif
+
+#define MAJORITY_VOTE_CHUNK_SIZE (1 << 20)
+
+/* Bits of count are kept in planes, bit N of plane J is bit J of the count
+ * for data bit N, so 64 counters are updated by one word operation. Planes
+ * of all words are stored one after another by stride.
+ */
+typedef void (*AddPassFunc)(uint64_t *planes, size_t stride,
+    uint32_t planeNum, const uint64_t *data, size_t words);
+
+static void addPassScalar(uint64_t *planes, size_t stride, uint32_t planeNum,
+    const uint64_t *data, size_t words)
+{
+    for (size_t i = 0; i < words; i++)
+    {
+        uint64_t carry = data[i];
+
+        for (uint32_t j = 0; j < planeNum; j++)
+        {
+            uint64_t *plane = planes + j * stride + i;
+            uint64_t next = *plane & carry;
+
+            *plane ^= carry;
+            carry = next;
+        }
+    }
+}
+
+#ifdef MAJORITY_VOTE_X86
+__attribute__((target("sse2")))
+static void addPassSse2(uint64_t *planes, size_t stride, uint32_t planeNum,
+    const uint64_t *data, size_t words)
+{
+    size_t i = 0;
+
+    for (; i + 2 <= words; i += 2)
+    {
+        __m128i carry =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+
+        for (uint32_t j = 0; j < planeNum; j++)
+        {
+            __m128i *plane =
+                reinterpret_cast<__m128i *>(planes + j * stride + i);
+            __m128i p = _mm_loadu_si128(plane);
+
+            _mm_storeu_si128(plane, _mm_xor_si128(p, carry));
+            carry = _mm_and_si128(p, carry);
+        }
+    }
+
+    addPassScalar(planes + i, stride, planeNum, data + i, words - i);
+}
+
+__attribute__((target("avx2")))
+static void addPassAvx2(uint64_t *planes, size_t stride, uint32_t planeNum,
+    const uint64_t *data, size_t words)
+{
+    size_t i = 0;
+
+    for (; i + 4 <= words; i += 4)
+    {
+        __m256i carry =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+
+        for (uint32_t j = 0; j < planeNum; j++)
+        {
+            __m256i *plane =
+                reinterpret_cast<__m256i *>(planes + j * stride + i);
+            __m256i p = _mm256_loadu_si256(plane);
+
+            _mm256_storeu_si256(plane, _mm256_xor_si256(p, carry));
+            carry = _mm256_and_si256(p, carry);
+        }
+    }
+
+    addPassScalar(planes + i, stride, planeNum, data + i, words - i);
+}
+#endif
+
+struct MajorityVoteKernel
+{
+    CpuFeature feature;
+    AddPassFunc addPass;
+};
+
+static const MajorityVoteKernel kernels[] =
+{
+#ifdef MAJORITY_VOTE_X86
+    { CPU_FEATURE_AVX2, addPassAvx2 },
+    { CPU_FEATURE_SSE2, addPassSse2 },
+#endif
+    { CPU_FEATURE_NONE, addPassScalar },
+};
+
+static const MajorityVoteKernel &kernel = cpuKernelSelect(kernels);
+
+/* Value bits are turned into masks, so there are no branches on them */
+static uint64_t countEq(const uint64_t *planes, size_t stride,
+    uint32_t planeNum, uint32_t value)
+{
+    uint64_t eq = ~0ULL;
+
+    for (uint32_t j = 0; j < planeNum; j++)
+    {
+        uint64_t mask = 0ULL - (value >> j & 1);
+
+        eq &= ~(planes[j * stride] ^ mask);
+    }
+
+    return eq;
+}
+
+static uint64_t countGe(const uint64_t *planes, size_t stride,
+    uint32_t planeNum, uint32_t value)
+{
+    uint64_t gt = 0, eq = ~0ULL;
+
+    for (uint32_t j = planeNum; j-- > 0;)
+    {
+        uint64_t mask = 0ULL - (value >> j & 1);
+        uint64_t plane = planes[j * stride];
+
+        gt |= eq & plane & ~mask;
+        eq &= ~(plane ^ mask);
+    }
+
+    return gt | eq;
+}
+
+const uint32_t MajorityVote::minPasses;
+const uint32_t MajorityVote::maxPasses;
+
+MajorityVote::MajorityVote(QObject *parent) : QObject(parent)
+{
+    passes = 0;
+    unstableBits = 0;
+    blockSize = 0;
+    isStopped = true;
+}
+
+MajorityVote::~MajorityVote()
+{
+    stop();
+}
+
+int MajorityVote::init(const QString &fileName, uint32_t passes)
+{
+    if (passes < minPasses || passes > maxPasses)
+    {
+        qCritical() << "Number of reads must be from" << minPasses << "to" <<
+            maxPasses;
+        return -1;
+    }
+
+    this->fileName = fileName;
+    this->passes = passes;
+    unstableBits = 0;
+    histogram.assign(passes + 1, 0);
+    blockStats.clear();
+
+    return 0;
+}
+
+QString MajorityVote::passFileName(uint32_t pass)
+{
+    return fileName + QString(".pass%1").arg(pass + 1);
+}
+
+QString MajorityVote::unstableFileName(const QString &fileName)
+{
+    return fileName + ".unstable";
+}
+
+/* Each pass is added to counters of all words at once, so the loops have
+ * no data dependent exits and run by SIMD kernel.
+ */
+void MajorityVote::vote(const std::vector<std::vector<uint64_t>> &data,
+    size_t words, uint64_t *result, uint64_t *unstable)
+{
+    uint32_t threshold = passes / 2 + 1;
+
+    std::fill(planes.begin(), planes.begin() + countBits * words, 0);
+    for (uint32_t pass = 0; pass < passes; pass++)
+    {
+        kernel.addPass(planes.data(), words, countBits, data[pass].data(),
+            words);
+    }
+
+    for (size_t i = 0; i < words; i++)
+    {
+        const uint64_t *counts = planes.data() + i;
+
+        result[i] = countGe(counts, words, countBits, threshold);
+        unstable[i] = ~countEq(counts, words, countBits, 0) &
+            ~countEq(counts, words, countBits, passes);
+    }
+
+    for (size_t i = 0; i < words; i++)
+    {
+        if (!unstable[i])
+            continue;
+
+        for (uint32_t count = 1; count < passes; count++)
+        {
+            histogram[count] += __builtin_popcountll(
+                countEq(planes.data() + i, words, countBits, count));
+        }
+    }
+}
+
+int MajorityVote::start(quint64 blockSize)
+{
+    stop();
+
+    this->blockSize = blockSize;
+    isStopped = false;
+    thread = std::thread(&MajorityVote::worker, this);
+
+    return 0;
+}
+
+void MajorityVote::stop()
+{
+    if (!thread.joinable())
+        return;
+
+    isStopped = true;
+    thread.join();
+}
+
+bool MajorityVote::isRunning()
+{
+    return thread.joinable();
+}
+
+void MajorityVote::worker()
+{
+    int ret = combine();
+
+    planes.clear();
+    planes.shrink_to_fit();
+
+    emit finished(!ret && !isStopped);
+}
+
+int MajorityVote::combine()
+{
+    std::vector<std::unique_ptr<QFile>> files;
+    std::vector<std::vector<uint64_t>> data(passes);
+    std::vector<uint64_t> result(MAJORITY_VOTE_CHUNK_SIZE / sizeof(uint64_t));
+    std::vector<uint64_t> unstable(result.size());
+    QFile resultFile(fileName), unstableFile(unstableFileName(fileName));
+    qint64 size = -1;
+
+    for (uint32_t pass = 0; pass < passes; pass++)
+    {
+        files.emplace_back(new QFile(passFileName(pass)));
+        if (!files.back()->open(QIODevice::ReadOnly))
+        {
+            qCritical() << "Failed to open file:" << passFileName(pass) <<
+                ", error:" << files.back()->errorString();
+            return -1;
+        }
+
+        if (size >= 0 && files.back()->size() != size)
+        {
+            qCritical() << "Read" << pass + 1 << "returned" <<
+                files.back()->size() << "bytes instead of" << size;
+            return -1;
+        }
+        size = files.back()->size();
+        data[pass].resize(result.size());
+    }
+    planes.resize(countBits * result.size());
+
+    if (!resultFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qCritical() << "Failed to open file:" << fileName << ", error:" <<
+            resultFile.errorString();
+        return -1;
+    }
+
+    if (!unstableFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qCritical() << "Failed to open file:" << unstableFile.fileName() <<
+            ", error:" << unstableFile.errorString();
+        return -1;
+    }
+
+    for (qint64 offset = 0; offset < size; offset += MAJORITY_VOTE_CHUNK_SIZE)
+    {
+        if (isStopped)
+            return -1;
+
+        qint64 len = std::min<qint64>(MAJORITY_VOTE_CHUNK_SIZE,
+            size - offset);
+        size_t words = (len + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+        for (uint32_t pass = 0; pass < passes; pass++)
+        {
+            char *buf = reinterpret_cast<char *>(data[pass].data());
+
+            /* Tail of the last word is the same in all passes */
+            data[pass][words - 1] = 0;
+            if (files[pass]->read(buf, len) != len)
+            {
+                qCritical() << "Failed to read file:" <<
+                    files[pass]->fileName() << ", error:" <<
+                    files[pass]->errorString();
+                return -1;
+            }
+        }
+
+        vote(data, words, result.data(), unstable.data());
+
+        for (size_t i = 0; i < words; i++)
+        {
+            if (unstable[i])
+            {
+                quint64 bits = __builtin_popcountll(unstable[i]);
+
+                blockStats[(offset + i * sizeof(uint64_t)) / blockSize] +=
+                    bits;
+                unstableBits += bits;
+            }
+        }
+
+        if (resultFile.write(reinterpret_cast<const char *>(result.data()),
+            len) != len ||
+            unstableFile.write(reinterpret_cast<const char *>(
+            unstable.data()), len) != len)
+        {
+            qCritical() << "Failed to write file:" << fileName;
+            return -1;
+        }
+
+        emit progress(offset + len, size);
+    }
+
+    return 0;
+}
+
+void MajorityVote::removePasses()
+{
+    for (uint32_t pass = 0; pass < passes; pass++)
+        QFile::remove(passFileName(pass));
+}
+
+uint32_t MajorityVote::getPasses()
+{
+    return passes;
+}
+
+quint64 MajorityVote::getUnstableBits()
+{
+    return unstableBits;
+}
+
+const std::vector<quint64> &MajorityVote::getHistogram()
+{
+    return histogram;
+}
+
+const QMap<quint64, quint64> &MajorityVote::getBlockStats()
+{
+    return blockStats;
+}
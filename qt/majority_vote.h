@@ -0,0 +1,72 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef MAJORITY_VOTE_H
+#define MAJORITY_VOTE_H
+
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+/* Several reads of the same range are saved to pass files and combined by
+ * bitwise majority vote. Bit is unstable if it was not read the same in all
+ * passes, unstable bits are set in <file>.unstable. Passes are combined
+ * on a worker thread.
+ */
+class MajorityVote : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const uint32_t minPasses = 3;
+    static const uint32_t maxPasses = 9;
+
+private:
+    static const uint32_t countBits = 4;
+
+    QString fileName;
+    uint32_t passes;
+    quint64 unstableBits;
+    /* Unstable bits read as 1 in each number of passes */
+    std::vector<quint64> histogram;
+    QMap<quint64, quint64> blockStats;
+    /* Bit planes of counters, one plane of chunk words after another */
+    std::vector<uint64_t> planes;
+    quint64 blockSize;
+    std::thread thread;
+    std::atomic<bool> isStopped;
+
+    void vote(const std::vector<std::vector<uint64_t>> &data, size_t words,
+        uint64_t *result, uint64_t *unstable);
+    int combine();
+    void worker();
+
+public:
+    explicit MajorityVote(QObject *parent = nullptr);
+    ~MajorityVote();
+    int init(const QString &fileName, uint32_t passes);
+    QString passFileName(uint32_t pass);
+    static QString unstableFileName(const QString &fileName);
+    int start(quint64 blockSize);
+    void stop();
+    bool isRunning();
+    void removePasses();
+    uint32_t getPasses();
+    /* Valid after finished signal */
+    quint64 getUnstableBits();
+    const std::vector<quint64> &getHistogram();
+    /* Unstable bits per block */
+    const QMap<quint64, quint64> &getBlockStats();
+
+signals:
+    void progress(quint64 done, quint64 total);
+    void finished(bool isCompleted);
+};
+
+#endif // MAJORITY_VOTE_H
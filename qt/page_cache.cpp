@@ -0,0 +1,151 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "page_cache.h"
+#include <QDebug>
+#include <algorithm>
+
+PageCache::PageCache()
+{
+    device = nullptr;
+    mappedFile = nullptr;
+    map = nullptr;
+    deviceSize = 0;
+}
+
+PageCache::~PageCache()
+{
+    clear();
+}
+
+int PageCache::setDevice(QIODevice *device, bool isMappable)
+{
+    clear();
+
+    if (!device->open(QIODevice::ReadOnly))
+        return -1;
+
+    this->device = device;
+    deviceSize = device->size();
+
+    /* Mapping fails for empty files and for large files on 32 bit hosts,
+     * such files are read through the cache.
+     */
+    QFile *file = isMappable ? qobject_cast<QFile *>(device) : nullptr;
+    if (file && deviceSize > 0)
+    {
+        map = file->map(0, deviceSize);
+        if (map)
+            mappedFile = file;
+    }
+
+    return 0;
+}
+
+void PageCache::clear()
+{
+    if (mappedFile)
+        mappedFile->unmap(const_cast<uchar *>(map));
+    mappedFile = nullptr;
+    map = nullptr;
+
+    pages.clear();
+    pageIndex.clear();
+
+    if (device)
+        device->close();
+    device = nullptr;
+    deviceSize = 0;
+}
+
+qint64 PageCache::size()
+{
+    return deviceSize;
+}
+
+bool PageCache::isMapped()
+{
+    return map != nullptr;
+}
+
+const QByteArray *PageCache::page(qint64 index)
+{
+    auto it = pageIndex.find(index);
+
+    if (it != pageIndex.end())
+    {
+        pages.splice(pages.begin(), pages, it->second);
+        return &pages.front().data;
+    }
+
+    if (!device->seek(index * pageSize))
+        return nullptr;
+
+    QByteArray data = device->read(pageSize);
+    if (data.isEmpty())
+        return nullptr;
+
+    if (pages.size() >= maxPages)
+    {
+        pageIndex.erase(pages.back().index);
+        pages.pop_back();
+    }
+
+    pages.push_front({ index, data });
+    pageIndex[index] = pages.begin();
+
+    return &pages.front().data;
+}
+
+QByteArray PageCache::read(qint64 pos, qint64 len)
+{
+    QByteArray buf;
+
+    if (!device || pos < 0 || pos >= deviceSize)
+        return buf;
+
+    len = std::min(len, deviceSize - pos);
+
+    if (map)
+        return QByteArray(reinterpret_cast<const char *>(map + pos), len);
+
+    buf.reserve(len);
+    while (len > 0)
+    {
+        const QByteArray *data = page(pos / pageSize);
+        qint64 off = pos % pageSize;
+
+        if (!data || data->size() <= off)
+            break;
+
+        qint64 chunk = std::min(len, data->size() - off);
+        buf.append(data->constData() + off, chunk);
+        pos += chunk;
+        len -= chunk;
+    }
+
+    return buf;
+}
+
+void PageCache::prefetch(qint64 pos, qint64 len)
+{
+    /* OS read ahead works for mapped files */
+    if (!device || map)
+        return;
+
+    pos = std::max<qint64>(pos, 0);
+    len = std::min(len, deviceSize - pos);
+    if (len <= 0)
+        return;
+
+    /* Prefetch must not evict pages being shown */
+    qint64 first = pos / pageSize, last = (pos + len - 1) / pageSize;
+    last = std::min<qint64>(last, first + maxPages / 2 - 1);
+    for (qint64 i = first; i <= last; i++)
+    {
+        if (pageIndex.find(i) == pageIndex.end() && !page(i))
+            break;
+    }
+}
@@ -0,0 +1,54 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef PAGE_CACHE_H
+#define PAGE_CACHE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QIODevice>
+#include <list>
+#include <unordered_map>
+
+/* Random read access to a device which is kept open. Plain files are
+ * mapped to memory, other devices are read by fixed size pages kept in
+ * LRU cache.
+ */
+class PageCache
+{
+    typedef struct
+    {
+        qint64 index;
+        QByteArray data;
+    } Page;
+
+    const qint64 pageSize = 64 * 1024;
+    const size_t maxPages = 256;
+
+    QIODevice *device;
+    QFile *mappedFile;
+    const uchar *map;
+    qint64 deviceSize;
+    /* Most recently used page is the first */
+    std::list<Page> pages;
+    std::unordered_map<qint64, std::list<Page>::iterator> pageIndex;
+
+    const QByteArray *page(qint64 index);
+
+public:
+    PageCache();
+    ~PageCache();
+
+    /* Device is opened read only. File is mapped if isMappable is set. */
+    int setDevice(QIODevice *device, bool isMappable);
+    void clear();
+    qint64 size();
+    bool isMapped();
+    QByteArray read(qint64 pos, qint64 len);
+    /* Loads pages of the range to cache in advance */
+    void prefetch(qint64 pos, qint64 len);
+};
+
+#endif // PAGE_CACHE_H
@@ -64,6 +64,18 @@ public:
         CHIP_PARAM_ENABLE_HW_ECC_ADDR,
         CHIP_PARAM_ENABLE_HW_ECC_VALUE,
         CHIP_PARAM_DISABLE_HW_ECC_VALUE,
+        CHIP_PARAM_READ_CACHE_SEQ_CMD,
+        CHIP_PARAM_READ_CACHE_END_CMD,
+        CHIP_PARAM_WRITE_CACHE_CMD,
+        CHIP_PARAM_PLANES,
+        CHIP_PARAM_ERASE_MP_CMD,
+        CHIP_PARAM_WRITE_MP_CMD,
+        CHIP_PARAM_LUNS,
+        CHIP_PARAM_STATUS_ENH_CMD,
+        CHIP_PARAM_ECC_SPARE_OFF,
+        CHIP_PARAM_ECC_STEP,
+        CHIP_PARAM_ECC_STRENGTH,
+        CHIP_PARAM_ECC_OFFSET,
         CHIP_PARAM_ID1,
         CHIP_PARAM_ID2,
         CHIP_PARAM_ID3,
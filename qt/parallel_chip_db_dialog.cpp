@@ -41,7 +41,7 @@ ParallelChipDbDialog::ParallelChipDbDialog(ParallelChipDb *chipDb,
         ui->chipDbTableView->setColumnWidth(i, HEADER_SHORT_WIDTH);
     }
     for (int i = ParallelChipDb::CHIP_PARAM_ROW_CYCLES;
-         i <= ParallelChipDb::CHIP_PARAM_DISABLE_HW_ECC_VALUE; i++)
+         i < ParallelChipDb::CHIP_PARAM_ID1; i++)
     {
         ui->chipDbTableView->setColumnWidth(i, HEADER_MED_WIDTH);
     }
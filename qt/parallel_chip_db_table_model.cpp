@@ -161,6 +161,54 @@ QVariant ParallelChipDbTableModel::data(const QModelIndex &index,
         chipDb->getHexStringFromOptParam(chipDb->getChipParam(index.row(),
             ParallelChipInfo::CHIP_PARAM_DISABLE_HW_ECC_VALUE), paramStr);
         return paramStr;
+    case ParallelChipDb::CHIP_PARAM_READ_CACHE_SEQ_CMD:
+        chipDb->getHexStringFromOptParam(chipDb->getChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_READ_CACHE_SEQ_CMD), paramStr);
+        return paramStr;
+    case ParallelChipDb::CHIP_PARAM_READ_CACHE_END_CMD:
+        chipDb->getHexStringFromOptParam(chipDb->getChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_READ_CACHE_END_CMD), paramStr);
+        return paramStr;
+    case ParallelChipDb::CHIP_PARAM_WRITE_CACHE_CMD:
+        chipDb->getHexStringFromOptParam(chipDb->getChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_WRITE_CACHE_CMD), paramStr);
+        return paramStr;
+    case ParallelChipDb::CHIP_PARAM_PLANES:
+        chipDb->getStringFromOptParam(chipDb->getChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_PLANES), paramStr);
+        return paramStr;
+    case ParallelChipDb::CHIP_PARAM_ERASE_MP_CMD:
+        chipDb->getHexStringFromOptParam(chipDb->getChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_ERASE_MP_CMD), paramStr);
+        return paramStr;
+    case ParallelChipDb::CHIP_PARAM_WRITE_MP_CMD:
+        chipDb->getHexStringFromOptParam(chipDb->getChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_WRITE_MP_CMD), paramStr);
+        return paramStr;
+    case ParallelChipDb::CHIP_PARAM_LUNS:
+        chipDb->getStringFromOptParam(chipDb->getChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_LUNS), paramStr);
+        return paramStr;
+    case ParallelChipDb::CHIP_PARAM_STATUS_ENH_CMD:
+        chipDb->getHexStringFromOptParam(chipDb->getChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_STATUS_ENH_CMD), paramStr);
+        return paramStr;
+    case ParallelChipDb::CHIP_PARAM_ECC_SPARE_OFF:
+        chipDb->getStringFromOptParam(chipDb->getChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_ECC_SPARE_OFF), paramStr);
+        return paramStr;
+    case ParallelChipDb::CHIP_PARAM_ECC_STEP:
+        chipDb->getStringFromOptParam(chipDb->getChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_ECC_STEP), paramStr);
+        return paramStr;
+    case ParallelChipDb::CHIP_PARAM_ECC_STRENGTH:
+        chipDb->getStringFromOptParam(chipDb->getChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_ECC_STRENGTH), paramStr);
+        return paramStr;
+    case ParallelChipDb::CHIP_PARAM_ECC_OFFSET:
+        chipDb->getStringFromOptParam(chipDb->getChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_ECC_OFFSET), paramStr);
+        return paramStr;
     case ParallelChipDb::CHIP_PARAM_ID1:
         chipDb->getHexStringFromParam(chipDb->getChipParam(index.row(),
             ParallelChipInfo::CHIP_PARAM_ID1), paramStr);
@@ -265,6 +313,30 @@ QVariant ParallelChipDbTableModel::headerData(int section,
             return tr("En. HW ECC val.");
         case ParallelChipDb::CHIP_PARAM_DISABLE_HW_ECC_VALUE:
             return tr("Dis. HW ECC val.");
+        case ParallelChipDb::CHIP_PARAM_READ_CACHE_SEQ_CMD:
+            return tr("Read cache seq. com.");
+        case ParallelChipDb::CHIP_PARAM_READ_CACHE_END_CMD:
+            return tr("Read cache end com.");
+        case ParallelChipDb::CHIP_PARAM_WRITE_CACHE_CMD:
+            return tr("Write cache com.");
+        case ParallelChipDb::CHIP_PARAM_PLANES:
+            return tr("Planes");
+        case ParallelChipDb::CHIP_PARAM_ERASE_MP_CMD:
+            return tr("Multi-plane erase com.");
+        case ParallelChipDb::CHIP_PARAM_WRITE_MP_CMD:
+            return tr("Multi-plane write com.");
+        case ParallelChipDb::CHIP_PARAM_LUNS:
+            return tr("LUNs");
+        case ParallelChipDb::CHIP_PARAM_STATUS_ENH_CMD:
+            return tr("Status enh. com.");
+        case ParallelChipDb::CHIP_PARAM_ECC_SPARE_OFF:
+            return tr("ECC spare off.");
+        case ParallelChipDb::CHIP_PARAM_ECC_STEP:
+            return tr("ECC step");
+        case ParallelChipDb::CHIP_PARAM_ECC_STRENGTH:
+            return tr("ECC strength");
+        case ParallelChipDb::CHIP_PARAM_ECC_OFFSET:
+            return tr("ECC off.");
         case ParallelChipDb::CHIP_PARAM_ID1:
             return tr("ID 1");
         case ParallelChipDb::CHIP_PARAM_ID2:
@@ -356,6 +428,30 @@ QVariant ParallelChipDbTableModel::headerData(int section,
             return tr("Enable HW ECC value");
         case ParallelChipDb::CHIP_PARAM_DISABLE_HW_ECC_VALUE:
             return tr("Disable HW ECC value");
+        case ParallelChipDb::CHIP_PARAM_READ_CACHE_SEQ_CMD:
+            return tr("Read cache sequential command");
+        case ParallelChipDb::CHIP_PARAM_READ_CACHE_END_CMD:
+            return tr("Read cache end command");
+        case ParallelChipDb::CHIP_PARAM_WRITE_CACHE_CMD:
+            return tr("Page cache program command");
+        case ParallelChipDb::CHIP_PARAM_PLANES:
+            return tr("Number of planes");
+        case ParallelChipDb::CHIP_PARAM_ERASE_MP_CMD:
+            return tr("Multi-plane erase command");
+        case ParallelChipDb::CHIP_PARAM_WRITE_MP_CMD:
+            return tr("Multi-plane page program command of first plane");
+        case ParallelChipDb::CHIP_PARAM_LUNS:
+            return tr("Number of independent LUNs (dies)");
+        case ParallelChipDb::CHIP_PARAM_STATUS_ENH_CMD:
+            return tr("Read status enhanced command");
+        case ParallelChipDb::CHIP_PARAM_ECC_SPARE_OFF:
+            return tr("FSMC ECC offset in spare area");
+        case ParallelChipDb::CHIP_PARAM_ECC_STEP:
+            return tr("Data bytes protected by one ECC code");
+        case ParallelChipDb::CHIP_PARAM_ECC_STRENGTH:
+            return tr("Bits corrected per ECC step, 1 - Hamming, more - BCH");
+        case ParallelChipDb::CHIP_PARAM_ECC_OFFSET:
+            return tr("Offset of ECC codes in spare area");
         case ParallelChipDb::CHIP_PARAM_ID1:
             return tr("Chip ID 1st byte");
         case ParallelChipDb::CHIP_PARAM_ID2:
@@ -635,6 +731,109 @@ bool ParallelChipDbTableModel::setData(const QModelIndex &index,
         chipDb->setChipParam(index.row(),
             ParallelChipInfo::CHIP_PARAM_DISABLE_HW_ECC_VALUE, paramVal);
         return true;
+    case ParallelChipDb::CHIP_PARAM_READ_CACHE_SEQ_CMD:
+        if (chipDb->getOptParamFromHexString(value.toString(), paramVal))
+            return false;
+        if (!chipDb->isOptParamValid(paramVal, 0x00, 0xFF))
+            return false;
+        chipDb->setChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_READ_CACHE_SEQ_CMD, paramVal);
+        return true;
+    case ParallelChipDb::CHIP_PARAM_READ_CACHE_END_CMD:
+        if (chipDb->getOptParamFromHexString(value.toString(), paramVal))
+            return false;
+        if (!chipDb->isOptParamValid(paramVal, 0x00, 0xFF))
+            return false;
+        chipDb->setChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_READ_CACHE_END_CMD, paramVal);
+        return true;
+    case ParallelChipDb::CHIP_PARAM_WRITE_CACHE_CMD:
+        if (chipDb->getOptParamFromHexString(value.toString(), paramVal))
+            return false;
+        if (!chipDb->isOptParamValid(paramVal, 0x00, 0xFF))
+            return false;
+        chipDb->setChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_WRITE_CACHE_CMD, paramVal);
+        return true;
+    case ParallelChipDb::CHIP_PARAM_PLANES:
+        if (chipDb->getOptParamFromString(value.toString(), paramVal))
+            return false;
+        if (!chipDb->isOptParamValid(paramVal, 1, 8))
+            return false;
+        chipDb->setChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_PLANES, paramVal);
+        return true;
+    case ParallelChipDb::CHIP_PARAM_ERASE_MP_CMD:
+        if (chipDb->getOptParamFromHexString(value.toString(), paramVal))
+            return false;
+        if (!chipDb->isOptParamValid(paramVal, 0x00, 0xFF))
+            return false;
+        chipDb->setChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_ERASE_MP_CMD, paramVal);
+        return true;
+    case ParallelChipDb::CHIP_PARAM_WRITE_MP_CMD:
+        if (chipDb->getOptParamFromHexString(value.toString(), paramVal))
+            return false;
+        if (!chipDb->isOptParamValid(paramVal, 0x00, 0xFF))
+            return false;
+        chipDb->setChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_WRITE_MP_CMD, paramVal);
+        return true;
+    case ParallelChipDb::CHIP_PARAM_LUNS:
+        if (chipDb->getOptParamFromString(value.toString(), paramVal))
+            return false;
+        if (!chipDb->isOptParamValid(paramVal, 1, 8))
+            return false;
+        chipDb->setChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_LUNS, paramVal);
+        return true;
+    case ParallelChipDb::CHIP_PARAM_STATUS_ENH_CMD:
+        if (chipDb->getOptParamFromHexString(value.toString(), paramVal))
+            return false;
+        if (!chipDb->isOptParamValid(paramVal, 0x00, 0xFF))
+            return false;
+        chipDb->setChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_STATUS_ENH_CMD, paramVal);
+        return true;
+    case ParallelChipDb::CHIP_PARAM_ECC_SPARE_OFF:
+        if (chipDb->getOptParamFromString(value.toString(), paramVal))
+            return false;
+        if (!chipDb->isOptParamValid(paramVal, 0, 254))
+            return false;
+        /* ECC must fit to spare area */
+        if (paramVal != chipDb->paramNotDefValue &&
+            paramVal + ParallelChipInfo::fsmcEccBytes >
+            chipDb->getSpareSize(index.row()))
+        {
+            return false;
+        }
+        chipDb->setChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_ECC_SPARE_OFF, paramVal);
+        return true;
+    case ParallelChipDb::CHIP_PARAM_ECC_STEP:
+        if (chipDb->getOptParamFromString(value.toString(), paramVal))
+            return false;
+        if (!chipDb->isOptParamValid(paramVal, 1, 4096))
+            return false;
+        chipDb->setChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_ECC_STEP, paramVal);
+        return true;
+    case ParallelChipDb::CHIP_PARAM_ECC_STRENGTH:
+        if (chipDb->getOptParamFromString(value.toString(), paramVal))
+            return false;
+        if (!chipDb->isOptParamValid(paramVal, 1, 64))
+            return false;
+        chipDb->setChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_ECC_STRENGTH, paramVal);
+        return true;
+    case ParallelChipDb::CHIP_PARAM_ECC_OFFSET:
+        if (chipDb->getOptParamFromString(value.toString(), paramVal))
+            return false;
+        if (!chipDb->isOptParamValid(paramVal, 0, 65535))
+            return false;
+        chipDb->setChipParam(index.row(),
+            ParallelChipInfo::CHIP_PARAM_ECC_OFFSET, paramVal);
+        return true;
     case ParallelChipDb::CHIP_PARAM_ID1:
         if (chipDb->getParamFromHexString(value.toString(), paramVal))
             return false;
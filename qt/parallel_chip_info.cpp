@@ -4,6 +4,7 @@
  */
 
 #include "parallel_chip_info.h"
+#include <QDebug>
 #include <stdint.h>
 #include <algorithm>
 #include <array>
@@ -33,6 +34,15 @@ typedef struct __attribute__((__packed__))
     uint8_t enableEccAddr;
     uint8_t enableEccValue;
     uint8_t disableEccValue;
+    uint8_t readCacheSeqCmd;
+    uint8_t readCacheEndCmd;
+    uint8_t writeCacheCmd;
+    uint8_t planes;
+    uint8_t eraseMpCmd;
+    uint8_t luns;
+    uint8_t statusEnhCmd;
+    uint8_t eccSpareOff;
+    uint8_t writeMpCmd;
 } ParallelChipConf;
 
 ParallelChipInfo::ParallelChipInfo()
@@ -122,6 +132,7 @@ const QByteArray &ParallelChipInfo::getHalConf()
 {
     ParallelChipConf conf;
     StmParams stmParams;
+    quint64 eccSpareOff;
 
     chipInfoToStmParams(&stmParams);
 
@@ -150,6 +161,30 @@ const QByteArray &ParallelChipInfo::getHalConf()
         static_cast<uint8_t>(params[CHIP_PARAM_ENABLE_HW_ECC_VALUE]);
     conf.disableEccValue =
         static_cast<uint8_t>(params[CHIP_PARAM_DISABLE_HW_ECC_VALUE]);
+    conf.readCacheSeqCmd =
+        static_cast<uint8_t>(params[CHIP_PARAM_READ_CACHE_SEQ_CMD]);
+    conf.readCacheEndCmd =
+        static_cast<uint8_t>(params[CHIP_PARAM_READ_CACHE_END_CMD]);
+    conf.writeCacheCmd =
+        static_cast<uint8_t>(params[CHIP_PARAM_WRITE_CACHE_CMD]);
+    conf.planes = static_cast<uint8_t>(params[CHIP_PARAM_PLANES]);
+    conf.eraseMpCmd = static_cast<uint8_t>(params[CHIP_PARAM_ERASE_MP_CMD]);
+    conf.luns = static_cast<uint8_t>(params[CHIP_PARAM_LUNS]);
+    conf.statusEnhCmd = static_cast<uint8_t>(params[CHIP_PARAM_STATUS_ENH_CMD]);
+    /* Not defined value is 0xFFFFFFFF, firmware rejects ECC which does not
+     * fit to spare area
+     */
+    eccSpareOff = params[CHIP_PARAM_ECC_SPARE_OFF];
+    if (eccSpareOff < UINT8_MAX && eccSpareOff + fsmcEccBytes > spareSize)
+    {
+        qWarning() << "ECC spare offset" << eccSpareOff <<
+            "is out of spare area, FSMC ECC is not written to spare";
+    }
+    conf.eccSpareOff = eccSpareOff < UINT8_MAX &&
+        eccSpareOff + fsmcEccBytes <= spareSize ?
+        static_cast<uint8_t>(eccSpareOff) : UINT8_MAX;
+
+    conf.writeMpCmd = static_cast<uint8_t>(params[CHIP_PARAM_WRITE_MP_CMD]);
 
     halConf.clear();
     halConf.append(reinterpret_cast<const char *>(&conf), sizeof(conf));
@@ -174,3 +209,20 @@ int ParallelChipInfo::setParam(uint32_t num, quint64 value)
 
     return 0;
 }
+
+int ParallelChipInfo::getEccLayout(EccLayout &layout)
+{
+    quint64 step = params[CHIP_PARAM_ECC_STEP];
+    quint64 strength = params[CHIP_PARAM_ECC_STRENGTH];
+    quint64 offset = params[CHIP_PARAM_ECC_OFFSET];
+
+    /* Parameters are optional, not defined value is 0xFFFFFFFF */
+    if (step > UINT16_MAX || strength > UINT16_MAX || offset > UINT16_MAX)
+        return -1;
+
+    layout.step = static_cast<uint32_t>(step);
+    layout.strength = static_cast<uint32_t>(strength);
+    layout.offset = static_cast<uint32_t>(offset);
+
+    return 0;
+}
@@ -0,0 +1,291 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "partition_table.h"
+#include <QDebug>
+#include <QStringList>
+#include <algorithm>
+#include <cstring>
+#include <set>
+
+static int parseSize(QString str, quint64 &size)
+{
+    static const struct
+    {
+        char suffix;
+        quint64 mult;
+    } suffixes[] = {
+        { 'k', 1ULL << 10 },
+        { 'm', 1ULL << 20 },
+        { 'g', 1ULL << 30 },
+    };
+    quint64 mult = 1;
+    bool isOk;
+
+    for (const auto &s : suffixes)
+    {
+        if (str.endsWith(QLatin1Char(s.suffix), Qt::CaseInsensitive))
+        {
+            mult = s.mult;
+            str.chop(1);
+            break;
+        }
+    }
+
+    size = str.toULongLong(&isOk, 0) * mult;
+
+    return isOk ? 0 : -1;
+}
+
+int PartitionTable::parseMtdParts(const QString &text, quint64 chipSize)
+{
+    QString parts = text.simplified();
+    quint64 offset = 0;
+    int pos;
+
+    parts.remove(' ');
+    if (parts.startsWith("mtdparts="))
+        parts = parts.mid(static_cast<int>(strlen("mtdparts=")));
+    /* Only the first device is used */
+    if ((pos = parts.indexOf(';')) >= 0)
+        parts = parts.left(pos);
+    /* Skip mtd-id, name in parentheses can also have colon */
+    pos = parts.indexOf(':');
+    if (pos >= 0 && (parts.indexOf('(') < 0 || pos < parts.indexOf('(')))
+        parts = parts.mid(pos + 1);
+
+    QStringList fields = parts.split(',');
+    for (int i = 0; i < fields.size(); i++)
+    {
+        const QString &field = fields[i];
+        int nameStart = field.indexOf('('), nameEnd = field.indexOf(')');
+        QString sizeStr = nameStart < 0 ? field : field.left(nameStart);
+        Partition partition;
+
+        if (nameStart >= 0 && nameEnd < nameStart)
+        {
+            qCritical() << "Wrong partition:" << field;
+            return -1;
+        }
+        partition.name = nameStart < 0 ?
+            QString("Partition_%1").arg(i, 3, 10, QLatin1Char('0')) :
+            field.mid(nameStart + 1, nameEnd - nameStart - 1);
+        partition.isReadOnly = nameEnd >= 0 &&
+            field.mid(nameEnd + 1).contains("ro");
+
+        if ((pos = sizeStr.indexOf('@')) >= 0)
+        {
+            if (parseSize(sizeStr.mid(pos + 1), offset))
+            {
+                qCritical() << "Wrong partition offset:" << field;
+                return -1;
+            }
+            sizeStr = sizeStr.left(pos);
+        }
+        partition.offset = offset;
+
+        if (sizeStr == "-")
+        {
+            if (i != fields.size() - 1)
+            {
+                qCritical() << "Partition" << partition.name <<
+                    "takes the rest of chip but is not the last one";
+                return -1;
+            }
+            partition.size = chipSize > offset ? chipSize - offset : 0;
+        }
+        else if (parseSize(sizeStr, partition.size))
+        {
+            qCritical() << "Wrong partition size:" << field;
+            return -1;
+        }
+
+        offset += partition.size;
+        partitions.push_back(partition);
+    }
+
+    return 0;
+}
+
+static int parseReg(QString value, quint64 &offset, quint64 &size)
+{
+    quint64 cells[4];
+    bool isOk;
+
+    QStringList fields = value.remove('<').remove('>').simplified().split(' ');
+    if (fields.size() != 2 && fields.size() != 4)
+        return -1;
+
+    for (int i = 0; i < fields.size(); i++)
+    {
+        cells[i] = fields[i].toULongLong(&isOk, 0);
+        if (!isOk)
+            return -1;
+    }
+
+    /* 64-bit address and size take two cells each */
+    if (fields.size() == 4)
+    {
+        offset = cells[0] << 32 | cells[1];
+        size = cells[2] << 32 | cells[3];
+    }
+    else
+    {
+        offset = cells[0];
+        size = cells[1];
+    }
+
+    return 0;
+}
+
+int PartitionTable::parseDts(const QString &text)
+{
+    int pos = 0, open;
+
+    while ((open = text.indexOf('{', pos)) >= 0)
+    {
+        int close = text.indexOf('}', open);
+        int next = text.indexOf('{', open + 1);
+        int start = 0;
+        bool hasReg = false;
+        Partition partition;
+
+        if (close < 0)
+        {
+            qCritical() << "Partitions node is not closed";
+            return -1;
+        }
+
+        /* Container node, its children are partitions */
+        if (next >= 0 && next < close)
+        {
+            pos = next;
+            continue;
+        }
+        pos = close + 1;
+
+        /* Node name is used if label is not set */
+        if (open)
+        {
+            start = std::max(text.lastIndexOf(';', open - 1),
+                text.lastIndexOf('}', open - 1));
+            start = std::max(start, text.lastIndexOf('{', open - 1)) + 1;
+        }
+        partition.name = text.mid(start, open - start).simplified()
+            .split(' ').back();
+        partition.isReadOnly = false;
+
+        for (const QString &prop : text.mid(open + 1, close - open - 1)
+            .split(';'))
+        {
+            int eq = prop.indexOf('=');
+            QString key = (eq < 0 ? prop : prop.left(eq)).trimmed();
+            QString value = eq < 0 ? QString() : prop.mid(eq + 1).trimmed();
+
+            if (key == "label")
+                partition.name = value.remove('"');
+            else if (key == "read-only")
+                partition.isReadOnly = true;
+            else if (key == "reg")
+            {
+                if (parseReg(value, partition.offset, partition.size))
+                {
+                    qCritical() << "Wrong reg of partition" <<
+                        partition.name << ":" << value;
+                    return -1;
+                }
+                hasReg = true;
+            }
+        }
+
+        /* Not a partition node */
+        if (!hasReg)
+            continue;
+
+        partitions.push_back(partition);
+    }
+
+    return 0;
+}
+
+int PartitionTable::check(quint64 chipSize, quint64 blockSize)
+{
+    std::set<QString> names;
+
+    if (partitions.empty())
+    {
+        qCritical() << "Partitions are not set";
+        return -1;
+    }
+
+    for (const Partition &partition : partitions)
+    {
+        if (!partition.size || partition.offset >= chipSize ||
+            partition.size > chipSize - partition.offset)
+        {
+            qCritical() << "Partition" << partition.name <<
+                "is out of chip";
+            return -1;
+        }
+
+        if (partition.offset % blockSize || partition.size % blockSize)
+        {
+            qCritical() << "Partition" << partition.name <<
+                "is not aligned to block size";
+            return -1;
+        }
+
+        if (!names.insert(partition.name).second)
+        {
+            qCritical() << "Partition name" << partition.name <<
+                "is not unique";
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int PartitionTable::parse(const QString &text, quint64 chipSize,
+    quint64 blockSize)
+{
+    int ret;
+
+    partitions.clear();
+    if (!blockSize)
+        return -1;
+
+    ret = text.contains('{') ? parseDts(text) :
+        parseMtdParts(text, chipSize);
+    if (ret || check(chipSize, blockSize))
+    {
+        partitions.clear();
+        return -1;
+    }
+
+    return 0;
+}
+
+const std::vector<PartitionTable::Partition> &PartitionTable::get() const
+{
+    return partitions;
+}
+
+const PartitionTable::Partition *PartitionTable::find(
+    const QString &name) const
+{
+    for (const Partition &partition : partitions)
+    {
+        if (partition.name == name)
+            return &partition;
+    }
+
+    return nullptr;
+}
+
+void PartitionTable::clear()
+{
+    partitions.clear();
+}
@@ -0,0 +1,44 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef PARTITION_TABLE_H
+#define PARTITION_TABLE_H
+
+#include <QString>
+#include <vector>
+
+/* MTD partition map of the chip, given as kernel mtdparts string or as
+ * partitions node of device tree source.
+ */
+class PartitionTable
+{
+public:
+    typedef struct
+    {
+        QString name;
+        quint64 offset;
+        quint64 size;
+        bool isReadOnly;
+    } Partition;
+
+private:
+    std::vector<Partition> partitions;
+
+    int parseMtdParts(const QString &text, quint64 chipSize);
+    int parseDts(const QString &text);
+    int check(quint64 chipSize, quint64 blockSize);
+
+public:
+    /* "mtdparts=id:1m(boot),256k@0x100000(env)ro,-(rootfs)" or
+     * "partition@0 { label = "boot"; reg = <0x0 0x100000>; };" nodes.
+     * Partitions must be aligned to erase block.
+     */
+    int parse(const QString &text, quint64 chipSize, quint64 blockSize);
+    const std::vector<Partition> &get() const;
+    const Partition *find(const QString &name) const;
+    void clear();
+};
+
+#endif // PARTITION_TABLE_H
@@ -0,0 +1,372 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "pattern_search.h"
+#include "cpu_features.h"
+#include "image_device.h"
+#include <QDebug>
+#include <cstring>
+#include <deque>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PATTERN_SEARCH_X86
+#endif
+
+/* Returns offset of the first byte equal to any of three bytes */
+typedef size_t (*FindAnyFunc)(const uint8_t *buf, size_t len,
+    const uint8_t *bytes);
+
+static size_t findAnyScalar(const uint8_t *buf, size_t len,
+    const uint8_t *bytes)
+{
+    size_t i = 0;
+
+    for (; i < len; i++)
+    {
+        if (buf[i] == bytes[0] || buf[i] == bytes[1] || buf[i] == bytes[2])
+            break;
+    }
+
+    return i;
+}
+
+#ifdef PATTERN_SEARCH_X86
+__attribute__((target("sse2")))
+static size_t findAnySse2(const uint8_t *buf, size_t len,
+    const uint8_t *bytes)
+{
+    const __m128i a = _mm_set1_epi8(static_cast<char>(bytes[0]));
+    const __m128i b = _mm_set1_epi8(static_cast<char>(bytes[1]));
+    const __m128i c = _mm_set1_epi8(static_cast<char>(bytes[2]));
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i x =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + i));
+        __m128i eq = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, a),
+            _mm_cmpeq_epi8(x, b)), _mm_cmpeq_epi8(x, c));
+        int mask = _mm_movemask_epi8(eq);
+
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+
+    return i + findAnyScalar(buf + i, len - i, bytes);
+}
+
+__attribute__((target("avx2")))
+static size_t findAnyAvx2(const uint8_t *buf, size_t len,
+    const uint8_t *bytes)
+{
+    const __m256i a = _mm256_set1_epi8(static_cast<char>(bytes[0]));
+    const __m256i b = _mm256_set1_epi8(static_cast<char>(bytes[1]));
+    const __m256i c = _mm256_set1_epi8(static_cast<char>(bytes[2]));
+    size_t i = 0;
+
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i x =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(buf + i));
+        __m256i eq = _mm256_or_si256(_mm256_or_si256(
+            _mm256_cmpeq_epi8(x, a), _mm256_cmpeq_epi8(x, b)),
+            _mm256_cmpeq_epi8(x, c));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+
+    return i + findAnyScalar(buf + i, len - i, bytes);
+}
+#endif
+
+struct PatternSearchKernel
+{
+    CpuFeature feature;
+    const char *name;
+    FindAnyFunc findAny;
+};
+
+static const PatternSearchKernel kernels[] =
+{
+#ifdef PATTERN_SEARCH_X86
+    { CPU_FEATURE_AVX2, "AVX2", findAnyAvx2 },
+    { CPU_FEATURE_SSE2, "SSE2", findAnySse2 },
+#endif
+    { CPU_FEATURE_NONE, "scalar", findAnyScalar },
+};
+
+static const PatternSearchKernel &kernel = cpuKernelSelect(kernels);
+
+PatternSearch::PatternSearch()
+{
+    memset(isFirst, 0, sizeof(isFirst));
+    state = 0;
+    scanned = 0;
+}
+
+int PatternSearch::setPatterns(const std::vector<QByteArray> &patterns)
+{
+    std::deque<int32_t> queue;
+    std::vector<int32_t> fail;
+
+    this->patterns.clear();
+    next.assign(256, -1);
+    out.assign(1, std::vector<int>());
+    firstBytes.clear();
+    memset(isFirst, 0, sizeof(isFirst));
+    reset();
+
+    if (patterns.empty())
+        return -1;
+
+    /* Trie of patterns */
+    for (size_t p = 0; p < patterns.size(); p++)
+    {
+        const QByteArray &pattern = patterns[p];
+        int32_t s = 0;
+
+        if (pattern.isEmpty())
+            return -1;
+
+        for (char ch : pattern)
+        {
+            uint8_t c = static_cast<uint8_t>(ch);
+
+            if (next[s * 256 + c] < 0)
+            {
+                next[s * 256 + c] = static_cast<int32_t>(out.size());
+                next.resize(next.size() + 256, -1);
+                out.emplace_back();
+            }
+            s = next[s * 256 + c];
+        }
+        out[s].push_back(static_cast<int>(p));
+
+        uint8_t first = static_cast<uint8_t>(pattern[0]);
+        if (!isFirst[first])
+        {
+            isFirst[first] = true;
+            firstBytes.push_back(first);
+        }
+    }
+    this->patterns = patterns;
+
+    /* Missing transitions are taken from fail state, so scan makes exactly
+     * one table lookup per byte. States are completed in depth order.
+     */
+    fail.assign(out.size(), 0);
+    for (int c = 0; c < 256; c++)
+    {
+        if (next[c] < 0)
+            next[c] = 0;
+        else
+            queue.push_back(next[c]);
+    }
+
+    while (!queue.empty())
+    {
+        int32_t s = queue.front();
+
+        queue.pop_front();
+        for (int c = 0; c < 256; c++)
+        {
+            int32_t t = next[s * 256 + c];
+            int32_t f = next[fail[s] * 256 + c];
+
+            if (t < 0)
+            {
+                next[s * 256 + c] = f;
+                continue;
+            }
+
+            fail[t] = f;
+            out[t].insert(out[t].end(), out[f].begin(), out[f].end());
+            queue.push_back(t);
+        }
+    }
+
+    return 0;
+}
+
+void PatternSearch::reset()
+{
+    state = 0;
+    scanned = 0;
+}
+
+size_t PatternSearch::skip(const uint8_t *buf, size_t len)
+{
+    uint8_t bytes[3];
+    size_t i = 0;
+
+    switch (firstBytes.size())
+    {
+    case 1:
+    {
+        const void *p = memchr(buf, firstBytes[0], len);
+
+        return p ? static_cast<const uint8_t *>(p) - buf : len;
+    }
+    case 2:
+    case 3:
+        bytes[0] = firstBytes[0];
+        bytes[1] = firstBytes[1];
+        bytes[2] = firstBytes[firstBytes.size() - 1];
+        return kernel.findAny(buf, len, bytes);
+    default:
+        while (i < len && !isFirst[buf[i]])
+            i++;
+        return i;
+    }
+}
+
+void PatternSearch::scan(const uint8_t *buf, size_t len,
+    const MatchFunc &match)
+{
+    size_t i = 0;
+
+    if (patterns.empty())
+        return;
+
+    while (i < len)
+    {
+        if (!state)
+        {
+            i += skip(buf + i, len - i);
+            if (i >= len)
+                break;
+        }
+
+        state = next[state * 256 + buf[i]];
+        i++;
+        for (int p : out[state])
+            match(scanned + i - patterns[p].size(), p);
+    }
+
+    scanned += len;
+}
+
+int PatternSearch::parsePattern(const QString &text, bool isHex,
+    QByteArray &pattern)
+{
+    if (!isHex)
+    {
+        pattern = text.toUtf8();
+        return pattern.isEmpty() ? -1 : 0;
+    }
+
+    QByteArray hex = text.simplified().remove(' ').toLatin1();
+    if (hex.startsWith("0x") || hex.startsWith("0X"))
+        hex.remove(0, 2);
+
+    if (hex.isEmpty() || hex.size() % 2)
+        return -1;
+
+    for (char ch : hex)
+    {
+        if (!isxdigit(static_cast<unsigned char>(ch)))
+            return -1;
+    }
+
+    pattern = QByteArray::fromHex(hex);
+
+    return 0;
+}
+
+const char *PatternSearch::kernelName()
+{
+    return kernel.name;
+}
+
+FileSearch::FileSearch(QObject *parent) : QObject(parent)
+{
+    device = nullptr;
+    isStopped = true;
+}
+
+FileSearch::~FileSearch()
+{
+    stop();
+}
+
+int FileSearch::start(const QString &fileName, bool isHolesErased,
+    const std::vector<QByteArray> &patterns)
+{
+    stop();
+
+    if (search.setPatterns(patterns))
+    {
+        qCritical() << "Search pattern is empty";
+        return -1;
+    }
+
+    imageDevice.reset();
+    if (ImageDevice::isContainer(fileName))
+    {
+        imageDevice.reset(ImageDevice::create(fileName));
+        if (!imageDevice)
+            return -1;
+        device = imageDevice.get();
+    }
+    else
+    {
+        file.setFileName(fileName);
+        file.setHolesErased(isHolesErased);
+        device = &file;
+    }
+
+    if (!device->open(QIODevice::ReadOnly))
+    {
+        qCritical() << "Failed to open file:" << fileName << ", error:"
+            << device->errorString();
+        return -1;
+    }
+
+    isStopped = false;
+    thread = std::thread(&FileSearch::worker, this);
+
+    return 0;
+}
+
+void FileSearch::stop()
+{
+    if (!thread.joinable())
+        return;
+
+    isStopped = true;
+    thread.join();
+    device->close();
+}
+
+/* File is read by chunks, so it may be larger than memory */
+void FileSearch::worker()
+{
+    quint64 total = static_cast<quint64>(device->size()), done = 0;
+    quint64 matches = 0;
+    QByteArray buf;
+
+    auto match = [this, &matches](quint64 addr, int pattern)
+    {
+        if (matches++ < matchMax)
+            emit matchFound(addr, pattern);
+    };
+
+    while (!isStopped)
+    {
+        buf = device->read(chunkSize);
+        if (buf.isEmpty())
+            break;
+
+        search.scan(reinterpret_cast<const uint8_t *>(buf.constData()),
+            buf.size(), match);
+        done += buf.size();
+        emit progress(done, total);
+    }
+
+    emit finished(matches, !isStopped && done == total);
+}
@@ -0,0 +1,87 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef PATTERN_SEARCH_H
+#define PATTERN_SEARCH_H
+
+#include "sparse_file.h"
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/* Multi-pattern search by Aho-Corasick automaton. Data is scanned by
+ * chunks, matches crossing chunk boundary are found too. In the root
+ * state bytes which can't start a pattern are skipped by SIMD scan.
+ */
+class PatternSearch
+{
+public:
+    /* Gets address of the first byte of match and pattern index */
+    typedef std::function<void(quint64 addr, int pattern)> MatchFunc;
+
+private:
+    std::vector<QByteArray> patterns;
+    /* Transition of each state by each byte */
+    std::vector<int32_t> next;
+    /* Patterns ending in each state */
+    std::vector<std::vector<int>> out;
+    /* Bytes which start patterns */
+    std::vector<uint8_t> firstBytes;
+    bool isFirst[256];
+    int32_t state;
+    quint64 scanned;
+
+    size_t skip(const uint8_t *buf, size_t len);
+
+public:
+    PatternSearch();
+    /* Returns -1 if there is no or an empty pattern */
+    int setPatterns(const std::vector<QByteArray> &patterns);
+    void reset();
+    void scan(const uint8_t *buf, size_t len, const MatchFunc &match);
+
+    /* Hex pattern may contain spaces, text pattern is UTF-8 */
+    static int parsePattern(const QString &text, bool isHex,
+        QByteArray &pattern);
+    static const char *kernelName();
+};
+
+/* Searches file on a worker thread, results are sent by signals */
+class FileSearch : public QObject
+{
+    Q_OBJECT
+
+    const qint64 chunkSize = 4 << 20;
+    const quint64 matchMax = 100000;
+
+    PatternSearch search;
+    SparseFile file;
+    std::unique_ptr<QIODevice> imageDevice;
+    QIODevice *device;
+    std::thread thread;
+    std::atomic<bool> isStopped;
+
+    void worker();
+
+public:
+    explicit FileSearch(QObject *parent = nullptr);
+    ~FileSearch();
+    int start(const QString &fileName, bool isHolesErased,
+        const std::vector<QByteArray> &patterns);
+    void stop();
+
+signals:
+    void matchFound(quint64 addr, int pattern);
+    void progress(quint64 done, quint64 total);
+    void finished(quint64 matches, bool isCompleted);
+};
+
+#endif // PATTERN_SEARCH_H
@@ -6,6 +6,7 @@
 #include "programmer.h"
 #include <QDebug>
 #include <QTimer>
+#include <cstddef>
 
 #ifdef Q_OS_LINUX
   #define USB_DEV_NAME "/dev/ttyACM0"
@@ -24,11 +25,29 @@ Programmer::Programmer(QObject *parent) : QObject(parent)
     usbDevName = USB_DEV_NAME;
     skipBB = true;
     incSpare = false;
+    eraseOnWrite = false;
+    fsmcEcc = false;
+    chipHal = ChipInfo::CHIP_HAL_PARALLEL;
+    swEcc = false;
+    verifyTolerant = false;
+    sparseFile = false;
+    holesErased = false;
+    spareMode = SPARE_MODE_KEEP;
     isConn = false;
+    regionsBuf = nullptr;
+    regionsLen = 0;
+    regionsPageSize = 0;
+    isRegionsWrite = false;
     QObject::connect(&reader, SIGNAL(log(QtMsgType, QString)), this,
         SLOT(logCb(QtMsgType, QString)));
+    QObject::connect(&reader, SIGNAL(ecc(quint64, quint32)), this,
+        SIGNAL(readChipEcc(quint64, quint32)));
+    QObject::connect(&reader, SIGNAL(badBlock(quint64, bool)), this,
+        SIGNAL(readChipBadBlock(quint64, bool)));
     QObject::connect(&writer, SIGNAL(log(QtMsgType, QString)), this,
         SLOT(logCb(QtMsgType, QString)));
+    QObject::connect(&writer, SIGNAL(badBlock(quint64, bool)), this,
+        SIGNAL(writeChipBadBlock(quint64, bool)));
 }
 
 Programmer::~Programmer()
@@ -146,6 +165,82 @@ void Programmer::setHwEccEnabled(bool isHwEccEnabled)
     enableHwEcc = isHwEccEnabled;
 }
 
+bool Programmer::isEraseOnWrite()
+{
+    return eraseOnWrite;
+}
+
+void Programmer::setEraseOnWrite(bool isEraseOnWrite)
+{
+    eraseOnWrite = isEraseOnWrite;
+}
+
+bool Programmer::isFsmcEcc()
+{
+    return fsmcEcc;
+}
+
+void Programmer::setFsmcEcc(bool isFsmcEcc)
+{
+    fsmcEcc = isFsmcEcc;
+}
+
+/* ECC is calculated by FSMC only for parallel NAND */
+bool Programmer::isChipFsmcEcc()
+{
+    return fsmcEcc && chipHal == ChipInfo::CHIP_HAL_PARALLEL;
+}
+
+bool Programmer::isSwEcc()
+{
+    return swEcc;
+}
+
+void Programmer::setSwEcc(bool isSwEcc)
+{
+    swEcc = isSwEcc;
+}
+
+bool Programmer::isVerifyTolerant()
+{
+    return verifyTolerant;
+}
+
+void Programmer::setVerifyTolerant(bool isVerifyTolerant)
+{
+    verifyTolerant = isVerifyTolerant;
+}
+
+bool Programmer::isSparseFile()
+{
+    return sparseFile;
+}
+
+void Programmer::setSparseFile(bool isSparseFile)
+{
+    sparseFile = isSparseFile;
+}
+
+bool Programmer::isHolesErased()
+{
+    return holesErased;
+}
+
+void Programmer::setHolesErased(bool isHolesErased)
+{
+    holesErased = isHolesErased;
+}
+
+int Programmer::getSpareMode()
+{
+    return spareMode;
+}
+
+void Programmer::setSpareMode(int spareMode)
+{
+    this->spareMode = spareMode;
+}
+
 void Programmer::readChipIdCb(quint64 ret)
 {
     QTimer::singleShot(0, &reader, &Reader::stop);
@@ -179,6 +274,45 @@ void Programmer::readChipId(ChipId *chipId)
     reader.start();
 }
 
+void Programmer::scanChipBlankCb(quint64 ret)
+{
+    QTimer::singleShot(0, &reader, &Reader::stop);
+    QObject::disconnect(&reader, SIGNAL(result(quint64)), this,
+        SLOT(scanChipBlankCb(quint64)));
+
+    if (ret != UINT64_MAX && buffer.buf.size() >= sizeof(*usedLen_p))
+        memcpy(usedLen_p, buffer.buf.data(), sizeof(*usedLen_p));
+    else
+        ret = UINT64_MAX;
+
+    emit scanChipBlankCompleted(ret);
+}
+
+void Programmer::scanChipBlank(quint64 addr, quint64 len, quint64 *usedLen)
+{
+    BlankScanCmd scanCmd;
+
+    QObject::connect(&reader, SIGNAL(result(quint64)), this,
+        SLOT(scanChipBlankCb(quint64)));
+
+    scanCmd.cmd.code = CMD_NAND_BLANK_SCAN;
+    scanCmd.addr = addr;
+    scanCmd.len = len;
+
+    writeData.clear();
+    writeData.append(reinterpret_cast<const char *>(&scanCmd),
+        sizeof(scanCmd));
+
+    usedLen_p = usedLen;
+
+    buffer.buf.clear();
+    reader.init(usbDevName, SERIAL_PORT_SPEED,
+        &buffer, sizeof(*usedLen),
+        reinterpret_cast<const uint8_t *>(writeData.constData()),
+        static_cast<uint32_t>(writeData.size()), false, false);
+    reader.start();
+}
+
 void Programmer::eraseChipCb(quint64 ret)
 {
     QTimer::singleShot(0, &reader, &Reader::stop);
@@ -233,8 +367,9 @@ void Programmer::readProgressCb(quint64 progress)
     emit readChipProgress(progress);
 }
 
-void Programmer::readChip(SyncBuffer *buf, quint64 addr, quint64 len,
-    bool isReadLess)
+void Programmer::readChipCmd(SyncBuffer *buf, uint8_t code, quint64 addr,
+    quint64 len, quint64 rlen, bool isReadLess, bool isSkipBB, bool isIncSpare,
+    bool isFsmcEcc, bool isRegions)
 {
     ReadCmd readCmd;
 
@@ -243,21 +378,45 @@ void Programmer::readChip(SyncBuffer *buf, quint64 addr, quint64 len,
     QObject::connect(&reader, SIGNAL(progress(quint64)), this,
         SLOT(readProgressCb(quint64)));
 
-    readCmd.cmd.code = CMD_NAND_READ;
+    readCmd.cmd.code = code;
     readCmd.addr = addr;
     readCmd.len = len;
-    readCmd.flags.skipBB = skipBB;
-    readCmd.flags.incSpare = incSpare;
+    readCmd.flags.skipBB = isSkipBB;
+    readCmd.flags.incSpare = isIncSpare;
+    readCmd.flags.fsmcEcc = isFsmcEcc;
+    readCmd.flags.regions = isRegions;
 
     writeData.clear();
     writeData.append(reinterpret_cast<const char *>(&readCmd), sizeof(readCmd));
-    reader.init(usbDevName, SERIAL_PORT_SPEED, buf, len,
+    reader.init(usbDevName, SERIAL_PORT_SPEED, buf, rlen,
         reinterpret_cast<const uint8_t *>(writeData.constData()),
-        static_cast<uint32_t>(writeData.size()), skipBB,
+        static_cast<uint32_t>(writeData.size()), isSkipBB,
         isReadLess);
     reader.start();
 }
 
+void Programmer::readChip(SyncBuffer *buf, quint64 addr, quint64 len,
+    bool isReadLess)
+{
+    readChipCmd(buf, CMD_NAND_READ, addr, len, len, isReadLess, skipBB,
+        incSpare, isChipFsmcEcc(), false);
+}
+
+/* Page data only, bad blocks are not skipped, so data is at its address */
+void Programmer::readChipPages(SyncBuffer *buf, quint64 addr, quint64 len)
+{
+    readChipCmd(buf, CMD_NAND_READ, addr, len, len, false, false, false,
+        false, false);
+}
+
+/* Spare area of pages in data range addr..addr+len, spareLen bytes in total */
+void Programmer::readChipSpare(SyncBuffer *buf, quint64 addr, quint64 len,
+    quint64 spareLen)
+{
+    readChipCmd(buf, CMD_NAND_READ_SPARE, addr, len, spareLen, false, false,
+        false, false, false);
+}
+
 void Programmer::writeCb(int ret)
 {
     QTimer::singleShot(0, &writer, &Writer::stop);
@@ -273,18 +432,105 @@ void Programmer::writeProgressCb(quint64 progress)
 }
 
 void Programmer::writeChip(SyncBuffer *buf, quint64 addr, quint64 len,
-    uint32_t pageSize)
+    uint32_t pageSize, bool isSkipErased, bool isMultiPlane)
 {
     QObject::connect(&writer, SIGNAL(result(int)), this, SLOT(writeCb(int)));
     QObject::connect(&writer, SIGNAL(progress(quint64)), this,
         SLOT(writeProgressCb(quint64)));
 
     writer.init(usbDevName, SERIAL_PORT_SPEED, buf, addr, len, pageSize,
-        skipBB, incSpare, enableHwEcc, CMD_NAND_WRITE_S, CMD_NAND_WRITE_D,
+        skipBB, incSpare, enableHwEcc, eraseOnWrite, isChipFsmcEcc(), false,
+        isMultiPlane, isSkipErased, CMD_NAND_WRITE_S, CMD_NAND_WRITE_D,
         CMD_NAND_WRITE_E);
     writer.start();
 }
 
+void Programmer::regionsCb(quint64 ret)
+{
+    QTimer::singleShot(0, &reader, &Reader::stop);
+    QObject::disconnect(&reader, SIGNAL(result(quint64)), this,
+        SLOT(regionsCb(quint64)));
+
+    if (ret == UINT64_MAX)
+    {
+        if (isRegionsWrite)
+            emit writeChipCompleted(-1);
+        else
+            emit readChipCompleted(ret);
+        return;
+    }
+
+    /* Port is reopened after previous command is stopped */
+    QTimer::singleShot(50, this, &Programmer::regionsStart);
+}
+
+void Programmer::regionsStart()
+{
+    if (!isRegionsWrite)
+    {
+        readChipCmd(regionsBuf, CMD_NAND_READ, 0, regionsLen, regionsLen,
+            false, skipBB, incSpare, isChipFsmcEcc(), true);
+        return;
+    }
+
+    QObject::connect(&writer, SIGNAL(result(int)), this, SLOT(writeCb(int)));
+    QObject::connect(&writer, SIGNAL(progress(quint64)), this,
+        SLOT(writeProgressCb(quint64)));
+
+    writer.init(usbDevName, SERIAL_PORT_SPEED, regionsBuf, 0, regionsLen,
+        regionsPageSize, skipBB, incSpare, enableHwEcc, eraseOnWrite,
+        isChipFsmcEcc(), true, false, false, CMD_NAND_WRITE_S,
+        CMD_NAND_WRITE_D, CMD_NAND_WRITE_E);
+    writer.start();
+}
+
+void Programmer::setRegions(const RegionList &regions)
+{
+    RegionsCmd regionsCmd;
+    const std::vector<RegionList::Region> &list = regions.get();
+
+    regionsCmd.cmd.code = CMD_NAND_REGIONS;
+    regionsCmd.count = static_cast<uint8_t>(list.size());
+    for (size_t i = 0; i < list.size(); i++)
+    {
+        regionsCmd.region[i].block = list[i].block;
+        regionsCmd.region[i].blocks = list[i].blocks;
+    }
+
+    QObject::connect(&reader, SIGNAL(result(quint64)), this,
+        SLOT(regionsCb(quint64)));
+
+    writeData.clear();
+    writeData.append(reinterpret_cast<const char *>(&regionsCmd),
+        offsetof(RegionsCmd, region) + list.size() * sizeof(CmdRegion));
+    reader.init(usbDevName, SERIAL_PORT_SPEED, nullptr, 0,
+        reinterpret_cast<const uint8_t *>(writeData.constData()),
+        static_cast<uint32_t>(writeData.size()), false, false);
+    reader.start();
+}
+
+/* Regions are read back to back by one command, bad blocks are skipped
+ * inside of each region and are not counted in its length.
+ */
+void Programmer::readChipRegions(SyncBuffer *buf, const RegionList &regions,
+    quint64 len)
+{
+    regionsBuf = buf;
+    regionsLen = len;
+    isRegionsWrite = false;
+    setRegions(regions);
+}
+
+void Programmer::writeChipRegions(SyncBuffer *buf, const RegionList &regions,
+    quint64 len, uint32_t pageSize)
+{
+    regionsBuf = buf;
+    regionsLen = len;
+    regionsPageSize = pageSize;
+    isRegionsWrite = true;
+    setRegions(regions);
+}
+
 void Programmer::readChipBadBlocksCb(quint64 ret)
 {
     QTimer::singleShot(0, &reader, &Reader::stop);
@@ -333,6 +579,7 @@ void Programmer::confChip(ChipInfo *chipInfo)
 
     confCmd.cmd.code = CMD_NAND_CONF;
     confCmd.hal = chipInfo->getHal();
+    chipHal = confCmd.hal;
     confCmd.pageSize = chipInfo->getPageSize();
     confCmd.blockSize = chipInfo->getBlockSize();
     confCmd.totalSize = chipInfo->getTotalSize();
@@ -481,8 +728,8 @@ void Programmer::firmwareUpdateStart()
     writer.init(usbDevName, SERIAL_PORT_SPEED,
         &buffer,
         firmwareImage[updateImage].address, firmwareImage[updateImage].size,
-        flashPageSize, 0, 0, 0, CMD_FW_UPDATE_S, CMD_FW_UPDATE_D,
-        CMD_FW_UPDATE_E);
+        flashPageSize, 0, 0, 0, 0, 0, 0, 0, 0, CMD_FW_UPDATE_S,
+        CMD_FW_UPDATE_D, CMD_FW_UPDATE_E);
     writer.start();
 }
 
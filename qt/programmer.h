@@ -12,6 +12,7 @@
 #include "writer.h"
 #include "reader.h"
 #include "cmd.h"
+#include "region_list.h"
 #include "parallel_chip_db.h"
 #include "spi_chip_db.h"
 #include "serial_port.h"
@@ -52,6 +53,14 @@ class Programmer : public QObject
     bool skipBB;
     bool incSpare;
     bool enableHwEcc;
+    bool eraseOnWrite;
+    bool fsmcEcc;
+    uint8_t chipHal;
+    bool swEcc;
+    bool verifyTolerant;
+    bool sparseFile;
+    bool holesErased;
+    int spareMode;
     FwVersion fwVersion;
     uint8_t activeImage;
     uint8_t updateImage;
@@ -59,13 +68,32 @@ class Programmer : public QObject
     QByteArray firmwareBuffer;
     SyncBuffer buffer;
     ChipId *chipId_p;
+    quint64 *usedLen_p;
+    /* Read or write started after region list is set */
+    SyncBuffer *regionsBuf;
+    quint64 regionsLen;
+    uint32_t regionsPageSize;
+    bool isRegionsWrite;
 
     int serialPortConnect();
     void serialPortDisconnect();
     int firmwareImageRead();
     void firmwareUpdateStart();
+    void readChipCmd(SyncBuffer *buf, uint8_t code, quint64 addr, quint64 len,
+        quint64 rlen, bool isReadLess, bool isSkipBB, bool isIncSpare,
+        bool isFsmcEcc, bool isRegions);
+    void setRegions(const RegionList &regions);
+    void regionsStart();
 
 public:
+    /* Handling of spare area read with page data */
+    enum
+    {
+        SPARE_MODE_KEEP    = 0,
+        SPARE_MODE_SPLIT   = 1,
+        SPARE_MODE_DISCARD = 2,
+    };
+
     QByteArray writeData;
 
     explicit Programmer(QObject *parent = nullptr);
@@ -81,11 +109,38 @@ public:
     void setIncSpare(bool incSpare);
     bool isHwEccEnabled();
     void setHwEccEnabled(bool isHwEccEnabled);
+    bool isEraseOnWrite();
+    void setEraseOnWrite(bool isEraseOnWrite);
+    bool isFsmcEcc();
+    void setFsmcEcc(bool isFsmcEcc);
+    bool isChipFsmcEcc();
+    bool isSwEcc();
+    void setSwEcc(bool isSwEcc);
+    bool isVerifyTolerant();
+    void setVerifyTolerant(bool isVerifyTolerant);
+    bool isSparseFile();
+    void setSparseFile(bool isSparseFile);
+    bool isHolesErased();
+    void setHolesErased(bool isHolesErased);
+    int getSpareMode();
+    void setSpareMode(int spareMode);
     void readChipId(ChipId *chipId);
+    /* Length of range up to the last block with programmed first page */
+    void scanChipBlank(quint64 addr, quint64 len, quint64 *usedLen);
     void eraseChip(quint64 addr, quint64 len);
     void readChip(SyncBuffer *buf, quint64 addr, quint64 len, bool isReadLess);
+    void readChipPages(SyncBuffer *buf, quint64 addr, quint64 len);
+    void readChipSpare(SyncBuffer *buf, quint64 addr, quint64 len,
+        quint64 spareLen);
+    /* Erased pages are skipped instead of programmed if isSkipErased, same
+     * pages of block pairs are interleaved in buffer if isMultiPlane.
+     */
     void writeChip(SyncBuffer *buf, quint64 addr, quint64 len,
-        uint32_t pageSize);
+        uint32_t pageSize, bool isSkipErased, bool isMultiPlane);
+    void readChipRegions(SyncBuffer *buf, const RegionList &regions,
+        quint64 len);
+    void writeChipRegions(SyncBuffer *buf, const RegionList &regions,
+        quint64 len, uint32_t pageSize);
     void readChipBadBlocks();
     void confChip(ChipInfo *chipInfo);
     void detectChip();
@@ -95,10 +150,14 @@ public:
 signals:
     void connectCompleted(quint64 ret);
     void readChipIdCompleted(quint64 ret);
+    void scanChipBlankCompleted(quint64 ret);
     void writeChipCompleted(int ret);
     void writeChipProgress(quint64 progress);
+    void writeChipBadBlock(quint64 addr, bool isSkipped);
     void readChipCompleted(quint64 ret);
     void readChipProgress(quint64 ret);
+    void readChipEcc(quint64 addr, quint32 ecc);
+    void readChipBadBlock(quint64 addr, bool isSkipped);
     void eraseChipCompleted(quint64 ret);
     void eraseChipProgress(quint64 progress);
     void readChipBadBlocksProgress(quint64 progress);
@@ -109,10 +168,12 @@ signals:
 
 private slots:
     void readChipIdCb(quint64 ret);
+    void scanChipBlankCb(quint64 ret);
     void writeCb(int ret);
     void writeProgressCb(quint64 progress);
     void readCb(quint64 ret);
     void readProgressCb(quint64 progress);
+    void regionsCb(quint64 ret);
     void eraseChipCb(quint64 ret);
     void eraseProgressChipCb(quint64 progress);
     void readChipBadBlocksCb(quint64 ret);
@@ -45,7 +45,33 @@ SOURCES += main.cpp\
     err.cpp \
     about_dialog.cpp \
     firmware_update_dialog.cpp \
-    clickcombobox.cpp
+    clickcombobox.cpp \
+    ecc.cpp \
+    ecc_engine.cpp \
+    ecc_decoder.cpp \
+    ecc_encoder.cpp \
+    ecc_corrector.cpp \
+    verifier.cpp \
+    crc32c.cpp \
+    cpu_features.cpp \
+    dump_file.cpp \
+    read_sink.cpp \
+    sparse_file.cpp \
+    image_source.cpp \
+    compress_pool.cpp \
+    zstd_seekable.cpp \
+    image_device.cpp \
+    page_cache.cpp \
+    pattern_search.cpp \
+    search_dialog.cpp \
+    dump_diff.cpp \
+    diff_dialog.cpp \
+    chip_cache.cpp \
+    region_list.cpp \
+    partition_table.cpp \
+    ubi_image.cpp \
+    bb_map.cpp \
+    majority_vote.cpp
 
 HEADERS += main_window.h \
     chip_db.h \
@@ -72,27 +98,63 @@ HEADERS += main_window.h \
     version.h \
     firmware_update_dialog.h \
     settings.h \
-    clickcombobox.h
+    clickcombobox.h \
+    ecc.h \
+    ecc_engine.h \
+    ecc_decoder.h \
+    ecc_encoder.h \
+    ecc_corrector.h \
+    verifier.h \
+    crc32c.h \
+    cpu_features.h \
+    dump_file.h \
+    read_sink.h \
+    sparse_file.h \
+    image_source.h \
+    compress_pool.h \
+    zstd_seekable.h \
+    image_device.h \
+    page_cache.h \
+    pattern_search.h \
+    search_dialog.h \
+    dump_diff.h \
+    diff_dialog.h \
+    chip_cache.h \
+    region_list.h \
+    partition_table.h \
+    ubi_image.h \
+    bb_map.h \
+    majority_vote.h
 
 FORMS += main_window.ui \
     parallel_chip_db_dialog.ui \
     settings_programmer_dialog.ui \
     about_dialog.ui \
     firmware_update_dialog.ui \
-    spi_chip_db_dialog.ui
+    spi_chip_db_dialog.ui \
+    search_dialog.ui \
+    diff_dialog.ui
 
 QMAKE_CXXFLAGS += -std=c++11 -Wextra -Werror
 mingw:QMAKE_CXXFLAGS += -mno-ms-bitfields
 
 unix: {
+    # 64-bit lseek() offsets of sparse dumps on 32-bit hosts
+    DEFINES += _FILE_OFFSET_BITS=64
     # use static linking for boost to avoid version dependency issues
     LIBS += -Wl,-Bstatic -lboost_system -lboost_thread -Wl,-Bdynamic
+    LIBS += -lz -llzma
+    # zstd images are supported if library is installed
+    packagesExist(libzstd) {
+        DEFINES += HAVE_ZSTD
+        LIBS += -lzstd
+    }
 }
 
 win32: {
     INCLUDEPATH += C:/boost/include/boost-1_75
     LIBS += -LC:/boost/lib -lws2_32 -lboost_system-mgw8-mt-x64-1_75 \
-      -lboost_thread-mgw8-mt-x64-1_75
+      -lboost_thread-mgw8-mt-x64-1_75 -lz -llzma
 }
 
 DISTFILES += \
@@ -0,0 +1,642 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "read_sink.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QStorageInfo>
+#include <cstring>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#define DUMP_FILE_SUFFIX ".nnd"
+#define ZSTD_FILE_SUFFIX ".zst"
+
+ReadSink::~ReadSink()
+{
+}
+
+void ReadSink::badBlock(quint64 addr, bool isSkipped)
+{
+    (void)addr;
+    (void)isSkipped;
+}
+
+/* Sink is selected by file name suffix */
+ReadSink *ReadSink::create(const QString &fileName, bool isSparse)
+{
+    if (fileName.endsWith(DUMP_FILE_SUFFIX, Qt::CaseInsensitive))
+        return new DumpSink();
+
+    if (fileName.endsWith(ZSTD_FILE_SUFFIX, Qt::CaseInsensitive))
+    {
+#ifdef HAVE_ZSTD
+        return new ZstdSink();
+#else
+        qCritical() << "Zstd support is not built in";
+        return nullptr;
+#endif
+    }
+
+    if (isSparse)
+    {
+        if (SparseFile::isSupported())
+            return new SparseFileSink();
+        qInfo() << "Sparse files are not supported, raw file is used";
+    }
+
+    return new RawFileSink();
+}
+
+int RawFileSink::open(const QString &fileName, const DumpInfo &info)
+{
+    (void)info;
+
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qCritical() << "Failed to open file:" << fileName << ", error:"
+            << file.errorString();
+        return -1;
+    }
+
+    return 0;
+}
+
+int RawFileSink::write(const uint8_t *buf, size_t len)
+{
+    if (file.write(reinterpret_cast<const char *>(buf),
+        static_cast<qint64>(len)) != static_cast<qint64>(len))
+    {
+        qCritical() << "Failed to write file:" << file.errorString();
+        return -1;
+    }
+
+    return 0;
+}
+
+int RawFileSink::close()
+{
+    file.close();
+
+    return 0;
+}
+
+quint64 RawFileSink::size()
+{
+    return static_cast<quint64>(file.size());
+}
+
+int SparseFileSink::open(const QString &fileName, const DumpInfo &info)
+{
+    QStorageInfo storage(QFileInfo(fileName).absolutePath());
+    qint64 storageBlockSize = storage.blockSize();
+
+    fsBlockSize = storageBlockSize > 0 ? storageBlockSize : 4096;
+    pageSize = info.pageSize ? info.pageSize : fsBlockSize;
+    page.clear();
+    erasedBuf.assign(fsBlockSize, 0xFF);
+    written = 0;
+    erasedStart = 0;
+    isErasedRun = false;
+
+    /* Truncated file has no data, so skipped ranges become holes */
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qCritical() << "Failed to open file:" << fileName << ", error:"
+            << file.errorString();
+        return -1;
+    }
+
+    return 0;
+}
+
+int SparseFileSink::writeErased(quint64 len)
+{
+    while (len)
+    {
+        qint64 chunk = static_cast<qint64>(std::min<quint64>(len,
+            erasedBuf.size()));
+
+        if (file.write(reinterpret_cast<const char *>(erasedBuf.data()),
+            chunk) != chunk)
+        {
+            qCritical() << "Failed to write file:" << file.errorString();
+            return -1;
+        }
+        len -= chunk;
+    }
+
+    return 0;
+}
+
+/* Edges of erased run which share file system block with data are written,
+ * the rest is skipped
+ */
+int SparseFileSink::flushErased()
+{
+    quint64 holeStart, holeEnd;
+
+    if (!isErasedRun)
+        return 0;
+    isErasedRun = false;
+
+    holeStart = (erasedStart + fsBlockSize - 1) / fsBlockSize * fsBlockSize;
+    holeEnd = written / fsBlockSize * fsBlockSize;
+    if (holeStart >= holeEnd)
+        return writeErased(written - erasedStart);
+
+    if (writeErased(holeStart - erasedStart))
+        return -1;
+
+    if (!file.seek(static_cast<qint64>(holeEnd)))
+    {
+        qCritical() << "Failed to seek file:" << file.errorString();
+        return -1;
+    }
+
+    return writeErased(written - holeEnd);
+}
+
+int SparseFileSink::writePage(const uint8_t *buf, size_t len)
+{
+    if (SparseFile::isErased(buf, len))
+    {
+        if (!isErasedRun)
+        {
+            erasedStart = written;
+            isErasedRun = true;
+        }
+        written += len;
+        return 0;
+    }
+
+    if (flushErased())
+        return -1;
+
+    if (file.write(reinterpret_cast<const char *>(buf),
+        static_cast<qint64>(len)) != static_cast<qint64>(len))
+    {
+        qCritical() << "Failed to write file:" << file.errorString();
+        return -1;
+    }
+    written += len;
+
+    return 0;
+}
+
+int SparseFileSink::write(const uint8_t *buf, size_t len)
+{
+    size_t off = 0;
+
+    /* Complete partial page first, then whole pages directly from buffer */
+    if (!page.empty())
+    {
+        size_t chunk = std::min<size_t>(len, pageSize - page.size());
+
+        page.insert(page.end(), buf, buf + chunk);
+        off = chunk;
+        if (page.size() < pageSize)
+            return 0;
+
+        if (writePage(page.data(), page.size()))
+            return -1;
+        page.clear();
+    }
+
+    for (; off + pageSize <= len; off += pageSize)
+    {
+        if (writePage(buf + off, pageSize))
+            return -1;
+    }
+
+    page.insert(page.end(), buf + off, buf + len);
+
+    return 0;
+}
+
+int SparseFileSink::close()
+{
+    int ret = 0;
+
+    if (!page.empty())
+    {
+        ret = writePage(page.data(), page.size());
+        page.clear();
+    }
+
+    /* Erased tail is a hole up to the end of file */
+    if (!ret && isErasedRun)
+    {
+        if (written - erasedStart >= fsBlockSize)
+        {
+            ret = writeErased((erasedStart + fsBlockSize - 1) / fsBlockSize *
+                fsBlockSize - erasedStart);
+            isErasedRun = false;
+        }
+        else
+            ret = flushErased();
+    }
+
+    if (!ret && !file.resize(static_cast<qint64>(written)))
+    {
+        qCritical() << "Failed to resize file:" << file.errorString();
+        ret = -1;
+    }
+    file.close();
+
+    return ret;
+}
+
+quint64 SparseFileSink::size()
+{
+    return written;
+}
+
+DeinterleaveSink::DeinterleaveSink(ReadSink *dataSink, bool isOobSaved) :
+    dataSink(dataSink)
+{
+    this->isOobSaved = isOobSaved;
+    pageSize = 0;
+    spareSize = 0;
+    rawBlockSize = 0;
+    dataBlockSize = 0;
+    written = 0;
+}
+
+int DeinterleaveSink::open(const QString &fileName, const DumpInfo &info)
+{
+    DumpInfo dataInfo = info;
+
+    if (!info.incSpare || !info.spareSize || info.pageSize <= info.spareSize)
+    {
+        qCritical() << "Spare area is not included in read data";
+        return -1;
+    }
+
+    spareSize = info.spareSize;
+    pageSize = info.pageSize - spareSize;
+    rawBlockSize = info.blockSize;
+    dataBlockSize = info.blockSize / info.pageSize * pageSize;
+    page.clear();
+    written = 0;
+
+    dataInfo.incSpare = false;
+    dataInfo.pageSize = pageSize;
+    dataInfo.blockSize = dataBlockSize;
+    if (dataSink->open(fileName, dataInfo))
+        return -1;
+
+    if (!isOobSaved)
+        return 0;
+
+    oobFile.setFileName(fileName + ".oob");
+    if (!oobFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qCritical() << "Failed to open file:" << oobFile.fileName()
+            << ", error:" << oobFile.errorString();
+        dataSink->close();
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Data and spare of all pages are gathered to contiguous buffers, so each
+ * output gets one write per batch
+ */
+int DeinterleaveSink::writePages(const uint8_t *buf, size_t pages)
+{
+    uint32_t rawPageSize = pageSize + spareSize;
+
+    dataBuf.resize(pages * pageSize);
+    oobBuf.resize(pages * spareSize);
+    for (size_t i = 0; i < pages; i++)
+    {
+        const uint8_t *src = buf + i * rawPageSize;
+
+        memcpy(dataBuf.data() + i * pageSize, src, pageSize);
+        memcpy(oobBuf.data() + i * spareSize, src + pageSize, spareSize);
+    }
+
+    if (dataSink->write(dataBuf.data(), dataBuf.size()))
+        return -1;
+
+    if (isOobSaved && oobFile.write(reinterpret_cast<const char *>(
+        oobBuf.data()), oobBuf.size()) != static_cast<qint64>(oobBuf.size()))
+    {
+        qCritical() << "Failed to write file:" << oobFile.errorString();
+        return -1;
+    }
+
+    return 0;
+}
+
+int DeinterleaveSink::write(const uint8_t *buf, size_t len)
+{
+    uint32_t rawPageSize = pageSize + spareSize;
+    size_t off = 0;
+
+    written += len;
+
+    if (!page.empty())
+    {
+        size_t chunk = std::min<size_t>(len, rawPageSize - page.size());
+
+        page.insert(page.end(), buf, buf + chunk);
+        off = chunk;
+        if (page.size() < rawPageSize)
+            return 0;
+
+        if (writePages(page.data(), 1))
+            return -1;
+        page.clear();
+    }
+
+    size_t pages = (len - off) / rawPageSize;
+    if (pages && writePages(buf + off, pages))
+        return -1;
+    off += pages * rawPageSize;
+
+    page.insert(page.end(), buf + off, buf + len);
+
+    return 0;
+}
+
+/* Bad block address is converted to data-only address space */
+void DeinterleaveSink::badBlock(quint64 addr, bool isSkipped)
+{
+    dataSink->badBlock(addr / rawBlockSize * dataBlockSize, isSkipped);
+}
+
+int DeinterleaveSink::close()
+{
+    int ret = 0;
+
+    /* Incomplete page is not expected, it is saved as data */
+    if (!page.empty())
+    {
+        ret = dataSink->write(page.data(), page.size());
+        page.clear();
+    }
+
+    if (dataSink->close())
+        ret = -1;
+    oobFile.close();
+
+    return ret;
+}
+
+quint64 DeinterleaveSink::size()
+{
+    return written;
+}
+
+RegionSink::RegionSink(const RegionList &regions, quint64 blockSize) :
+    regions(regions)
+{
+    this->blockSize = blockSize;
+    written = 0;
+}
+
+int RegionSink::open(const QString &fileName, const DumpInfo &info)
+{
+    (void)fileName;
+    (void)info;
+
+    written = 0;
+
+    return file.open(regions, blockSize, true);
+}
+
+int RegionSink::write(const uint8_t *buf, size_t len)
+{
+    if (file.write(buf, len))
+        return -1;
+    written += len;
+
+    return 0;
+}
+
+int RegionSink::close()
+{
+    file.close();
+
+    return 0;
+}
+
+quint64 RegionSink::size()
+{
+    return written;
+}
+
+int DumpSink::open(const QString &fileName, const DumpInfo &info)
+{
+    if (!info.blockSize)
+        return -1;
+
+    this->info = info;
+    block.clear();
+    skippedBlocks.clear();
+    nextBlock = info.startBlock;
+    written = 0;
+
+    if (dump.create(fileName, info))
+        return -1;
+
+    return pool.start([](CompressPool::Chunk &chunk)
+    {
+        DumpFile::packBlock(chunk.data.data(),
+            static_cast<uint32_t>(chunk.data.size()), chunk.packed,
+            chunk.flags, chunk.crc);
+        return 0;
+    },
+    [this](CompressPool::Chunk &chunk)
+    {
+        return dump.writePackedBlock(chunk.data.data(),
+            static_cast<uint32_t>(chunk.data.size()), chunk.packed,
+            chunk.flags, chunk.crc);
+    });
+}
+
+/* Skipped bad blocks have no data, only an index entry */
+void DumpSink::submitSkipped()
+{
+    std::vector<uint8_t> empty;
+
+    while (skippedBlocks.count(nextBlock))
+    {
+        pool.submit(empty, DumpFile::BLOCK_SKIPPED);
+        dump.addBadBlock(nextBlock++);
+    }
+}
+
+int DumpSink::write(const uint8_t *buf, size_t len)
+{
+    size_t off = 0;
+
+    written += len;
+
+    while (off < len)
+    {
+        size_t chunk = std::min<size_t>(len - off,
+            info.blockSize - block.size());
+
+        block.insert(block.end(), buf + off, buf + off + chunk);
+        off += chunk;
+
+        if (block.size() < info.blockSize)
+            break;
+
+        submitSkipped();
+        pool.submit(block, 0);
+        block.clear();
+        nextBlock++;
+    }
+
+    return 0;
+}
+
+void DumpSink::badBlock(quint64 addr, bool isSkipped)
+{
+    quint64 blockNum = addr / info.blockSize;
+
+    if (isSkipped)
+        skippedBlocks.insert(blockNum);
+    else
+        dump.addBadBlock(blockNum);
+}
+
+int DumpSink::close()
+{
+    int ret;
+
+    if (!block.empty())
+    {
+        submitSkipped();
+        pool.submit(block, 0);
+        block.clear();
+    }
+    submitSkipped();
+
+    ret = pool.finish();
+
+    return dump.close() || ret ? -1 : 0;
+}
+
+quint64 DumpSink::size()
+{
+    return written;
+}
+
+#ifdef HAVE_ZSTD
+int ZstdSink::open(const QString &fileName, const DumpInfo &info)
+{
+    frameSize = info.blockSize ? static_cast<uint32_t>(info.blockSize) :
+        defaultFrameSize;
+    frame.clear();
+    seekTable.clear();
+    written = 0;
+
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qCritical() << "Failed to open file:" << fileName << ", error:"
+            << file.errorString();
+        return -1;
+    }
+
+    return pool.start([this](CompressPool::Chunk &chunk)
+    {
+        size_t ret;
+
+        chunk.packed.resize(ZSTD_compressBound(chunk.data.size()));
+        ret = ZSTD_compress(chunk.packed.data(), chunk.packed.size(),
+            chunk.data.data(), chunk.data.size(), compressLevel);
+        if (ZSTD_isError(ret))
+            return -1;
+        chunk.packed.resize(ret);
+
+        return 0;
+    },
+    [this](CompressPool::Chunk &chunk)
+    {
+        ZstdSeekTable::Entry entry =
+        {
+            static_cast<uint32_t>(chunk.packed.size()),
+            static_cast<uint32_t>(chunk.data.size())
+        };
+
+        qint64 len = static_cast<qint64>(entry.compressedSize);
+
+        if (file.write(reinterpret_cast<const char *>(chunk.packed.data()),
+            len) != len)
+        {
+            return -1;
+        }
+        seekTable.push_back(entry);
+
+        return 0;
+    });
+}
+
+int ZstdSink::write(const uint8_t *buf, size_t len)
+{
+    size_t off = 0;
+
+    written += len;
+
+    while (off < len)
+    {
+        size_t chunk = std::min<size_t>(len - off, frameSize - frame.size());
+
+        frame.insert(frame.end(), buf + off, buf + off + chunk);
+        off += chunk;
+
+        if (frame.size() < frameSize)
+            break;
+
+        pool.submit(frame, 0);
+        frame.clear();
+    }
+
+    return 0;
+}
+
+int ZstdSink::close()
+{
+    int ret;
+
+    if (!frame.empty())
+    {
+        pool.submit(frame, 0);
+        frame.clear();
+    }
+
+    ret = pool.finish();
+    if (ret)
+        qCritical() << "Failed to compress file:" << file.errorString();
+    else
+    {
+        QByteArray table = ZstdSeekTable::build(seekTable);
+
+        if (file.write(table) != table.size())
+        {
+            qCritical() << "Failed to write file:" << file.errorString();
+            ret = -1;
+        }
+    }
+    file.close();
+
+    return ret;
+}
+
+quint64 ZstdSink::size()
+{
+    return written;
+}
+#endif
@@ -0,0 +1,162 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef READ_SINK_H
+#define READ_SINK_H
+
+#include "compress_pool.h"
+#include "dump_file.h"
+#include "region_list.h"
+#include "sparse_file.h"
+#include "zstd_seekable.h"
+#include <QFile>
+#include <QString>
+#include <memory>
+#include <set>
+#include <vector>
+
+/* Destination of data read from chip */
+class ReadSink
+{
+public:
+    virtual ~ReadSink();
+    virtual int open(const QString &fileName, const DumpInfo &info) = 0;
+    virtual int write(const uint8_t *buf, size_t len) = 0;
+    virtual void badBlock(quint64 addr, bool isSkipped);
+    virtual int close() = 0;
+    /* Bytes of read data written to sink */
+    virtual quint64 size() = 0;
+
+    /* Returns nullptr if file format is not supported */
+    static ReadSink *create(const QString &fileName, bool isSparse);
+};
+
+class RawFileSink : public ReadSink
+{
+    QFile file;
+
+public:
+    int open(const QString &fileName, const DumpInfo &info) override;
+    int write(const uint8_t *buf, size_t len) override;
+    int close() override;
+    quint64 size() override;
+};
+
+/* Raw file where erased pages are left as holes. Only file system blocks
+ * fully covered by erased pages become holes, so holes are always erased
+ * data.
+ */
+class SparseFileSink : public ReadSink
+{
+    QFile file;
+    uint32_t pageSize;
+    quint64 fsBlockSize;
+    std::vector<uint8_t> page;
+    std::vector<uint8_t> erasedBuf;
+    quint64 written;
+    quint64 erasedStart;
+    bool isErasedRun;
+
+    int writeErased(quint64 len);
+    int flushErased();
+    int writePage(const uint8_t *buf, size_t len);
+
+public:
+    int open(const QString &fileName, const DumpInfo &info) override;
+    int write(const uint8_t *buf, size_t len) override;
+    int close() override;
+    quint64 size() override;
+};
+
+/* Splits pages read with spare area: page data goes to data sink, spare
+ * area to <fileName>.oob or nowhere. Data sink gets data-only layout.
+ */
+class DeinterleaveSink : public ReadSink
+{
+    std::unique_ptr<ReadSink> dataSink;
+    QFile oobFile;
+    bool isOobSaved;
+    uint32_t pageSize;
+    uint32_t spareSize;
+    quint64 rawBlockSize;
+    quint64 dataBlockSize;
+    std::vector<uint8_t> page;
+    std::vector<uint8_t> dataBuf;
+    std::vector<uint8_t> oobBuf;
+    quint64 written;
+
+    int writePages(const uint8_t *buf, size_t pages);
+
+public:
+    DeinterleaveSink(ReadSink *dataSink, bool isOobSaved);
+    int open(const QString &fileName, const DumpInfo &info) override;
+    int write(const uint8_t *buf, size_t len) override;
+    void badBlock(quint64 addr, bool isSkipped) override;
+    int close() override;
+    quint64 size() override;
+};
+
+/* Data of region list read, file name of open() is not used */
+class RegionSink : public ReadSink
+{
+    RegionList regions;
+    quint64 blockSize;
+    RegionFile file;
+    quint64 written;
+
+public:
+    RegionSink(const RegionList &regions, quint64 blockSize);
+    int open(const QString &fileName, const DumpInfo &info) override;
+    int write(const uint8_t *buf, size_t len) override;
+    int close() override;
+    quint64 size() override;
+};
+
+/* Blocks are compressed by CompressPool, so reading is not slowed down */
+class DumpSink : public ReadSink
+{
+    DumpFile dump;
+    DumpInfo info;
+    CompressPool pool;
+    std::vector<uint8_t> block;
+    std::set<quint64> skippedBlocks;
+    quint64 nextBlock;
+    quint64 written;
+
+    void submitSkipped();
+
+public:
+    int open(const QString &fileName, const DumpInfo &info) override;
+    int write(const uint8_t *buf, size_t len) override;
+    void badBlock(quint64 addr, bool isSkipped) override;
+    int close() override;
+    quint64 size() override;
+};
+
+#ifdef HAVE_ZSTD
+/* Seekable zstd file, each chip block is an independent frame compressed
+ * by CompressPool
+ */
+class ZstdSink : public ReadSink
+{
+    const int compressLevel = 3;
+    const uint32_t defaultFrameSize = 1 << 20;
+
+    QFile file;
+    CompressPool pool;
+    uint32_t frameSize;
+    std::vector<uint8_t> frame;
+    std::vector<ZstdSeekTable::Entry> seekTable;
+    quint64 written;
+
+public:
+    int open(const QString &fileName, const DumpInfo &info) override;
+    int write(const uint8_t *buf, size_t len) override;
+    int close() override;
+    quint64 size() override;
+};
+#endif
+
+#endif // READ_SINK_H
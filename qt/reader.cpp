@@ -73,6 +73,7 @@ int Reader::handleBadBlock(char *pbuf, uint32_t len, bool isSkipped)
 
     logInfo(message.arg(badBlock->addr, 8, 16, QLatin1Char('0'))
         .arg(badBlock->size, 8, 16, QLatin1Char('0')));
+    emit this->badBlock(badBlock->addr, isSkipped);
 
     if (rlen && isSkipBB && isReadLess)
     {
@@ -112,6 +113,19 @@ int Reader::handleProgress(char *pbuf, uint32_t len)
     return static_cast<int>(size);
 }
 
+int Reader::handleEcc(char *pbuf, uint32_t len)
+{
+    RespEcc *resp = reinterpret_cast<RespEcc *>(pbuf);
+    size_t size = sizeof(RespEcc);
+
+    if (len < size)
+        return 0;
+
+    emit ecc(resp->addr, resp->ecc);
+
+    return static_cast<int>(size);
+}
+
 int Reader::handleStatus(char *pbuf, uint32_t len)
 {
     RespHeader *header = reinterpret_cast<RespHeader *>(pbuf);
@@ -126,6 +140,8 @@ int Reader::handleStatus(char *pbuf, uint32_t len)
         return handleBadBlock(pbuf, len, true);
     case STATUS_PROGRESS:
         return handleProgress(pbuf, len);
+    case STATUS_ECC:
+        return handleEcc(pbuf, len);
     case STATUS_OK:
         // Exit read loop
         if (!rlen)
@@ -40,6 +40,7 @@ class Reader : public QObject
     int handleError(char *pbuf, uint32_t len);
     int handleProgress(char *pbuf, uint32_t len);
     int handleBadBlock(char *pbuf, uint32_t len, bool isSkipped);
+    int handleEcc(char *pbuf, uint32_t len);
     int handleStatus(char *pbuf, uint32_t len);
     int handleData(char *pbuf, uint32_t len);
     int handlePacket(char *pbuf, uint32_t len);
@@ -58,6 +59,8 @@ public:
 signals:
     void result(quint64 ret);
     void progress(quint64 progress);
+    void ecc(quint64 addr, quint32 ecc);
+    void badBlock(quint64 addr, bool isSkipped);
     void log(QtMsgType msgType, QString msg);
 };
 
@@ -0,0 +1,264 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "region_list.h"
+#include <QDebug>
+#include <QMap>
+#include <QStringList>
+#include <algorithm>
+#include <set>
+
+int RegionList::parse(const QString &text, const QString &defaultFile,
+    quint32 blockCount, quint64 blockSize)
+{
+    QMap<QString, quint64> fileEnd;
+
+    regions.clear();
+    for (const QString &line : text.split('\n'))
+    {
+        QStringList fields = line.simplified().split(' ');
+        Region region;
+        bool isOk = true;
+
+        if (line.trimmed().isEmpty() || line.trimmed().startsWith('#'))
+            continue;
+
+        if (fields.size() > 4)
+            isOk = false;
+        else
+        {
+            region.block = fields[0].toUInt(&isOk, 0);
+            if (isOk && fields.size() > 1)
+                region.blocks = fields[1].toUInt(&isOk, 0);
+            else
+                isOk = false;
+        }
+        if (!isOk)
+        {
+            qCritical() << "Wrong region:" << line.trimmed();
+            return -1;
+        }
+
+        region.fileName = fields.size() > 2 ? fields[2] : defaultFile;
+        region.fileOffset = fileEnd.value(region.fileName, 0);
+        if (fields.size() > 3)
+        {
+            region.fileOffset = fields[3].toULongLong(&isOk, 0);
+            if (!isOk)
+            {
+                qCritical() << "Wrong region file offset:" << fields[3];
+                return -1;
+            }
+        }
+
+        if (!region.blocks || region.block >= blockCount ||
+            region.blocks > blockCount - region.block)
+        {
+            qCritical() << "Region" << line.trimmed() <<
+                "is out of chip blocks";
+            return -1;
+        }
+
+        if (regions.size() == maxRegions)
+        {
+            qCritical() << "More than" << maxRegions << "regions are set";
+            return -1;
+        }
+
+        fileEnd[region.fileName] = region.fileOffset +
+            region.blocks * blockSize;
+        regions.push_back(region);
+    }
+
+    if (regions.empty())
+    {
+        qCritical() << "Regions are not set";
+        return -1;
+    }
+
+    /* Programmer handles regions in chip order, overlapped blocks would be
+     * processed twice
+     */
+    std::stable_sort(regions.begin(), regions.end(),
+        [](const Region &a, const Region &b) { return a.block < b.block; });
+    for (size_t i = 1; i < regions.size(); i++)
+    {
+        const Region &prev = regions[i - 1];
+
+        if (prev.block + prev.blocks > regions[i].block)
+        {
+            qCritical() << "Region of blocks" << regions[i].block << "-" <<
+                regions[i].block + regions[i].blocks - 1 <<
+                "overlaps region of blocks" << prev.block << "-" <<
+                prev.block + prev.blocks - 1;
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+const std::vector<RegionList::Region> &RegionList::get() const
+{
+    return regions;
+}
+
+quint64 RegionList::dataSize(quint64 blockSize) const
+{
+    quint64 size = 0;
+
+    for (const Region &region : regions)
+        size += region.blocks * blockSize;
+
+    return size;
+}
+
+RegionFile::RegionFile()
+{
+    blockSize = 0;
+    index = 0;
+    regionPos = 0;
+    isWrite = false;
+    isOpened = false;
+}
+
+int RegionFile::openRegion()
+{
+    file.close();
+    if (index >= regions.size())
+        return 0;
+
+    const RegionList::Region &region = regions[index];
+
+    file.setFileName(region.fileName);
+    if (!file.open(isWrite ? QIODevice::ReadWrite : QIODevice::ReadOnly))
+    {
+        qCritical() << "Failed to open file:" << region.fileName <<
+            ", error:" << file.errorString();
+        return -1;
+    }
+
+    if (!file.seek(static_cast<qint64>(region.fileOffset)))
+    {
+        qCritical() << "Failed to seek file:" << region.fileName <<
+            ", error:" << file.errorString();
+        return -1;
+    }
+
+    return 0;
+}
+
+int RegionFile::open(const RegionList &list, quint64 blockSize, bool isWrite)
+{
+    std::set<QString> fileNames;
+
+    close();
+    regions = list.get();
+    this->blockSize = blockSize;
+    this->isWrite = isWrite;
+    index = 0;
+    regionPos = 0;
+
+    for (const RegionList::Region &region : regions)
+    {
+        if (!isWrite || !fileNames.insert(region.fileName).second)
+            continue;
+
+        QFile truncFile(region.fileName);
+        if (!truncFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            qCritical() << "Failed to open file:" << region.fileName <<
+                ", error:" << truncFile.errorString();
+            return -1;
+        }
+    }
+
+    if (openRegion())
+        return -1;
+    isOpened = true;
+
+    return 0;
+}
+
+qint64 RegionFile::read(uint8_t *buf, qint64 len)
+{
+    qint64 done = 0;
+
+    while (done < len && index < regions.size())
+    {
+        quint64 regionSize = regions[index].blocks * blockSize;
+        qint64 chunk = std::min<quint64>(len - done, regionSize - regionPos);
+        qint64 ret = file.read(reinterpret_cast<char *>(buf + done), chunk);
+
+        if (ret < 0)
+        {
+            qCritical() << "Failed to read file:" << file.fileName() <<
+                ", error:" << file.errorString();
+            return -1;
+        }
+        std::fill(buf + done + ret, buf + done + chunk, 0xFF);
+
+        done += chunk;
+        regionPos += chunk;
+        if (regionPos == regionSize)
+        {
+            index++;
+            regionPos = 0;
+            if (openRegion())
+                return -1;
+        }
+    }
+
+    return done;
+}
+
+int RegionFile::write(const uint8_t *buf, size_t len)
+{
+    size_t done = 0;
+
+    while (done < len && index < regions.size())
+    {
+        quint64 regionSize = regions[index].blocks * blockSize;
+        qint64 chunk = std::min<quint64>(len - done, regionSize - regionPos);
+
+        if (file.write(reinterpret_cast<const char *>(buf + done), chunk) !=
+            chunk)
+        {
+            qCritical() << "Failed to write file:" << file.fileName() <<
+                ", error:" << file.errorString();
+            return -1;
+        }
+
+        done += chunk;
+        regionPos += chunk;
+        if (regionPos == regionSize)
+        {
+            index++;
+            regionPos = 0;
+            if (openRegion())
+                return -1;
+        }
+    }
+
+    if (done < len)
+    {
+        qCritical() << "Data is more than regions size";
+        return -1;
+    }
+
+    return 0;
+}
+
+void RegionFile::close()
+{
+    file.close();
+    regions.clear();
+    isOpened = false;
+}
+
+bool RegionFile::isOpen()
+{
+    return isOpened;
+}
@@ -0,0 +1,69 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef REGION_LIST_H
+#define REGION_LIST_H
+
+#include "cmd.h"
+#include <QFile>
+#include <QString>
+#include <cstdint>
+#include <vector>
+
+/* Chip regions processed by programmer in one read or write command, each
+ * region is mapped to its own place in a host file.
+ */
+class RegionList
+{
+public:
+    typedef struct
+    {
+        quint32 block;
+        quint32 blocks;
+        QString fileName;
+        quint64 fileOffset;
+    } Region;
+
+    static const size_t maxRegions = CMD_MAX_REGIONS;
+
+private:
+    std::vector<Region> regions;
+
+public:
+    /* Each line is "first_block block_count [file [file_offset]]". Default
+     * file is used if file is not set, file offset continues after previous
+     * region of the same file if it is not set.
+     */
+    int parse(const QString &text, const QString &defaultFile,
+        quint32 blockCount, quint64 blockSize);
+    const std::vector<Region> &get() const;
+    quint64 dataSize(quint64 blockSize) const;
+};
+
+/* Continuous data of all regions split to their files */
+class RegionFile
+{
+    std::vector<RegionList::Region> regions;
+    quint64 blockSize;
+    size_t index;
+    quint64 regionPos;
+    bool isWrite;
+    bool isOpened;
+    QFile file;
+
+    int openRegion();
+
+public:
+    RegionFile();
+    /* Files are truncated if data is written to them */
+    int open(const RegionList &list, quint64 blockSize, bool isWrite);
+    /* Region data after the end of its file is read as erased */
+    qint64 read(uint8_t *buf, qint64 len);
+    int write(const uint8_t *buf, size_t len);
+    void close();
+    bool isOpen();
+};
+
+#endif // REGION_LIST_H
@@ -0,0 +1,123 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "search_dialog.h"
+#include "ui_search_dialog.h"
+#include <QDebug>
+
+SearchDialog::SearchDialog(QWidget *parent) : QDialog(parent),
+    ui(new Ui::SearchDialog)
+{
+    ui->setupUi(this);
+    isHolesErased = false;
+    isRunning = false;
+
+    connect(ui->searchPushButton, SIGNAL(clicked()), this,
+        SLOT(slotSearch()));
+    connect(ui->resultsListWidget, SIGNAL(itemActivated(QListWidgetItem *)),
+        this, SLOT(slotResultActivated(QListWidgetItem *)));
+    connect(&search, SIGNAL(matchFound(quint64, int)), this,
+        SLOT(slotMatchFound(quint64, int)));
+    connect(&search, SIGNAL(progress(quint64, quint64)), this,
+        SLOT(slotProgress(quint64, quint64)));
+    connect(&search, SIGNAL(finished(quint64, bool)), this,
+        SLOT(slotFinished(quint64, bool)));
+}
+
+SearchDialog::~SearchDialog()
+{
+    search.stop();
+    delete ui;
+}
+
+void SearchDialog::setFile(const QString &fileName, bool isHolesErased)
+{
+    this->fileName = fileName;
+    this->isHolesErased = isHolesErased;
+}
+
+void SearchDialog::stop()
+{
+    search.stop();
+}
+
+void SearchDialog::setRunning(bool isRunning)
+{
+    this->isRunning = isRunning;
+    ui->searchPushButton->setText(isRunning ? tr("Stop") : tr("Search"));
+    ui->patternsTextEdit->setReadOnly(isRunning);
+    ui->typeComboBox->setEnabled(!isRunning);
+}
+
+void SearchDialog::slotSearch()
+{
+    std::vector<QByteArray> patterns;
+    bool isHex = !ui->typeComboBox->currentIndex();
+
+    if (isRunning)
+    {
+        search.stop();
+        return;
+    }
+
+    patternNames.clear();
+    for (const QString &line :
+        ui->patternsTextEdit->toPlainText().split('\n'))
+    {
+        QByteArray pattern;
+
+        if (line.trimmed().isEmpty())
+            continue;
+
+        if (PatternSearch::parsePattern(line, isHex, pattern))
+        {
+            qCritical() << "Wrong search pattern:" << line;
+            return;
+        }
+        patterns.push_back(pattern);
+        patternNames.append(line.trimmed());
+    }
+
+    ui->resultsListWidget->clear();
+    ui->statusLabel->clear();
+    if (search.start(fileName, isHolesErased, patterns))
+        return;
+
+    setRunning(true);
+}
+
+void SearchDialog::slotMatchFound(quint64 addr, int pattern)
+{
+    QListWidgetItem *item = new QListWidgetItem(QString("0x%1  %2")
+        .arg(addr, 8, 16, QChar('0')).arg(patternNames.value(pattern)));
+
+    item->setData(Qt::UserRole, addr);
+    ui->resultsListWidget->addItem(item);
+}
+
+void SearchDialog::slotProgress(quint64 done, quint64 total)
+{
+    ui->statusLabel->setText(tr("Searched %1 of %2 MiB, found %3")
+        .arg(done >> 20).arg(total >> 20)
+        .arg(ui->resultsListWidget->count()));
+}
+
+void SearchDialog::slotFinished(quint64 matches, bool isCompleted)
+{
+    /* Thread is done, it is joined here */
+    search.stop();
+    setRunning(false);
+
+    QString status = isCompleted ? tr("Found %1").arg(matches) :
+        tr("Stopped, found %1").arg(matches);
+    if (matches > static_cast<quint64>(ui->resultsListWidget->count()))
+        status += tr(", first %1 shown").arg(ui->resultsListWidget->count());
+    ui->statusLabel->setText(status);
+}
+
+void SearchDialog::slotResultActivated(QListWidgetItem *item)
+{
+    emit jumpTo(item->data(Qt::UserRole).toULongLong());
+}
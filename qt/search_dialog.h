@@ -0,0 +1,49 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef SEARCH_DIALOG_H
+#define SEARCH_DIALOG_H
+
+#include "pattern_search.h"
+#include <QDialog>
+#include <QListWidgetItem>
+#include <QStringList>
+
+namespace Ui {
+class SearchDialog;
+}
+
+class SearchDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit SearchDialog(QWidget *parent = nullptr);
+    ~SearchDialog();
+    void setFile(const QString &fileName, bool isHolesErased);
+    void stop();
+
+signals:
+    void jumpTo(quint64 addr);
+
+private slots:
+    void slotSearch();
+    void slotMatchFound(quint64 addr, int pattern);
+    void slotProgress(quint64 done, quint64 total);
+    void slotFinished(quint64 matches, bool isCompleted);
+    void slotResultActivated(QListWidgetItem *item);
+
+private:
+    Ui::SearchDialog *ui;
+    FileSearch search;
+    QString fileName;
+    bool isHolesErased;
+    bool isRunning;
+    QStringList patternNames;
+
+    void setRunning(bool isRunning);
+};
+
+#endif // SEARCH_DIALOG_H
@@ -17,7 +17,19 @@
     "include_spare_area"
 #define SETTINGS_ENABLE_HW_ECC SETTINGS_PROGRAMMER_SECTION \
     "enable_hw_ecc"
+#define SETTINGS_ERASE_ON_WRITE SETTINGS_PROGRAMMER_SECTION \
+    "erase_on_write"
+#define SETTINGS_FSMC_ECC SETTINGS_PROGRAMMER_SECTION "fsmc_ecc"
+#define SETTINGS_SW_ECC SETTINGS_PROGRAMMER_SECTION "sw_ecc"
+#define SETTINGS_VERIFY_TOLERANT SETTINGS_PROGRAMMER_SECTION \
+    "verify_tolerant"
+#define SETTINGS_SPARSE_FILE SETTINGS_PROGRAMMER_SECTION "sparse_file"
+#define SETTINGS_HOLES_ERASED SETTINGS_PROGRAMMER_SECTION "holes_erased"
+#define SETTINGS_SPARE_MODE SETTINGS_PROGRAMMER_SECTION "spare_mode"
 #define SETTINGS_ENABLE_ALERT SETTINGS_GUI_SECTION "enable_alert"
 #define SETTINGS_WORK_FILE_PATH SETTINGS_GUI_SECTION "work_file_path"
+#define SETTINGS_REGIONS SETTINGS_GUI_SECTION "regions"
+/* Followed by chip name */
+#define SETTINGS_PARTITIONS SETTINGS_GUI_SECTION "partitions/"
 
 #endif // SETTINGS_H
@@ -62,6 +62,76 @@ bool SettingsProgrammerDialog::isHwEccEnabled()
     return ui->enableHwEccCheckBox->isChecked();
 }
 
+void SettingsProgrammerDialog::setEraseOnWrite(bool eraseOnWrite)
+{
+    ui->eraseOnWriteCheckBox->setChecked(eraseOnWrite);
+}
+
+bool SettingsProgrammerDialog::isEraseOnWrite()
+{
+    return ui->eraseOnWriteCheckBox->isChecked();
+}
+
+void SettingsProgrammerDialog::setFsmcEcc(bool fsmcEcc)
+{
+    ui->fsmcEccCheckBox->setChecked(fsmcEcc);
+}
+
+bool SettingsProgrammerDialog::isFsmcEcc()
+{
+    return ui->fsmcEccCheckBox->isChecked();
+}
+
+void SettingsProgrammerDialog::setSwEcc(bool swEcc)
+{
+    ui->swEccCheckBox->setChecked(swEcc);
+}
+
+bool SettingsProgrammerDialog::isSwEcc()
+{
+    return ui->swEccCheckBox->isChecked();
+}
+
+void SettingsProgrammerDialog::setVerifyTolerant(bool verifyTolerant)
+{
+    ui->verifyTolerantCheckBox->setChecked(verifyTolerant);
+}
+
+bool SettingsProgrammerDialog::isVerifyTolerant()
+{
+    return ui->verifyTolerantCheckBox->isChecked();
+}
+
+void SettingsProgrammerDialog::setSparseFile(bool sparseFile)
+{
+    ui->sparseFileCheckBox->setChecked(sparseFile);
+}
+
+bool SettingsProgrammerDialog::isSparseFile()
+{
+    return ui->sparseFileCheckBox->isChecked();
+}
+
+void SettingsProgrammerDialog::setHolesErased(bool holesErased)
+{
+    ui->holesErasedCheckBox->setChecked(holesErased);
+}
+
+bool SettingsProgrammerDialog::isHolesErased()
+{
+    return ui->holesErasedCheckBox->isChecked();
+}
+
+void SettingsProgrammerDialog::setSpareMode(int spareMode)
+{
+    ui->spareModeComboBox->setCurrentIndex(spareMode);
+}
+
+int SettingsProgrammerDialog::getSpareMode()
+{
+    return ui->spareModeComboBox->currentIndex();
+}
+
 void SettingsProgrammerDialog::setAlertEnabled(bool enableAlert)
 {
     ui->enableAlertCheckBox->setChecked(enableAlert);
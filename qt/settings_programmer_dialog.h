@@ -28,6 +28,20 @@ public:
     bool isIncSpare();
     void setHwEccEnabled(bool enableHwEcc);
     bool isHwEccEnabled();
+    void setEraseOnWrite(bool eraseOnWrite);
+    bool isEraseOnWrite();
+    void setFsmcEcc(bool fsmcEcc);
+    bool isFsmcEcc();
+    void setSwEcc(bool swEcc);
+    bool isSwEcc();
+    void setVerifyTolerant(bool verifyTolerant);
+    bool isVerifyTolerant();
+    void setSparseFile(bool sparseFile);
+    bool isSparseFile();
+    void setHolesErased(bool holesErased);
+    bool isHolesErased();
+    void setSpareMode(int spareMode);
+    int getSpareMode();
     void setAlertEnabled(bool enableAlert);
     bool isAlertEnabled();
 
@@ -0,0 +1,193 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "sparse_file.h"
+#include "cpu_features.h"
+#include <cstring>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+#define SPARSE_FILE_HOLES
+#endif
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SPARSE_FILE_X86
+#endif
+
+typedef bool (*IsErasedFunc)(const uint8_t *buf, size_t len);
+
+static bool isErasedScalar(const uint8_t *buf, size_t len)
+{
+    size_t i = 0;
+
+    for (; i + 8 <= len; i += 8)
+    {
+        uint64_t x;
+
+        memcpy(&x, buf + i, sizeof(x));
+        if (x != UINT64_MAX)
+            return false;
+    }
+
+    for (; i < len; i++)
+    {
+        if (buf[i] != 0xFF)
+            return false;
+    }
+
+    return true;
+}
+
+#ifdef SPARSE_FILE_X86
+__attribute__((target("sse2")))
+static bool isErasedSse2(const uint8_t *buf, size_t len)
+{
+    const __m128i ones = _mm_set1_epi8(static_cast<char>(0xFF));
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i x =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + i));
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, ones)) != 0xFFFF)
+            return false;
+    }
+
+    return isErasedScalar(buf + i, len - i);
+}
+
+/* Two vectors are AND-ed per iteration, most data pages fail in the first */
+__attribute__((target("avx2")))
+static bool isErasedAvx2(const uint8_t *buf, size_t len)
+{
+    size_t i = 0;
+
+    for (; i + 64 <= len; i += 64)
+    {
+        __m256i x =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(buf + i));
+        __m256i y = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(buf + i + 32));
+        __m256i v = _mm256_and_si256(x, y);
+
+        if (!_mm256_testc_si256(v, _mm256_set1_epi8(static_cast<char>(0xFF))))
+            return false;
+    }
+
+    return isErasedScalar(buf + i, len - i);
+}
+#endif
+
+struct SparseFileKernel
+{
+    CpuFeature feature;
+    const char *name;
+    IsErasedFunc isErased;
+};
+
+static const SparseFileKernel kernels[] =
+{
+#ifdef SPARSE_FILE_X86
+    { CPU_FEATURE_AVX2, "AVX2", isErasedAvx2 },
+    { CPU_FEATURE_SSE2, "SSE2", isErasedSse2 },
+#endif
+    { CPU_FEATURE_NONE, "scalar", isErasedScalar },
+};
+
+static const SparseFileKernel &kernel = cpuKernelSelect(kernels);
+
+SparseFile::SparseFile()
+{
+    holesErased = false;
+}
+
+void SparseFile::setHolesErased(bool isHolesErased)
+{
+    holesErased = isHolesErased;
+}
+
+bool SparseFile::isHolesErased()
+{
+    return holesErased;
+}
+
+bool SparseFile::isSupported()
+{
+#ifdef SPARSE_FILE_HOLES
+    return true;
+#else
+    return false;
+#endif
+}
+
+const char *SparseFile::kernelName()
+{
+    return kernel.name;
+}
+
+bool SparseFile::isErased(const uint8_t *buf, size_t len)
+{
+    return kernel.isErased(buf, len);
+}
+
+/* Hole ranges are found by SEEK_DATA/SEEK_HOLE, file offset is restored.
+ * Offsets are 64-bit, off_t is 64-bit on 32-bit hosts by qt.pro.
+ */
+void SparseFile::fillHoles(char *data, qint64 start, qint64 len)
+{
+#ifdef SPARSE_FILE_HOLES
+    static_assert(sizeof(off_t) >= sizeof(qint64),
+        "Large file offsets are required");
+    int fd = handle();
+    qint64 end = start + len;
+    qint64 off = start;
+
+    while (off < end)
+    {
+        qint64 dataOff = lseek(fd, off, SEEK_DATA);
+
+        /* No data after offset */
+        if (dataOff < 0 || dataOff > end)
+            dataOff = end;
+
+        memset(data + (off - start), 0xFF, static_cast<size_t>(dataOff - off));
+        if (dataOff >= end)
+            break;
+
+        off = lseek(fd, dataOff, SEEK_HOLE);
+        if (off < 0)
+            break;
+    }
+
+    lseek(fd, end, SEEK_SET);
+#else
+    (void)data;
+    (void)start;
+    (void)len;
+#endif
+}
+
+qint64 SparseFile::readData(char *data, qint64 maxSize)
+{
+    qint64 start = -1, ret;
+
+#ifdef SPARSE_FILE_HOLES
+    /* File engine reads unbuffered from descriptor, so its offset is the
+     * offset of data
+     */
+    if (holesErased)
+        start = lseek(handle(), 0, SEEK_CUR);
+#endif
+
+    ret = QFile::readData(data, maxSize);
+    if (start >= 0 && ret > 0)
+        fillHoles(data, start, ret);
+
+    return ret;
+}
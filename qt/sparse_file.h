@@ -0,0 +1,36 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef SPARSE_FILE_H
+#define SPARSE_FILE_H
+
+#include <QFile>
+#include <cstddef>
+#include <cstdint>
+
+/* File which may have holes in place of erased data. Holes are read as
+ * zeroes by the OS, with holesErased they are read as erased data (0xFF).
+ */
+class SparseFile : public QFile
+{
+    bool holesErased;
+
+    void fillHoles(char *data, qint64 start, qint64 len);
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+
+public:
+    SparseFile();
+    void setHolesErased(bool isHolesErased);
+    bool isHolesErased();
+
+    static bool isSupported();
+    static const char *kernelName();
+    /* Returns true if all bytes of buffer are 0xFF */
+    static bool isErased(const uint8_t *buf, size_t len);
+};
+
+#endif // SPARSE_FILE_H
@@ -0,0 +1,91 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "ubi_image.h"
+#include <algorithm>
+
+#define UBI_EC_HDR_MAGIC 0x55424923 /* UBI# */
+#define UBI_VID_HDR_MAGIC 0x55424921 /* UBI! */
+#define UBI_EC_HDR_VID_HDR_OFFSET 16
+#define UBI_HDR_MAGIC_SIZE 4
+
+static uint32_t getBe32(const uint8_t *p)
+{
+    return static_cast<uint32_t>(p[0]) << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+static bool isErased(const uint8_t *buf, uint32_t size)
+{
+    return std::all_of(buf, buf + size, [](uint8_t b) { return b == 0xFF; });
+}
+
+UbiImage::UbiImage()
+{
+    init(false);
+}
+
+void UbiImage::init(bool isFreeErased)
+{
+    this->isFreeErased = isFreeErased;
+    pebs = 0;
+    freePebs = 0;
+    pages = 0;
+    dataPages = 0;
+}
+
+bool UbiImage::isUbi(const uint8_t *peb, uint32_t size)
+{
+    return size >= UBI_HDR_MAGIC_SIZE && getBe32(peb) == UBI_EC_HDR_MAGIC;
+}
+
+uint32_t UbiImage::preparePeb(uint8_t *peb, uint32_t size, uint32_t pageSize)
+{
+    uint32_t vidHdrOffset, pebDataPages = 0;
+
+    pebs++;
+    if (isUbi(peb, size) && size >= UBI_EC_HDR_VID_HDR_OFFSET +
+        UBI_HDR_MAGIC_SIZE)
+    {
+        vidHdrOffset = getBe32(peb + UBI_EC_HDR_VID_HDR_OFFSET);
+        if (vidHdrOffset <= size - UBI_HDR_MAGIC_SIZE &&
+            getBe32(peb + vidHdrOffset) != UBI_VID_HDR_MAGIC)
+        {
+            freePebs++;
+            /* UBI erases such PEB itself and writes erase counter */
+            if (isFreeErased)
+                std::fill(peb, peb + size, 0xFF);
+        }
+    }
+
+    for (uint32_t offset = 0; offset < size; offset += pageSize)
+    {
+        pages++;
+        if (!isErased(peb + offset, std::min(pageSize, size - offset)))
+            pebDataPages++;
+    }
+    dataPages += pebDataPages;
+
+    return pebDataPages;
+}
+
+quint64 UbiImage::getPebs()
+{
+    return pebs;
+}
+
+quint64 UbiImage::getFreePebs()
+{
+    return freePebs;
+}
+
+quint64 UbiImage::getPages()
+{
+    return pages;
+}
+
+quint64 UbiImage::getDataPages()
+{
+    return dataPages;
+}
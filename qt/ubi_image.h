@@ -0,0 +1,39 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef UBI_IMAGE_H
+#define UBI_IMAGE_H
+
+#include <QtGlobal>
+#include <cstdint>
+
+/* UBI image written PEB by PEB. PEB is free if it has erase counter header
+ * but no volume identifier header. Erased pages are not programmed, so only
+ * headers and volume data are written.
+ */
+class UbiImage
+{
+    bool isFreeErased;
+    quint64 pebs;
+    quint64 freePebs;
+    quint64 pages;
+    quint64 dataPages;
+
+public:
+    UbiImage();
+    /* Free PEBs are left erased without erase counter header if
+     * isFreeErased.
+     */
+    void init(bool isFreeErased);
+    static bool isUbi(const uint8_t *peb, uint32_t size);
+    /* PEB data is changed in place, returns the number of pages to program */
+    uint32_t preparePeb(uint8_t *peb, uint32_t size, uint32_t pageSize);
+    quint64 getPebs();
+    quint64 getFreePebs();
+    quint64 getPages();
+    quint64 getDataPages();
+};
+
+#endif // UBI_IMAGE_H
@@ -0,0 +1,468 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "verifier.h"
+#include "cpu_features.h"
+#include "image_device.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VERIFIER_X86
+#endif
+
+typedef size_t (*FindMismatchFunc)(const uint8_t *a, const uint8_t *b,
+    size_t len);
+typedef uint64_t (*XorBitsFunc)(const uint8_t *a, const uint8_t *b,
+    size_t len);
+
+static size_t findMismatchScalar(const uint8_t *a, const uint8_t *b,
+    size_t len)
+{
+    size_t i = 0;
+
+    for (; i + 8 <= len; i += 8)
+    {
+        uint64_t x, y;
+
+        memcpy(&x, a + i, sizeof(x));
+        memcpy(&y, b + i, sizeof(y));
+        if (x != y)
+            break;
+    }
+
+    for (; i < len; i++)
+    {
+        if (a[i] != b[i])
+            return i;
+    }
+
+    return len;
+}
+
+static uint64_t xorBitsScalar(const uint8_t *a, const uint8_t *b, size_t len)
+{
+    uint64_t bits = 0;
+    size_t i = 0;
+
+    for (; i + 8 <= len; i += 8)
+    {
+        uint64_t x, y;
+
+        memcpy(&x, a + i, sizeof(x));
+        memcpy(&y, b + i, sizeof(y));
+        bits += __builtin_popcountll(x ^ y);
+    }
+
+    for (; i < len; i++)
+        bits += __builtin_popcount(a[i] ^ b[i]);
+
+    return bits;
+}
+
+#ifdef VERIFIER_X86
+__attribute__((target("sse2")))
+static size_t findMismatchSse2(const uint8_t *a, const uint8_t *b, size_t len)
+{
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) ^ 0xFFFF;
+
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+
+    return i + findMismatchScalar(a + i, b + i, len - i);
+}
+
+/* Bit count of each byte by SWAR, summed by SAD */
+__attribute__((target("sse2")))
+static uint64_t xorBitsSse2(const uint8_t *a, const uint8_t *b, size_t len)
+{
+    const __m128i m1 = _mm_set1_epi8(0x55);
+    const __m128i m2 = _mm_set1_epi8(0x33);
+    const __m128i m4 = _mm_set1_epi8(0x0F);
+    __m128i acc = _mm_setzero_si128();
+    uint64_t sum[2];
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        __m128i v = _mm_xor_si128(x, y);
+
+        v = _mm_sub_epi8(v, _mm_and_si128(_mm_srli_epi16(v, 1), m1));
+        v = _mm_add_epi8(_mm_and_si128(v, m2),
+            _mm_and_si128(_mm_srli_epi16(v, 2), m2));
+        v = _mm_and_si128(_mm_add_epi8(v, _mm_srli_epi16(v, 4)), m4);
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(v, _mm_setzero_si128()));
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(sum), acc);
+
+    return sum[0] + sum[1] + xorBitsScalar(a + i, b + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static size_t findMismatchAvx2(const uint8_t *a, const uint8_t *b, size_t len)
+{
+    size_t i = 0;
+
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i x =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        __m256i y =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        uint32_t mask = ~static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+
+    return i + findMismatchScalar(a + i, b + i, len - i);
+}
+
+/* Bit count of each nibble by table lookup, summed by SAD */
+__attribute__((target("avx2")))
+static uint64_t xorBitsAvx2(const uint8_t *a, const uint8_t *b, size_t len)
+{
+    const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3,
+        2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0F);
+    __m256i acc = _mm256_setzero_si256();
+    uint64_t sum[4];
+    size_t i = 0;
+
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i x =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        __m256i y =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        __m256i v = _mm256_xor_si256(x, y);
+        __m256i cnt = _mm256_add_epi8(
+            _mm256_shuffle_epi8(lut, _mm256_and_si256(v, low)),
+            _mm256_shuffle_epi8(lut,
+            _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+
+        acc = _mm256_add_epi64(acc,
+            _mm256_sad_epu8(cnt, _mm256_setzero_si256()));
+    }
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(sum), acc);
+
+    return sum[0] + sum[1] + sum[2] + sum[3] +
+        xorBitsScalar(a + i, b + i, len - i);
+}
+#endif
+
+struct VerifierKernel
+{
+    CpuFeature feature;
+    const char *name;
+    FindMismatchFunc findMismatch;
+    XorBitsFunc xorBits;
+};
+
+static const VerifierKernel kernels[] =
+{
+#ifdef VERIFIER_X86
+    { CPU_FEATURE_AVX2, "AVX2", findMismatchAvx2, xorBitsAvx2 },
+    { CPU_FEATURE_SSE2, "SSE2", findMismatchSse2, xorBitsSse2 },
+#endif
+    { CPU_FEATURE_NONE, "scalar", findMismatchScalar, xorBitsScalar },
+};
+
+static const VerifierKernel &kernel = cpuKernelSelect(kernels);
+
+const char *Verifier::kernelName()
+{
+    return kernel.name;
+}
+
+/* Returns offset of the first different byte or len if data is equal */
+size_t Verifier::findMismatch(const uint8_t *a, const uint8_t *b, size_t len)
+{
+    return kernel.findMismatch(a, b, len);
+}
+
+uint64_t Verifier::xorBits(const uint8_t *a, const uint8_t *b, size_t len)
+{
+    return kernel.xorBits(a, b, len);
+}
+
+Verifier::Verifier()
+{
+    isStopped = true;
+    device = &file;
+    addr = 0;
+    pageSize = 0;
+    blockSize = 0;
+    mismatchBytes = 0;
+    mismatchBits = 0;
+    eccStep = 0;
+    threshold = 0;
+    failedSteps = 0;
+}
+
+Verifier::~Verifier()
+{
+    finish();
+}
+
+/* Mismatch map is saved to <fileName>.mismatch. If eccStep is set, bits
+ * are counted per ECC step and verify passes while each step has no more
+ * than threshold bitflips.
+ */
+int Verifier::start(const QString &fileName, quint64 addr, uint32_t pageSize,
+    quint64 blockSize, uint32_t eccStep, uint32_t threshold)
+{
+    finish();
+
+    if (ImageDevice::isContainer(fileName))
+    {
+        imageDevice.reset(ImageDevice::create(fileName));
+        if (!imageDevice)
+            return -1;
+        device = imageDevice.get();
+    }
+    else
+    {
+        file.setFileName(fileName);
+        device = &file;
+    }
+
+    if (!device->open(QIODevice::ReadOnly))
+    {
+        qCritical() << "Failed to open compare file:" << fileName
+            << ", error:" << device->errorString();
+        return -1;
+    }
+
+    reportFile.setFileName(fileName + ".mismatch");
+    if (!reportFile.open(QIODevice::WriteOnly | QIODevice::Truncate |
+        QIODevice::Text))
+    {
+        qCritical() << "Failed to open file:" << reportFile.fileName()
+            << ", error:" << reportFile.errorString();
+        device->close();
+        return -1;
+    }
+    reportFile.write(eccStep ? "# page, step offset, different bits\n" :
+        "# page, byte offset, different bits\n");
+
+    this->addr = addr;
+    this->pageSize = pageSize;
+    this->blockSize = blockSize;
+    mismatchBytes = 0;
+    mismatchBits = 0;
+    blockStats.clear();
+    this->eccStep = eccStep;
+    this->threshold = threshold;
+    failedSteps = 0;
+    histogram.assign(histogramMax + 1, 0);
+    pendingData.clear();
+    pendingRef.clear();
+    queue.clear();
+    isStopped = false;
+
+    thread = std::thread(&Verifier::worker, this);
+
+    return 0;
+}
+
+void Verifier::push(std::vector<uint8_t> &data)
+{
+    std::unique_lock<std::mutex> lck(mutex);
+
+    queue.emplace_back();
+    queue.back().swap(data);
+    cv.notify_one();
+}
+
+void Verifier::finish()
+{
+    if (!thread.joinable())
+        return;
+
+    {
+        std::unique_lock<std::mutex> lck(mutex);
+        isStopped = true;
+        cv.notify_one();
+    }
+
+    thread.join();
+    device->close();
+    reportFile.close();
+}
+
+void Verifier::setHolesErased(bool isHolesErased)
+{
+    file.setHolesErased(isHolesErased);
+}
+
+void Verifier::compare(const uint8_t *data, const uint8_t *ref, size_t len)
+{
+    QByteArray report;
+    size_t off = 0;
+
+    while ((off += findMismatch(data + off, ref + off, len - off)) < len)
+    {
+        quint64 byteAddr = addr + off;
+        uint32_t bits = xorBits(data + off, ref + off, 1);
+        BlockStat &stat = blockStats[byteAddr / blockSize];
+
+        stat.bytes++;
+        stat.bits += bits;
+        mismatchBytes++;
+        mismatchBits += bits;
+
+        report.append(QString("%1, %2, %3\n").arg(byteAddr / pageSize)
+            .arg(byteAddr % pageSize).arg(bits).toLatin1());
+        off++;
+    }
+
+    addr += len;
+    reportFile.write(report);
+}
+
+/* Steps start from page boundary, the page tail shorter than step (spare
+ * area) is counted as one more step.
+ */
+void Verifier::compareSteps(const uint8_t *data, const uint8_t *ref,
+    size_t len)
+{
+    QByteArray report;
+
+    for (size_t off = 0, size; off < len; off += size)
+    {
+        quint64 byteAddr = addr + off;
+        uint32_t pageOff = byteAddr % pageSize;
+        uint64_t bits;
+
+        size = std::min<size_t>(std::min<size_t>(eccStep, pageSize - pageOff),
+            len - off);
+        bits = xorBits(data + off, ref + off, size);
+        histogram[std::min<uint64_t>(bits, histogramMax)]++;
+        if (!bits)
+            continue;
+
+        BlockStat &stat = blockStats[byteAddr / blockSize];
+        stat.bits += bits;
+        mismatchBits += bits;
+        if (bits <= threshold)
+            continue;
+
+        stat.failedSteps++;
+        failedSteps++;
+        report.append(QString("%1, %2, %3\n").arg(byteAddr / pageSize)
+            .arg(pageOff).arg(bits).toLatin1());
+    }
+
+    addr += len;
+    reportFile.write(report);
+}
+
+/* Chunks are not aligned to pages, so step could be split between them */
+void Verifier::compareTolerant(const uint8_t *data, const uint8_t *ref,
+    size_t len, bool isLast)
+{
+    size_t size;
+
+    pendingData.insert(pendingData.end(), data, data + len);
+    pendingRef.insert(pendingRef.end(), ref, ref + len);
+
+    size = isLast ? pendingData.size() :
+        pendingData.size() / pageSize * pageSize;
+    if (!size)
+        return;
+
+    compareSteps(pendingData.data(), pendingRef.data(), size);
+    pendingData.erase(pendingData.begin(), pendingData.begin() + size);
+    pendingRef.erase(pendingRef.begin(), pendingRef.begin() + size);
+}
+
+void Verifier::worker()
+{
+    std::vector<uint8_t> data, ref;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lck(mutex);
+
+            cv.wait(lck, [this] { return isStopped || !queue.empty(); });
+            if (queue.empty())
+            {
+                if (eccStep)
+                    compareTolerant(nullptr, nullptr, 0, true);
+                break;
+            }
+
+            data.swap(queue.front());
+            queue.pop_front();
+        }
+
+        /* File is padded by erased data up to the page size on write */
+        ref.resize(data.size());
+        qint64 readSize = device->read(reinterpret_cast<char *>(ref.data()),
+            static_cast<qint64>(ref.size()));
+        std::fill(ref.begin() + std::max(readSize, 0LL), ref.end(), 0xFF);
+
+        if (eccStep)
+            compareTolerant(data.data(), ref.data(), data.size(), false);
+        else
+            compare(data.data(), ref.data(), data.size());
+    }
+}
+
+quint64 Verifier::getMismatchBytes()
+{
+    return mismatchBytes;
+}
+
+quint64 Verifier::getMismatchBits()
+{
+    return mismatchBits;
+}
+
+bool Verifier::isTolerant()
+{
+    return eccStep != 0;
+}
+
+bool Verifier::isPassed()
+{
+    return eccStep ? !failedSteps : !mismatchBytes;
+}
+
+quint64 Verifier::getFailedSteps()
+{
+    return failedSteps;
+}
+
+const std::vector<quint64> &Verifier::getHistogram()
+{
+    return histogram;
+}
+
+const QMap<quint64, Verifier::BlockStat> &Verifier::getBlockStats()
+{
+    return blockStats;
+}
+
+QString Verifier::getReportFileName()
+{
+    return reportFile.fileName();
+}
@@ -0,0 +1,87 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef VERIFIER_H
+#define VERIFIER_H
+
+#include "sparse_file.h"
+#include <QFile>
+#include <QMap>
+#include <QString>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Compares read back data with file on a worker thread */
+class Verifier
+{
+public:
+    typedef struct
+    {
+        quint64 bytes;
+        quint64 bits;
+        quint64 failedSteps;
+    } BlockStat;
+
+    /* Last histogram entry counts steps with this or more bitflips */
+    const uint32_t histogramMax = 64;
+
+private:
+    SparseFile file;
+    std::unique_ptr<QIODevice> imageDevice;
+    QIODevice *device;
+    QFile reportFile;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::vector<uint8_t>> queue;
+    bool isStopped;
+    quint64 addr;
+    uint32_t pageSize;
+    quint64 blockSize;
+    quint64 mismatchBytes;
+    quint64 mismatchBits;
+    QMap<quint64, BlockStat> blockStats;
+    uint32_t eccStep;
+    uint32_t threshold;
+    quint64 failedSteps;
+    std::vector<quint64> histogram;
+    std::vector<uint8_t> pendingData;
+    std::vector<uint8_t> pendingRef;
+
+    void worker();
+    void compare(const uint8_t *data, const uint8_t *ref, size_t len);
+    void compareSteps(const uint8_t *data, const uint8_t *ref, size_t len);
+    void compareTolerant(const uint8_t *data, const uint8_t *ref, size_t len,
+        bool isLast);
+
+public:
+    Verifier();
+    ~Verifier();
+    int start(const QString &fileName, quint64 addr, uint32_t pageSize,
+        quint64 blockSize, uint32_t eccStep = 0, uint32_t threshold = 0);
+    void push(std::vector<uint8_t> &data);
+    void finish();
+    void setHolesErased(bool isHolesErased);
+    quint64 getMismatchBytes();
+    quint64 getMismatchBits();
+    bool isTolerant();
+    bool isPassed();
+    quint64 getFailedSteps();
+    const std::vector<quint64> &getHistogram();
+    const QMap<quint64, BlockStat> &getBlockStats();
+    QString getReportFileName();
+
+    static const char *kernelName();
+    static size_t findMismatch(const uint8_t *a, const uint8_t *b,
+        size_t len);
+    static uint64_t xorBits(const uint8_t *a, const uint8_t *b, size_t len);
+};
+
+#endif // VERIFIER_H
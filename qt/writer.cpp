@@ -6,6 +6,7 @@
 #include "writer.h"
 #include "err.h"
 #include <QDebug>
+#include <algorithm>
 
 #define READ_ACK_TIMEOUT 5000
 
@@ -20,7 +21,9 @@ Writer::~Writer()
 
 void Writer::init(const QString &portName, qint32 baudRate, SyncBuffer *buf,
     quint64 addr, quint64 len, uint32_t pageSize, bool skipBB, bool incSpare,
-    bool enableHwEcc, uint8_t startCmd, uint8_t dataCmd, uint8_t endCmd)
+    bool enableHwEcc, bool eraseOnWrite, bool fsmcEcc, bool regions,
+    bool planes, bool skipErased, uint8_t startCmd, uint8_t dataCmd,
+    uint8_t endCmd)
 {
     this->portName = portName;
     this->baudRate = baudRate;
@@ -31,6 +34,11 @@ void Writer::init(const QString &portName, qint32 baudRate, SyncBuffer *buf,
     this->skipBB = skipBB;
     this->incSpare = incSpare;
     this->enableHwEcc = enableHwEcc;
+    this->eraseOnWrite = eraseOnWrite;
+    this->fsmcEcc = fsmcEcc;
+    this->regions = regions;
+    this->planes = planes;
+    this->skipErased = skipErased;
     this->startCmd = startCmd;
     this->dataCmd = dataCmd;
     this->endCmd = endCmd;
@@ -107,6 +115,7 @@ int Writer::handleBadBlock(RespHeader *header, uint32_t len, bool isSkipped)
 
     logInfo(message.arg(badBlock->addr, 8, 16, QLatin1Char('0'))
         .arg(badBlock->size, 8, 16, QLatin1Char('0')));
+    emit this->badBlock(badBlock->addr, isSkipped);
 
     // Bad block notification is received before acknowledge therefore need to restart read.
     // Need to implement async write to avoid this.
@@ -251,6 +260,10 @@ int Writer::writeStart()
     writeStartCmd.flags.skipBB = skipBB;
     writeStartCmd.flags.incSpare = incSpare;
     writeStartCmd.flags.enableHwEcc = enableHwEcc;
+    writeStartCmd.flags.erase = eraseOnWrite;
+    writeStartCmd.flags.fsmcEcc = fsmcEcc;
+    writeStartCmd.flags.regions = regions;
+    writeStartCmd.flags.planes = planes;
     cmd = startCmd;
 
     if (write(reinterpret_cast<char *>(&writeStartCmd),
@@ -280,6 +293,26 @@ int Writer::writeData()
     buf->cv.wait(lck, [this] { return this->buf->ready; });
     buf->ready = false;
 
+    /* Run of erased pages is skipped by one command, the page following
+     * the run is left in buffer until the run is acknowledged.
+     */
+    if (skipErased && isBufErased())
+    {
+        uint32_t pages = 1;
+
+        while (pages < skipPagesMax && len > pages * pageSize)
+        {
+            emit progress(bytesWritten + pages * pageSize);
+            buf->cv.wait(lck, [this] { return this->buf->ready; });
+            if (!isBufErased())
+                break;
+            buf->ready = false;
+            pages++;
+        }
+
+        return writeSkip(pages);
+    }
+
     while (len)
     {
         dataLen = len < dataLenMax ? len : dataLenMax;
@@ -307,6 +340,32 @@ int Writer::writeData()
     return 0;
 }
 
+bool Writer::isBufErased()
+{
+    return len >= pageSize && std::all_of(buf->buf.begin(),
+        buf->buf.begin() + pageSize, [](uint8_t b) { return b == 0xFF; });
+}
+
+/* Erased pages are not transferred, programmer leaves them as is */
+int Writer::writeSkip(uint32_t pages)
+{
+    WriteSkipCmd writeSkipCmd;
+
+    writeSkipCmd.cmd.code = CMD_NAND_WRITE_SKIP;
+    writeSkipCmd.pages = pages;
+
+    if (write(reinterpret_cast<char *>(&writeSkipCmd), sizeof(WriteSkipCmd)))
+        return -1;
+
+    bytesWritten += pages * pageSize;
+    len -= pages * pageSize;
+
+    if (read(pbuf, sizeof(RespWriteAck)))
+        return -1;
+
+    return 0;
+}
+
 int Writer::writeEnd()
 {
     WriteEndCmd writeEndCmd;
@@ -16,6 +16,8 @@ class Writer : public QObject
     Q_OBJECT
 
     static const uint32_t bufSize = 64;
+    /* Erase on write of skipped blocks must fit in response timeout */
+    static const uint32_t skipPagesMax = 4096;
 
     SerialPort *serialPort = nullptr;
     QString portName;
@@ -29,6 +31,11 @@ class Writer : public QObject
     bool skipBB;
     bool incSpare;
     bool enableHwEcc;
+    bool eraseOnWrite;
+    bool fsmcEcc;
+    bool regions;
+    bool planes;
+    bool skipErased;
     uint8_t startCmd;
     uint8_t dataCmd;
     uint8_t endCmd;
@@ -48,6 +55,8 @@ class Writer : public QObject
     int handlePackets(char *pbuf, uint32_t len);
     int writeStart();
     int writeData();
+    bool isBufErased();
+    int writeSkip(uint32_t pages);
     int writeEnd();
     int serialPortCreate();
     void serialPortDestroy();
@@ -59,13 +68,15 @@ public:
     ~Writer();
     void init(const QString &portName, qint32 baudRate, SyncBuffer *buf,
         quint64 addr, quint64 len, uint32_t pageSize,
-        bool skipBB, bool incSpare, bool enableHwEcc, uint8_t startCmd,
-        uint8_t dataCmd, uint8_t endCmd);
+        bool skipBB, bool incSpare, bool enableHwEcc, bool eraseOnWrite,
+        bool fsmcEcc, bool regions, bool planes, bool skipErased,
+        uint8_t startCmd, uint8_t dataCmd, uint8_t endCmd);
     void start();
     void stop();
 signals:
     void result(int ret);
     void progress(quint64 progress);
+    void badBlock(quint64 addr, bool isSkipped);
     void log(QtMsgType msgType, QString msg);
 };
 
@@ -0,0 +1,246 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#include "zstd_seekable.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#define ZSTD_SKIPPABLE_MAGIC 0x184D2A5E
+#define ZSTD_SEEKABLE_MAGIC 0x8F92EAB1
+#define ZSTD_SKIPPABLE_HEADER_SIZE 8
+#define ZSTD_SEEK_FOOTER_SIZE 9
+#define ZSTD_SEEK_ENTRY_SIZE 8
+#define ZSTD_SEEK_CHECKSUM_FLAG 0x80
+#define ZSTD_SEEK_RESERVED_MASK 0x7C
+
+static void putLe32(QByteArray &buf, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+        buf.append(static_cast<char>((value >> (8 * i)) & 0xFF));
+}
+
+static uint32_t getLe32(const char *buf)
+{
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(buf);
+
+    return p[0] | p[1] << 8 | p[2] << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+QByteArray ZstdSeekTable::build(const std::vector<Entry> &entries)
+{
+    QByteArray buf;
+    uint32_t tableSize = static_cast<uint32_t>(entries.size()) *
+        ZSTD_SEEK_ENTRY_SIZE + ZSTD_SEEK_FOOTER_SIZE;
+
+    putLe32(buf, ZSTD_SKIPPABLE_MAGIC);
+    putLe32(buf, tableSize);
+    for (const Entry &entry : entries)
+    {
+        putLe32(buf, entry.compressedSize);
+        putLe32(buf, entry.decompressedSize);
+    }
+    putLe32(buf, static_cast<uint32_t>(entries.size()));
+    /* No checksums */
+    buf.append('\0');
+    putLe32(buf, ZSTD_SEEKABLE_MAGIC);
+
+    return buf;
+}
+
+int ZstdSeekTable::read(QFile &file, std::vector<Entry> &entries)
+{
+    qint64 fileSize = file.size(), tableSize, framesSize;
+    uint32_t frameNum, entrySize;
+    uint8_t descriptor;
+    QByteArray buf;
+
+    entries.clear();
+    if (fileSize < ZSTD_SKIPPABLE_HEADER_SIZE + ZSTD_SEEK_FOOTER_SIZE ||
+        !file.seek(fileSize - ZSTD_SEEK_FOOTER_SIZE))
+    {
+        return -1;
+    }
+
+    buf = file.read(ZSTD_SEEK_FOOTER_SIZE);
+    if (buf.size() != ZSTD_SEEK_FOOTER_SIZE ||
+        getLe32(buf.constData() + 5) != ZSTD_SEEKABLE_MAGIC)
+    {
+        return -1;
+    }
+
+    frameNum = getLe32(buf.constData());
+    descriptor = static_cast<uint8_t>(buf[4]);
+    if (descriptor & ZSTD_SEEK_RESERVED_MASK)
+        return -1;
+
+    entrySize = ZSTD_SEEK_ENTRY_SIZE +
+        (descriptor & ZSTD_SEEK_CHECKSUM_FLAG ? 4 : 0);
+    tableSize = static_cast<qint64>(frameNum) * entrySize +
+        ZSTD_SEEK_FOOTER_SIZE;
+    framesSize = fileSize - tableSize - ZSTD_SKIPPABLE_HEADER_SIZE;
+    if (framesSize < 0 || !file.seek(framesSize))
+        return -1;
+
+    buf = file.read(tableSize + ZSTD_SKIPPABLE_HEADER_SIZE);
+    if (buf.size() != tableSize + ZSTD_SKIPPABLE_HEADER_SIZE ||
+        getLe32(buf.constData()) != ZSTD_SKIPPABLE_MAGIC ||
+        getLe32(buf.constData() + 4) != tableSize)
+    {
+        return -1;
+    }
+
+    qint64 total = 0;
+    for (uint32_t i = 0; i < frameNum; i++)
+    {
+        const char *p = buf.constData() + ZSTD_SKIPPABLE_HEADER_SIZE +
+            static_cast<size_t>(i) * entrySize;
+        Entry entry = { getLe32(p), getLe32(p + 4) };
+
+        total += entry.compressedSize;
+        entries.push_back(entry);
+    }
+
+    /* Frames must cover the whole file before seek table */
+    if (total != framesSize)
+    {
+        entries.clear();
+        return -1;
+    }
+
+    return 0;
+}
+
+bool ZstdSeekTable::isSeekable(const QString &fileName)
+{
+    QFile file(fileName);
+    std::vector<Entry> entries;
+
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    return !read(file, entries);
+}
+
+#ifdef HAVE_ZSTD
+ZstdDevice::ZstdDevice()
+{
+    dataSize = 0;
+    cacheFrame = -1;
+}
+
+int ZstdDevice::setFileName(const QString &fileName)
+{
+    std::vector<ZstdSeekTable::Entry> entries;
+    quint64 frameOffset = 0;
+
+    frameOffsets.clear();
+    dataOffsets.clear();
+    frameSizes.clear();
+    dataSize = 0;
+    cacheFrame = -1;
+
+    file.close();
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qCritical() << "Failed to open file:" << fileName << ", error:"
+            << file.errorString();
+        return -1;
+    }
+
+    if (ZstdSeekTable::read(file, entries))
+    {
+        qCritical() << "File" << fileName << "has no zstd seek table";
+        file.close();
+        return -1;
+    }
+
+    for (const ZstdSeekTable::Entry &entry : entries)
+    {
+        frameOffsets.push_back(frameOffset);
+        dataOffsets.push_back(dataSize);
+        frameSizes.push_back(entry.compressedSize);
+        frameOffset += entry.compressedSize;
+        dataSize += entry.decompressedSize;
+    }
+    /* Sentinel for the end of the last frame */
+    dataOffsets.push_back(dataSize);
+
+    return 0;
+}
+
+int ZstdDevice::readFrame(size_t frame)
+{
+    QByteArray packed;
+    size_t ret;
+
+    if (!file.seek(static_cast<qint64>(frameOffsets[frame])))
+        return -1;
+
+    packed = file.read(frameSizes[frame]);
+    if (static_cast<uint32_t>(packed.size()) != frameSizes[frame])
+        return -1;
+
+    cache.resize(dataOffsets[frame + 1] - dataOffsets[frame]);
+    ret = ZSTD_decompress(cache.data(), cache.size(), packed.constData(),
+        packed.size());
+    if (ZSTD_isError(ret) || ret != cache.size())
+    {
+        qCritical() << "Zstd frame" << frame << "is corrupted";
+        cacheFrame = -1;
+        return -1;
+    }
+    cacheFrame = static_cast<qint64>(frame);
+
+    return 0;
+}
+
+qint64 ZstdDevice::readData(char *data, qint64 maxSize)
+{
+    quint64 offset = static_cast<quint64>(pos());
+    qint64 done = 0;
+
+    while (done < maxSize && offset < dataSize)
+    {
+        size_t frame = std::upper_bound(dataOffsets.begin(),
+            dataOffsets.end(), offset) - dataOffsets.begin() - 1;
+
+        if (cacheFrame != static_cast<qint64>(frame) && readFrame(frame))
+            return done ? done : -1;
+
+        quint64 frameOff = offset - dataOffsets[frame];
+        qint64 len = std::min<qint64>(maxSize - done,
+            static_cast<qint64>(cache.size() - frameOff));
+
+        memcpy(data + done, cache.data() + frameOff, len);
+        done += len;
+        offset += len;
+    }
+
+    return done;
+}
+
+qint64 ZstdDevice::writeData(const char *data, qint64 maxSize)
+{
+    (void)data;
+    (void)maxSize;
+
+    return -1;
+}
+
+bool ZstdDevice::isSequential() const
+{
+    return false;
+}
+
+qint64 ZstdDevice::size() const
+{
+    return static_cast<qint64>(dataSize);
+}
+#endif
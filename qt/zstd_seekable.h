@@ -0,0 +1,63 @@
+/*  Copyright (C) 2020 NANDO authors
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ */
+
+#ifndef ZSTD_SEEKABLE_H
+#define ZSTD_SEEKABLE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QIODevice>
+#include <QString>
+#include <cstdint>
+#include <vector>
+
+/* Seek table of zstd seekable format: independent frames followed by a
+ * skippable frame with compressed and decompressed size of each frame.
+ * Such file is still decompressed by zstd tool as usual.
+ */
+class ZstdSeekTable
+{
+public:
+    typedef struct
+    {
+        uint32_t compressedSize;
+        uint32_t decompressedSize;
+    } Entry;
+
+    static QByteArray build(const std::vector<Entry> &entries);
+    static int read(QFile &file, std::vector<Entry> &entries);
+    static bool isSeekable(const QString &fileName);
+};
+
+#ifdef HAVE_ZSTD
+/* Read only access to decompressed data of seekable zstd file, only the
+ * frame with requested data is decompressed.
+ */
+class ZstdDevice : public QIODevice
+{
+    QFile file;
+    /* Start of each frame in file and in decompressed data */
+    std::vector<quint64> frameOffsets;
+    std::vector<quint64> dataOffsets;
+    std::vector<uint32_t> frameSizes;
+    quint64 dataSize;
+    qint64 cacheFrame;
+    std::vector<uint8_t> cache;
+
+    int readFrame(size_t frame);
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+public:
+    ZstdDevice();
+    int setFileName(const QString &fileName);
+    bool isSequential() const override;
+    qint64 size() const override;
+};
+#endif
+
+#endif // ZSTD_SEEKABLE_H